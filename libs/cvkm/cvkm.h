@@ -3,12 +3,37 @@
 #define _CVKM_H_
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef CVKM_ENABLE_FLECS
 #include <flecs.h>
 #endif
 
+// Define CVKM_SIMD to implement the float vec4, quaternion and mat4 operations with SSE2 (plus SSE4.1 when enabled) or
+// 64-bit NEON, when the target has them. Everything else, and targets without either, keep using the scalar code.
+// Results can differ from the scalar code by a few ULPs where the SIMD code sums terms in a different order, which is
+// only the dot product and what's built on it. Everywhere else they match bit for bit, provided the compiler doesn't
+// contract multiplies and adds into FMAs (-ffp-contract=off). GCC does by default in GNU C modes on targets that have
+// FMA, such as AArch64, and then fuses the scalar and the SIMD code in different places.
+#ifdef CVKM_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CVKM_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define CVKM_SIMD_SSE4_1
+#include <smmintrin.h>
+#endif
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define CVKM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(CVKM_SIMD_SSE2) || defined(CVKM_SIMD_NEON)
+#define CVKM_HAS_SIMD
+#endif
+
 #if !defined(CVKM_LH) && !defined(CVKM_RH)
 #define CVKM_RH
 #endif
@@ -424,6 +449,263 @@ typedef union vkm_mat4 {
 
 #define CVKM_MAT4_IDENTITY (vkm_mat4)CVKM_MAT4_IDENTITY_INIT
 
+#ifdef CVKM_HAS_SIMD
+// Four floats in a register. The vector and matrix types are only aligned to their scalars, so loads and stores are
+// unaligned ones.
+#ifdef CVKM_SIMD_SSE2
+typedef __m128 vkm_simd_vec4;
+
+static vkm_simd_vec4 vkm_simd_load(const float* pointer) {
+  return _mm_loadu_ps(pointer);
+}
+
+static void vkm_simd_store(float* pointer, const vkm_simd_vec4 vec) {
+  _mm_storeu_ps(pointer, vec);
+}
+
+static vkm_simd_vec4 vkm_simd_splat(const float scalar) {
+  return _mm_set1_ps(scalar);
+}
+
+static vkm_simd_vec4 vkm_simd_add(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return _mm_add_ps(a, b);
+}
+
+static vkm_simd_vec4 vkm_simd_sub(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return _mm_sub_ps(a, b);
+}
+
+static vkm_simd_vec4 vkm_simd_mul(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return _mm_mul_ps(a, b);
+}
+
+static vkm_simd_vec4 vkm_simd_div(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return _mm_div_ps(a, b);
+}
+
+// Same as a < b ? a : b per lane, like the scalar code.
+static vkm_simd_vec4 vkm_simd_min(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return _mm_min_ps(a, b);
+}
+
+// Same as a > b ? a : b per lane, like the scalar code.
+static vkm_simd_vec4 vkm_simd_max(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return _mm_max_ps(a, b);
+}
+
+static float vkm_simd_dot(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+#ifdef CVKM_SIMD_SSE4_1
+  return _mm_cvtss_f32(_mm_dp_ps(a, b, 0xf1));
+#else
+  const __m128 products = _mm_mul_ps(a, b);
+  const __m128 pair_sums = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtss_f32(_mm_add_ss(pair_sums, _mm_movehl_ps(pair_sums, pair_sums)));
+#endif
+}
+
+// Lane shuffles used by the quaternion product, named after the resulting order.
+static vkm_simd_vec4 vkm_simd_wzyx(const vkm_simd_vec4 vec) {
+  return _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static vkm_simd_vec4 vkm_simd_zwxy(const vkm_simd_vec4 vec) {
+  return _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static vkm_simd_vec4 vkm_simd_yxwz(const vkm_simd_vec4 vec) {
+  return _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static vkm_simd_vec4 vkm_simd_sqrt(const vkm_simd_vec4 vec) {
+  return _mm_sqrt_ps(vec);
+}
+
+// Lanes that are > 0 are kept, the others become 1.
+static vkm_simd_vec4 vkm_simd_positive_or_one(const vkm_simd_vec4 vec) {
+  const __m128 positive = _mm_cmpgt_ps(vec, _mm_setzero_ps());
+  return _mm_or_ps(_mm_and_ps(positive, vec), _mm_andnot_ps(positive, _mm_set1_ps(1.0f)));
+}
+
+// Bit i is set if lane i is < 0.
+static int vkm_simd_negative_mask(const vkm_simd_vec4 vec) {
+  return _mm_movemask_ps(_mm_cmplt_ps(vec, _mm_setzero_ps()));
+}
+
+static vkm_simd_vec4 vkm_simd_abs(const vkm_simd_vec4 vec) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), vec);
+}
+
+// a > b ? if_greater : otherwise, per lane.
+static vkm_simd_vec4 vkm_simd_select_greater(
+  const vkm_simd_vec4 a,
+  const vkm_simd_vec4 b,
+  const vkm_simd_vec4 if_greater,
+  const vkm_simd_vec4 otherwise
+) {
+  const __m128 greater = _mm_cmpgt_ps(a, b);
+  return _mm_or_ps(_mm_and_ps(greater, if_greater), _mm_andnot_ps(greater, otherwise));
+}
+
+static vkm_simd_vec4 vkm_simd_copysign(const vkm_simd_vec4 magnitude, const vkm_simd_vec4 sign) {
+  const __m128 sign_bit = _mm_set1_ps(-0.0f);
+  return _mm_or_ps(_mm_andnot_ps(sign_bit, magnitude), _mm_and_ps(sign_bit, sign));
+}
+
+// Quadrant fix-up of vkm_sincos_fast, quadrants being the low bits of the lanes of shifted.
+static void vkm_simd_sincos_quadrant(
+  const vkm_simd_vec4 shifted,
+  const vkm_simd_vec4 r_sine,
+  const vkm_simd_vec4 r_cosine,
+  vkm_simd_vec4* sine,
+  vkm_simd_vec4* cosine
+) {
+  const __m128i quadrant = _mm_castps_si128(shifted);
+  const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+  const __m128 odd = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+  const __m128 quadrant_sine = _mm_or_ps(_mm_and_ps(odd, r_cosine), _mm_andnot_ps(odd, r_sine));
+  const __m128 quadrant_cosine = _mm_or_ps(_mm_and_ps(odd, r_sine), _mm_andnot_ps(odd, r_cosine));
+  const __m128i sine_sign = _mm_slli_epi32(_mm_and_si128(quadrant, two), 30);
+  const __m128i cosine_sign = _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30);
+  *sine = _mm_xor_ps(quadrant_sine, _mm_castsi128_ps(sine_sign));
+  *cosine = _mm_xor_ps(quadrant_cosine, _mm_castsi128_ps(cosine_sign));
+}
+
+static void vkm_simd_transpose(const float* matrix, float* result) {
+  __m128 column0 = _mm_loadu_ps(matrix), column1 = _mm_loadu_ps(matrix + 4);
+  __m128 column2 = _mm_loadu_ps(matrix + 8), column3 = _mm_loadu_ps(matrix + 12);
+  _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+  _mm_storeu_ps(result, column0);
+  _mm_storeu_ps(result + 4, column1);
+  _mm_storeu_ps(result + 8, column2);
+  _mm_storeu_ps(result + 12, column3);
+}
+#elif defined(CVKM_SIMD_NEON)
+typedef float32x4_t vkm_simd_vec4;
+
+static vkm_simd_vec4 vkm_simd_load(const float* pointer) {
+  return vld1q_f32(pointer);
+}
+
+static void vkm_simd_store(float* pointer, const vkm_simd_vec4 vec) {
+  vst1q_f32(pointer, vec);
+}
+
+static vkm_simd_vec4 vkm_simd_splat(const float scalar) {
+  return vdupq_n_f32(scalar);
+}
+
+static vkm_simd_vec4 vkm_simd_add(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vaddq_f32(a, b);
+}
+
+static vkm_simd_vec4 vkm_simd_sub(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vsubq_f32(a, b);
+}
+
+static vkm_simd_vec4 vkm_simd_mul(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vmulq_f32(a, b);
+}
+
+static vkm_simd_vec4 vkm_simd_div(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vdivq_f32(a, b);
+}
+
+// Same as a < b ? a : b per lane, like the scalar code (vminq_f32 would propagate NaNs instead).
+static vkm_simd_vec4 vkm_simd_min(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vbslq_f32(vcltq_f32(a, b), a, b);
+}
+
+// Same as a > b ? a : b per lane, like the scalar code.
+static vkm_simd_vec4 vkm_simd_max(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vbslq_f32(vcgtq_f32(a, b), a, b);
+}
+
+static float vkm_simd_dot(const vkm_simd_vec4 a, const vkm_simd_vec4 b) {
+  return vaddvq_f32(vmulq_f32(a, b));
+}
+
+// Lane shuffles used by the quaternion product, named after the resulting order.
+static vkm_simd_vec4 vkm_simd_wzyx(const vkm_simd_vec4 vec) {
+  return vrev64q_f32(vextq_f32(vec, vec, 2));
+}
+
+static vkm_simd_vec4 vkm_simd_zwxy(const vkm_simd_vec4 vec) {
+  return vextq_f32(vec, vec, 2);
+}
+
+static vkm_simd_vec4 vkm_simd_yxwz(const vkm_simd_vec4 vec) {
+  return vrev64q_f32(vec);
+}
+
+static vkm_simd_vec4 vkm_simd_sqrt(const vkm_simd_vec4 vec) {
+  return vsqrtq_f32(vec);
+}
+
+// Lanes that are > 0 are kept, the others become 1.
+static vkm_simd_vec4 vkm_simd_positive_or_one(const vkm_simd_vec4 vec) {
+  return vbslq_f32(vcgtzq_f32(vec), vec, vdupq_n_f32(1.0f));
+}
+
+// Bit i is set if lane i is < 0.
+static int vkm_simd_negative_mask(const vkm_simd_vec4 vec) {
+  static const uint32_t lane_bits[4] = { 1, 2, 4, 8 };
+  return (int)vaddvq_u32(vandq_u32(vcltzq_f32(vec), vld1q_u32(lane_bits)));
+}
+
+static vkm_simd_vec4 vkm_simd_abs(const vkm_simd_vec4 vec) {
+  return vabsq_f32(vec);
+}
+
+// a > b ? if_greater : otherwise, per lane.
+static vkm_simd_vec4 vkm_simd_select_greater(
+  const vkm_simd_vec4 a,
+  const vkm_simd_vec4 b,
+  const vkm_simd_vec4 if_greater,
+  const vkm_simd_vec4 otherwise
+) {
+  return vbslq_f32(vcgtq_f32(a, b), if_greater, otherwise);
+}
+
+static vkm_simd_vec4 vkm_simd_copysign(const vkm_simd_vec4 magnitude, const vkm_simd_vec4 sign) {
+  return vbslq_f32(vdupq_n_u32(0x80000000u), sign, magnitude);
+}
+
+// Quadrant fix-up of vkm_sincos_fast, quadrants being the low bits of the lanes of shifted.
+static void vkm_simd_sincos_quadrant(
+  const vkm_simd_vec4 shifted,
+  const vkm_simd_vec4 r_sine,
+  const vkm_simd_vec4 r_cosine,
+  vkm_simd_vec4* sine,
+  vkm_simd_vec4* cosine
+) {
+  const uint32x4_t quadrant = vreinterpretq_u32_f32(shifted);
+  const uint32x4_t one = vdupq_n_u32(1), two = vdupq_n_u32(2);
+  const uint32x4_t odd = vtstq_u32(quadrant, one);
+  const uint32x4_t quadrant_sine = vreinterpretq_u32_f32(vbslq_f32(odd, r_cosine, r_sine));
+  const uint32x4_t quadrant_cosine = vreinterpretq_u32_f32(vbslq_f32(odd, r_sine, r_cosine));
+  const uint32x4_t sine_sign = vshlq_n_u32(vandq_u32(quadrant, two), 30);
+  const uint32x4_t cosine_sign = vshlq_n_u32(vandq_u32(vaddq_u32(quadrant, one), two), 30);
+  *sine = vreinterpretq_f32_u32(veorq_u32(quadrant_sine, sine_sign));
+  *cosine = vreinterpretq_f32_u32(veorq_u32(quadrant_cosine, cosine_sign));
+}
+
+static void vkm_simd_transpose(const float* matrix, float* result) {
+  // De-interleaving load, every fourth float ends up in the same register.
+  const float32x4x4_t rows = vld4q_f32(matrix);
+  vst1q_f32(result, rows.val[0]);
+  vst1q_f32(result + 4, rows.val[1]);
+  vst1q_f32(result + 8, rows.val[2]);
+  vst1q_f32(result + 12, rows.val[3]);
+}
+#endif
+
+// No fused multiply-add on purpose, so results match the scalar code wherever the order of operations is the same. That
+// doesn't stop the compiler from contracting it, see CVKM_SIMD above.
+static vkm_simd_vec4 vkm_simd_muladd(const vkm_simd_vec4 a, const vkm_simd_vec4 b, const vkm_simd_vec4 c) {
+  return vkm_simd_add(vkm_simd_mul(a, b), c);
+}
+#endif
+
 #define CVKM_VEC2_OPERATION(type, operation, operator) static void vkm_##type##_##operation(\
   const vkm_##type* a,\
   const vkm_##type* b,\
@@ -600,10 +882,59 @@ CVKM_VEC4_ALL_OPERATIONS(ivec4, int32_t)
 CVKM_VEC4_ALL_OPERATIONS(uvec4, uint32_t)
 CVKM_VEC4_ALL_OPERATIONS(lvec4, int64_t)
 CVKM_VEC4_ALL_OPERATIONS(ulvec4, uint64_t)
+#ifdef CVKM_HAS_SIMD
+#define CVKM_VEC4_SIMD_OPERATION(operation) static void vkm_vec4_##operation(\
+  const vkm_vec4* a,\
+  const vkm_vec4* b,\
+  vkm_vec4* result\
+) {\
+  vkm_simd_store(result->raw, vkm_simd_##operation(vkm_simd_load(a->raw), vkm_simd_load(b->raw)));\
+}\
+\
+static void vkm_vec4_##operation##_scalar(const vkm_vec4* vec, const float scalar, vkm_vec4* result) {\
+  vkm_simd_store(result->raw, vkm_simd_##operation(vkm_simd_load(vec->raw), vkm_simd_splat(scalar)));\
+}
+
+CVKM_VEC4_SIMD_OPERATION(add)
+CVKM_VEC4_SIMD_OPERATION(sub)
+CVKM_VEC4_SIMD_OPERATION(mul)
+CVKM_VEC4_SIMD_OPERATION(div)
+
+static void vkm_vec4_muladd(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result) {
+  vkm_simd_store(
+    result->raw,
+    vkm_simd_muladd(vkm_simd_load(a->raw), vkm_simd_load(b->raw), vkm_simd_load(result->raw))
+  );
+}
+
+static void vkm_vec4_muladd_scalar(const vkm_vec4* vector, const float scalar, vkm_vec4* result) {
+  vkm_simd_store(
+    result->raw,
+    vkm_simd_muladd(vkm_simd_load(vector->raw), vkm_simd_splat(scalar), vkm_simd_load(result->raw))
+  );
+}
+#else
 CVKM_VEC4_ALL_OPERATIONS(vec4, float)
+#endif
 CVKM_VEC4_ALL_OPERATIONS(dvec4, double)
 
 static void vkm_quat_mul(const vkm_quat* p, const vkm_quat* q, vkm_quat* result) {
+#ifdef CVKM_HAS_SIMD
+  // Each component of p scales q with its lanes shuffled and some of them negated.
+  static const float x_signs[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+  static const float y_signs[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+  static const float z_signs[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+  const vkm_simd_vec4 q_vec = vkm_simd_load(q->raw);
+  const vkm_simd_vec4 x_term = vkm_simd_mul(vkm_simd_wzyx(q_vec), vkm_simd_load(x_signs));
+  const vkm_simd_vec4 y_term = vkm_simd_mul(vkm_simd_zwxy(q_vec), vkm_simd_load(y_signs));
+  const vkm_simd_vec4 z_term = vkm_simd_mul(vkm_simd_yxwz(q_vec), vkm_simd_load(z_signs));
+
+  vkm_simd_vec4 product = vkm_simd_mul(vkm_simd_splat(p->w), q_vec);
+  product = vkm_simd_muladd(vkm_simd_splat(p->x), x_term, product);
+  product = vkm_simd_muladd(vkm_simd_splat(p->y), y_term, product);
+  product = vkm_simd_muladd(vkm_simd_splat(p->z), z_term, product);
+  vkm_simd_store(result->raw, product);
+#else
   const vkm_quat p_copy = *p;
   const vkm_quat q_copy = *q;
 
@@ -611,6 +942,7 @@ static void vkm_quat_mul(const vkm_quat* p, const vkm_quat* q, vkm_quat* result)
   result->y = p_copy.w * q_copy.y - p_copy.x * q_copy.z + p_copy.y * q_copy.w + p_copy.z * q_copy.x;
   result->z = p_copy.w * q_copy.z + p_copy.x * q_copy.y - p_copy.y * q_copy.x + p_copy.z * q_copy.w;
   result->w = p_copy.w * q_copy.w - p_copy.x * q_copy.x - p_copy.y * q_copy.y - p_copy.z * q_copy.z;
+#endif
 }
 
 #define CVKM_BASIC_OPERATIONS(vec_type, scalar_type, operation, b) vkm_##vec_type*: _Generic(b,\
@@ -815,6 +1147,113 @@ static double vkm_inverse_sqrtd(const double x) {
   return 1.0 / sqrt(x);
 }
 
+// Approximations for hot paths where speed matters more than the last bits: no libm calls, no branches on the input
+// and the batch versions below evaluate the same expressions in the same order. Max errors, measured against
+// libm in double precision:
+// - vkm_sin_fast, vkm_cos_fast and vkm_sincos_fast: 1e-7 absolute for |angle| <= 8192, growing slowly beyond.
+// - vkm_atan2_fast: 2e-6 radians. atan2(0, 0) is 0.
+// - vkm_inverse_sqrt_fast: 3e-7 relative with SIMD, 5e-6 without.
+
+// Adding 1.5 * 2^23 to a float of magnitude below 2^22 rounds it to the nearest integer, which is then also readable
+// from the low bits of the sum.
+#define CVKM_ROUND_MAGIC_F 12582912.0f
+
+// pi/2 split in three parts (Cody-Waite), so that multiples of it can be subtracted without losing precision.
+#define CVKM_PI_2_PART1_F 1.5703125f
+#define CVKM_PI_2_PART2_F 4.837512969970703125e-4f
+#define CVKM_PI_2_PART3_F 7.54978995489188216e-8f
+
+// Minimax polynomials for sine and cosine over [-pi/4, pi/4], from Cephes.
+static float vkm_sin_polynomial(const float r, const float r2) {
+  return r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+}
+
+static float vkm_cos_polynomial(const float r2) {
+  const float terms = 4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f);
+  return 1.0f - 0.5f * r2 + r2 * r2 * terms;
+}
+
+// Minimax polynomial for atan over [0, 1].
+static float vkm_atan_polynomial(const float t, const float t2) {
+  const float terms = 0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f));
+  return t * (0.99997726f + t2 * (-0.33262347f + t2 * terms));
+}
+
+static void vkm_sincos_fast(const float angle, float* sine, float* cosine) {
+  // Find the nearest multiple of pi/2 and evaluate the polynomials on what's left.
+  const union {
+    float f;
+    uint32_t u;
+  } shifted = { .f = angle * CVKM_2_PI_F + CVKM_ROUND_MAGIC_F };
+  const uint32_t quadrant = shifted.u;
+  const float multiple = shifted.f - CVKM_ROUND_MAGIC_F;
+  const float r = angle - multiple * CVKM_PI_2_PART1_F - multiple * CVKM_PI_2_PART2_F - multiple * CVKM_PI_2_PART3_F;
+  const float r2 = r * r;
+  const float r_sine = vkm_sin_polynomial(r, r2), r_cosine = vkm_cos_polynomial(r2);
+
+  // Every quarter turn swaps sine and cosine, every half turn flips their signs. Done on the bits, since branches on
+  // the quadrant are mispredicted half of the time.
+  const uint32_t swap = 0u - (quadrant & 1);
+  union {
+    float f;
+    uint32_t u;
+  } sine_bits = { .f = r_sine }, cosine_bits = { .f = r_cosine };
+  const uint32_t swapped = (sine_bits.u ^ cosine_bits.u) & swap;
+  sine_bits.u ^= swapped ^ (quadrant & 2) << 30;
+  cosine_bits.u ^= swapped ^ ((quadrant + 1) & 2) << 30;
+  *sine = sine_bits.f;
+  *cosine = cosine_bits.f;
+}
+
+static float vkm_sin_fast(const float angle) {
+  float sine, cosine;
+  vkm_sincos_fast(angle, &sine, &cosine);
+  return sine;
+}
+
+static float vkm_cos_fast(const float angle) {
+  float sine, cosine;
+  vkm_sincos_fast(angle, &sine, &cosine);
+  return cosine;
+}
+
+static float vkm_atan2_fast(const float y, const float x) {
+  const float abs_x = fabsf(x), abs_y = fabsf(y);
+  const float max = abs_y > abs_x ? abs_y : abs_x, min = abs_y > abs_x ? abs_x : abs_y;
+  const float t = min / (max > 0.0f ? max : 1.0f);
+  float angle = vkm_atan_polynomial(t, t * t);
+  angle = abs_y > abs_x ? CVKM_PI_2_F - angle : angle;
+  angle = 0.0f > x ? CVKM_PI_F - angle : angle;
+  return copysignf(angle, y);
+}
+
+static float vkm_inverse_sqrt_fast(const float x) {
+#ifdef CVKM_SIMD_SSE2
+  // Hardware estimate good to 12 bits, refined by one Newton-Raphson step.
+  const __m128 vec = _mm_set_ss(x);
+  const __m128 estimate = _mm_rsqrt_ss(vec);
+  const __m128 estimate_sqr_x = _mm_mul_ss(_mm_mul_ss(estimate, estimate), vec);
+  const __m128 half_estimate = _mm_mul_ss(_mm_set_ss(0.5f), estimate);
+  return _mm_cvtss_f32(_mm_mul_ss(half_estimate, _mm_sub_ss(_mm_set_ss(3.0f), estimate_sqr_x)));
+#elif defined(CVKM_SIMD_NEON)
+  const float32x2_t vec = vdup_n_f32(x);
+  float32x2_t estimate = vrsqrte_f32(vec);
+  estimate = vmul_f32(estimate, vrsqrts_f32(vmul_f32(vec, estimate), estimate));
+  return vget_lane_f32(vmul_f32(estimate, vrsqrts_f32(vmul_f32(vec, estimate), estimate)), 0);
+#else
+  // Bit level estimate, refined by two Newton-Raphson steps.
+  union {
+    float f;
+    uint32_t u;
+  } estimate = { .f = x };
+  estimate.u = 0x5f375a86u - (estimate.u >> 1);
+  const float half_x = 0.5f * x;
+  estimate.f *= 1.5f - half_x * estimate.f * estimate.f;
+  estimate.f *= 1.5f - half_x * estimate.f * estimate.f;
+  return estimate.f;
+#endif
+}
+
 #define CVKM_MIN_OPERATION(type, suffix) static type vkm_min##suffix(const type a, const type b) {\
   return a < b ? a : b;\
 }
@@ -1057,7 +1496,13 @@ CVKM_VEC4_MIN_OPERATION(vkm_ivec4)
 CVKM_VEC4_MIN_OPERATION(vkm_uvec4)
 CVKM_VEC4_MIN_OPERATION(vkm_lvec4)
 CVKM_VEC4_MIN_OPERATION(vkm_ulvec4)
+#ifdef CVKM_HAS_SIMD
+static void vkm_vec4_min(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result) {
+  vkm_simd_store(result->raw, vkm_simd_min(vkm_simd_load(a->raw), vkm_simd_load(b->raw)));
+}
+#else
 CVKM_VEC4_MIN_OPERATION(vkm_vec4)
+#endif
 CVKM_VEC4_MIN_OPERATION(vkm_dvec4)
 CVKM_VEC4_MIN_OPERATION(vkm_quat)
 
@@ -1136,7 +1581,13 @@ CVKM_VEC4_MAX_OPERATION(vkm_ivec4)
 CVKM_VEC4_MAX_OPERATION(vkm_uvec4)
 CVKM_VEC4_MAX_OPERATION(vkm_lvec4)
 CVKM_VEC4_MAX_OPERATION(vkm_ulvec4)
+#ifdef CVKM_HAS_SIMD
+static void vkm_vec4_max(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result) {
+  vkm_simd_store(result->raw, vkm_simd_max(vkm_simd_load(a->raw), vkm_simd_load(b->raw)));
+}
+#else
 CVKM_VEC4_MAX_OPERATION(vkm_vec4)
+#endif
 CVKM_VEC4_MAX_OPERATION(vkm_dvec4)
 CVKM_VEC4_MAX_OPERATION(vkm_quat)
 
@@ -1848,7 +2299,7 @@ CVKM_VEC3_MISC_OPERATIONS_FOR_UNSIGNED_INTS(ulvec3, uint64_t)
 CVKM_VEC3_MISC_OPERATIONS(vec3, float)
 CVKM_VEC3_MISC_OPERATIONS(dvec3, double)
 
-#define CVKM_VEC4_MISC_OPERATIONS_FOR_UNSIGNED_INTS(vec_type, scalar_type) static scalar_type vkm_##vec_type##_dot(\
+#define CVKM_VEC4_DOT_OPERATIONS(vec_type, scalar_type) static scalar_type vkm_##vec_type##_dot(\
   const vkm_##vec_type* a,\
   const vkm_##vec_type* b\
 ) {\
@@ -1857,9 +2308,11 @@ CVKM_VEC3_MISC_OPERATIONS(dvec3, double)
 \
 static scalar_type vkm_##vec_type##_sqr_magnitude(const vkm_##vec_type* vec) {\
   return vec->x * vec->x + vec->y * vec->y + vec->z * vec->z + vec->w * vec->w;\
-}\
-\
-static scalar_type vkm_##vec_type##_magnitude(const vkm_##vec_type* vec) {\
+}
+
+#define CVKM_VEC4_LENGTH_OPERATIONS(vec_type, scalar_type) static scalar_type vkm_##vec_type##_magnitude(\
+  const vkm_##vec_type* vec\
+) {\
   return vkm_sqrt(vkm_##vec_type##_sqr_magnitude(vec));\
 }\
 \
@@ -1867,6 +2320,10 @@ static void vkm_##vec_type##_clear(vkm_##vec_type* vec) {\
   *vec = (vkm_##vec_type){ { (scalar_type)0, (scalar_type)0, (scalar_type)0, (scalar_type)0 } };\
 }
 
+#define CVKM_VEC4_MISC_OPERATIONS_FOR_UNSIGNED_INTS(vec_type, scalar_type)\
+  CVKM_VEC4_DOT_OPERATIONS(vec_type, scalar_type)\
+  CVKM_VEC4_LENGTH_OPERATIONS(vec_type, scalar_type)
+
 #define CVKM_VEC4_INVERT(vec_type) static void vkm_##vec_type##_invert(\
   const vkm_##vec_type* vec,\
   vkm_##vec_type* result\
@@ -1900,7 +2357,22 @@ CVKM_VEC4_MISC_OPERATIONS_FOR_INTS(ivec4, int32_t)
 CVKM_VEC4_MISC_OPERATIONS_FOR_UNSIGNED_INTS(uvec4, uint32_t)
 CVKM_VEC4_MISC_OPERATIONS_FOR_INTS(lvec4, int64_t)
 CVKM_VEC4_MISC_OPERATIONS_FOR_UNSIGNED_INTS(ulvec4, uint64_t)
+#ifdef CVKM_HAS_SIMD
+static float vkm_vec4_dot(const vkm_vec4* a, const vkm_vec4* b) {
+  return vkm_simd_dot(vkm_simd_load(a->raw), vkm_simd_load(b->raw));
+}
+
+static float vkm_vec4_sqr_magnitude(const vkm_vec4* vec) {
+  const vkm_simd_vec4 vec_simd = vkm_simd_load(vec->raw);
+  return vkm_simd_dot(vec_simd, vec_simd);
+}
+
+CVKM_VEC4_LENGTH_OPERATIONS(vec4, float)
+CVKM_VEC4_INVERT(vec4)
+CVKM_VEC4_NORMALIZE(vec4, float)
+#else
 CVKM_VEC4_MISC_OPERATIONS(vec4, float)
+#endif
 CVKM_VEC4_MISC_OPERATIONS(dvec4, double)
 
 static float vkm_quat_sqr_magnitude(const vkm_quat* quaternion) {
@@ -1951,12 +2423,16 @@ static void vkm_mat3_transpose(const vkm_mat3* mat, vkm_mat3* result) {
 }
 
 static void vkm_mat4_transpose(const vkm_mat4* mat, vkm_mat4* result) {
+#ifdef CVKM_HAS_SIMD
+  vkm_simd_transpose(mat->raw, result->raw);
+#else
   *result = (vkm_mat4){
     .m00 = mat->m00, .m01 = mat->m10, .m02 = mat->m20, .m03 = mat->m30,
     .m10 = mat->m01, .m11 = mat->m11, .m12 = mat->m21, .m13 = mat->m31,
     .m20 = mat->m02, .m21 = mat->m12, .m22 = mat->m22, .m23 = mat->m32,
     .m30 = mat->m03, .m31 = mat->m13, .m32 = mat->m23, .m33 = mat->m33,
   };
+#endif
 }
 
 #define vkm_dot(a, ...) _Generic(a,\
@@ -2811,7 +3287,31 @@ static void vkm_perspective_rh_no(
 #define vkm_perspective vkm_perspective_rh_no
 #endif
 
+#ifdef CVKM_HAS_SIMD
+// Column i of the product is the columns of a weighted by column i of b, columns of b being counted up to count.
+static vkm_simd_vec4 vkm_simd_mat4_column(const vkm_simd_vec4 a_columns[4], const float* b_column, const int count) {
+  vkm_simd_vec4 column = vkm_simd_mul(a_columns[0], vkm_simd_splat(b_column[0]));
+  for (int i = 1; i < count; i++) {
+    column = vkm_simd_muladd(a_columns[i], vkm_simd_splat(b_column[i]), column);
+  }
+  return column;
+}
+
+static void vkm_simd_mat4_load(const vkm_mat4* mat, vkm_simd_vec4 columns[4]) {
+  for (int i = 0; i < 4; i++) {
+    columns[i] = vkm_simd_load(mat->columns[i].raw);
+  }
+}
+#endif
+
 static void vkm_mat4_mul(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result) {
+#ifdef CVKM_HAS_SIMD
+  vkm_simd_vec4 a_columns[4];
+  vkm_simd_mat4_load(a, a_columns);
+  for (int i = 0; i < 4; i++) {
+    vkm_simd_store(result->columns[i].raw, vkm_simd_mat4_column(a_columns, b->columns[i].raw, 4));
+  }
+#else
   const vkm_mat4 a_copy = *a, b_copy = *b;
 
   result->m00 = a_copy.m00 * b_copy.m00 + a_copy.m10 * b_copy.m01 + a_copy.m20 * b_copy.m02 + a_copy.m30 * b_copy.m03;
@@ -2833,9 +3333,17 @@ static void vkm_mat4_mul(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result)
   result->m31 = a_copy.m01 * b_copy.m30 + a_copy.m11 * b_copy.m31 + a_copy.m21 * b_copy.m32 + a_copy.m31 * b_copy.m33;
   result->m32 = a_copy.m02 * b_copy.m30 + a_copy.m12 * b_copy.m31 + a_copy.m22 * b_copy.m32 + a_copy.m32 * b_copy.m33;
   result->m33 = a_copy.m03 * b_copy.m30 + a_copy.m13 * b_copy.m31 + a_copy.m23 * b_copy.m32 + a_copy.m33 * b_copy.m33;
+#endif
 }
 
 static void vkm_mat4_mul_transform(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result) {
+#ifdef CVKM_HAS_SIMD
+  vkm_simd_vec4 a_columns[4];
+  vkm_simd_mat4_load(a, a_columns);
+  for (int i = 0; i < 4; i++) {
+    vkm_simd_store(result->columns[i].raw, vkm_simd_mat4_column(a_columns, b->columns[i].raw, i == 3 ? 4 : 3));
+  }
+#else
   const vkm_mat4 a_copy = *a, b_copy = *b;
 
   result->m00 = a_copy.m00 * b_copy.m00 + a_copy.m10 * b_copy.m01 + a_copy.m20 * b_copy.m02;
@@ -2857,9 +3365,18 @@ static void vkm_mat4_mul_transform(const vkm_mat4* a, const vkm_mat4* b, vkm_mat
   result->m31 = a_copy.m01 * b_copy.m30 + a_copy.m11 * b_copy.m31 + a_copy.m21 * b_copy.m32 + a_copy.m31 * b_copy.m33;
   result->m32 = a_copy.m02 * b_copy.m30 + a_copy.m12 * b_copy.m31 + a_copy.m22 * b_copy.m32 + a_copy.m32 * b_copy.m33;
   result->m33 = a_copy.m03 * b_copy.m30 + a_copy.m13 * b_copy.m31 + a_copy.m23 * b_copy.m32 + a_copy.m33 * b_copy.m33;
+#endif
 }
 
 static void vkm_mat4_mul_rotation(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result) {
+#ifdef CVKM_HAS_SIMD
+  vkm_simd_vec4 a_columns[4];
+  vkm_simd_mat4_load(a, a_columns);
+  for (int i = 0; i < 3; i++) {
+    vkm_simd_store(result->columns[i].raw, vkm_simd_mat4_column(a_columns, b->columns[i].raw, 3));
+  }
+  vkm_simd_store(result->columns[3].raw, a_columns[3]);
+#else
   const vkm_mat4 a_copy = *a;
   const float
     b00 = b->m00, b01 = b->m01, b02 = b->m02,
@@ -2885,6 +3402,7 @@ static void vkm_mat4_mul_rotation(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4
   result->m31 = a_copy.m31;
   result->m32 = a_copy.m32;
   result->m33 = a_copy.m33;
+#endif
 }
 
 static void vkm_quat_make_rotation(const float angle, const vkm_vec3* axis, vkm_versor* result) {
@@ -3255,6 +3773,345 @@ typedef vkm_vec3 Gravity3D;
 typedef vkm_vec4 Gravity4D;
 typedef float GravityScale;
 
+// Batch functions, for running the same operation over many items at once. They take structures of arrays so that
+// each SIMD lane gets one item and no shuffling is needed. Input and output may be the same arrays, but must not
+// partially overlap.
+typedef struct vkm_vec3_soa {
+  float* x;
+  float* y;
+  float* z;
+} vkm_vec3_soa;
+
+#ifdef CVKM_HAS_SIMD
+#define CVKM_BATCH_WIDTH 4
+#else
+#define CVKM_BATCH_WIDTH 1
+#endif
+
+// Transforms points by an affine matrix, as if their w was 1. The bottom row of the matrix is ignored.
+static void vkm_batch_transform_points(
+  const vkm_mat4* matrix,
+  const vkm_vec3_soa* points,
+  const vkm_vec3_soa* result,
+  const size_t count
+) {
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  const vkm_simd_vec4
+    m00 = vkm_simd_splat(matrix->m00), m01 = vkm_simd_splat(matrix->m01), m02 = vkm_simd_splat(matrix->m02),
+    m10 = vkm_simd_splat(matrix->m10), m11 = vkm_simd_splat(matrix->m11), m12 = vkm_simd_splat(matrix->m12),
+    m20 = vkm_simd_splat(matrix->m20), m21 = vkm_simd_splat(matrix->m21), m22 = vkm_simd_splat(matrix->m22),
+    m30 = vkm_simd_splat(matrix->m30), m31 = vkm_simd_splat(matrix->m31), m32 = vkm_simd_splat(matrix->m32);
+  for (; i + CVKM_BATCH_WIDTH <= count; i += CVKM_BATCH_WIDTH) {
+    const vkm_simd_vec4 x = vkm_simd_load(points->x + i), y = vkm_simd_load(points->y + i);
+    const vkm_simd_vec4 z = vkm_simd_load(points->z + i);
+    vkm_simd_store(result->x + i, vkm_simd_muladd(m20, z, vkm_simd_muladd(m10, y, vkm_simd_muladd(m00, x, m30))));
+    vkm_simd_store(result->y + i, vkm_simd_muladd(m21, z, vkm_simd_muladd(m11, y, vkm_simd_muladd(m01, x, m31))));
+    vkm_simd_store(result->z + i, vkm_simd_muladd(m22, z, vkm_simd_muladd(m12, y, vkm_simd_muladd(m02, x, m32))));
+  }
+#endif
+  for (; i < count; i++) {
+    const float x = points->x[i], y = points->y[i], z = points->z[i];
+    result->x[i] = matrix->m20 * z + (matrix->m10 * y + (matrix->m00 * x + matrix->m30));
+    result->y[i] = matrix->m21 * z + (matrix->m11 * y + (matrix->m01 * x + matrix->m31));
+    result->z[i] = matrix->m22 * z + (matrix->m12 * y + (matrix->m02 * x + matrix->m32));
+  }
+}
+
+// Transforms axis aligned boxes by an affine matrix, giving the axis aligned boxes enclosing the results. Works on the
+// center and the extents of each box, so it costs about two point transforms instead of eight.
+static void vkm_batch_transform_aabbs(
+  const vkm_mat4* matrix,
+  const vkm_vec3_soa* mins,
+  const vkm_vec3_soa* maxs,
+  const vkm_vec3_soa* result_mins,
+  const vkm_vec3_soa* result_maxs,
+  const size_t count
+) {
+  // The extents only get rotated and scaled, and in the worst direction.
+  const float
+    a00 = fabsf(matrix->m00), a01 = fabsf(matrix->m01), a02 = fabsf(matrix->m02),
+    a10 = fabsf(matrix->m10), a11 = fabsf(matrix->m11), a12 = fabsf(matrix->m12),
+    a20 = fabsf(matrix->m20), a21 = fabsf(matrix->m21), a22 = fabsf(matrix->m22);
+
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  const vkm_simd_vec4
+    m00 = vkm_simd_splat(matrix->m00), m01 = vkm_simd_splat(matrix->m01), m02 = vkm_simd_splat(matrix->m02),
+    m10 = vkm_simd_splat(matrix->m10), m11 = vkm_simd_splat(matrix->m11), m12 = vkm_simd_splat(matrix->m12),
+    m20 = vkm_simd_splat(matrix->m20), m21 = vkm_simd_splat(matrix->m21), m22 = vkm_simd_splat(matrix->m22),
+    m30 = vkm_simd_splat(matrix->m30), m31 = vkm_simd_splat(matrix->m31), m32 = vkm_simd_splat(matrix->m32),
+    e00 = vkm_simd_splat(a00), e01 = vkm_simd_splat(a01), e02 = vkm_simd_splat(a02),
+    e10 = vkm_simd_splat(a10), e11 = vkm_simd_splat(a11), e12 = vkm_simd_splat(a12),
+    e20 = vkm_simd_splat(a20), e21 = vkm_simd_splat(a21), e22 = vkm_simd_splat(a22),
+    half = vkm_simd_splat(0.5f);
+  for (; i + CVKM_BATCH_WIDTH <= count; i += CVKM_BATCH_WIDTH) {
+    const vkm_simd_vec4 min_x = vkm_simd_load(mins->x + i), max_x = vkm_simd_load(maxs->x + i);
+    const vkm_simd_vec4 min_y = vkm_simd_load(mins->y + i), max_y = vkm_simd_load(maxs->y + i);
+    const vkm_simd_vec4 min_z = vkm_simd_load(mins->z + i), max_z = vkm_simd_load(maxs->z + i);
+    const vkm_simd_vec4
+      center_x = vkm_simd_mul(vkm_simd_add(min_x, max_x), half),
+      center_y = vkm_simd_mul(vkm_simd_add(min_y, max_y), half),
+      center_z = vkm_simd_mul(vkm_simd_add(min_z, max_z), half),
+      extent_x = vkm_simd_mul(vkm_simd_sub(max_x, min_x), half),
+      extent_y = vkm_simd_mul(vkm_simd_sub(max_y, min_y), half),
+      extent_z = vkm_simd_mul(vkm_simd_sub(max_z, min_z), half);
+
+    const vkm_simd_vec4
+      x = vkm_simd_muladd(m20, center_z, vkm_simd_muladd(m10, center_y, vkm_simd_muladd(m00, center_x, m30))),
+      y = vkm_simd_muladd(m21, center_z, vkm_simd_muladd(m11, center_y, vkm_simd_muladd(m01, center_x, m31))),
+      z = vkm_simd_muladd(m22, center_z, vkm_simd_muladd(m12, center_y, vkm_simd_muladd(m02, center_x, m32))),
+      new_extent_x = vkm_simd_muladd(e20, extent_z, vkm_simd_muladd(e10, extent_y, vkm_simd_mul(e00, extent_x))),
+      new_extent_y = vkm_simd_muladd(e21, extent_z, vkm_simd_muladd(e11, extent_y, vkm_simd_mul(e01, extent_x))),
+      new_extent_z = vkm_simd_muladd(e22, extent_z, vkm_simd_muladd(e12, extent_y, vkm_simd_mul(e02, extent_x)));
+
+    vkm_simd_store(result_mins->x + i, vkm_simd_sub(x, new_extent_x));
+    vkm_simd_store(result_mins->y + i, vkm_simd_sub(y, new_extent_y));
+    vkm_simd_store(result_mins->z + i, vkm_simd_sub(z, new_extent_z));
+    vkm_simd_store(result_maxs->x + i, vkm_simd_add(x, new_extent_x));
+    vkm_simd_store(result_maxs->y + i, vkm_simd_add(y, new_extent_y));
+    vkm_simd_store(result_maxs->z + i, vkm_simd_add(z, new_extent_z));
+  }
+#endif
+  for (; i < count; i++) {
+    const float
+      center_x = (mins->x[i] + maxs->x[i]) * 0.5f,
+      center_y = (mins->y[i] + maxs->y[i]) * 0.5f,
+      center_z = (mins->z[i] + maxs->z[i]) * 0.5f,
+      extent_x = (maxs->x[i] - mins->x[i]) * 0.5f,
+      extent_y = (maxs->y[i] - mins->y[i]) * 0.5f,
+      extent_z = (maxs->z[i] - mins->z[i]) * 0.5f;
+
+    const float
+      x = matrix->m20 * center_z + (matrix->m10 * center_y + (matrix->m00 * center_x + matrix->m30)),
+      y = matrix->m21 * center_z + (matrix->m11 * center_y + (matrix->m01 * center_x + matrix->m31)),
+      z = matrix->m22 * center_z + (matrix->m12 * center_y + (matrix->m02 * center_x + matrix->m32)),
+      new_extent_x = a20 * extent_z + (a10 * extent_y + a00 * extent_x),
+      new_extent_y = a21 * extent_z + (a11 * extent_y + a01 * extent_x),
+      new_extent_z = a22 * extent_z + (a12 * extent_y + a02 * extent_x);
+
+    result_mins->x[i] = x - new_extent_x;
+    result_mins->y[i] = y - new_extent_y;
+    result_mins->z[i] = z - new_extent_z;
+    result_maxs->x[i] = x + new_extent_x;
+    result_maxs->y[i] = y + new_extent_y;
+    result_maxs->z[i] = z + new_extent_z;
+  }
+}
+
+// Planes are stored as the normal in xyz and the distance in w, points with dot(normal, point) + w >= 0 being inside.
+// Extracts the six planes of the view volume of a view projection matrix, in the order left, right, bottom, top, near,
+// far, with normals pointing inside.
+static void vkm_frustum_planes(const vkm_mat4* view_projection, vkm_vec4 planes[6]) {
+  const vkm_mat4* m = view_projection;
+  const vkm_vec4
+    row0 = { { m->m00, m->m10, m->m20, m->m30 } },
+    row1 = { { m->m01, m->m11, m->m21, m->m31 } },
+    row2 = { { m->m02, m->m12, m->m22, m->m32 } },
+    row3 = { { m->m03, m->m13, m->m23, m->m33 } };
+
+  vkm_vec4_add(&row3, &row0, planes);
+  vkm_vec4_sub(&row3, &row0, planes + 1);
+  vkm_vec4_add(&row3, &row1, planes + 2);
+  vkm_vec4_sub(&row3, &row1, planes + 3);
+#ifdef CVKM_ZO
+  planes[4] = row2;
+#else
+  vkm_vec4_add(&row3, &row2, planes + 4);
+#endif
+  vkm_vec4_sub(&row3, &row2, planes + 5);
+
+  for (int i = 0; i < 6; i++) {
+    const float magnitude = vkm_vec3_magnitude((const vkm_vec3*)(planes + i));
+    if (magnitude > 0.0f) {
+      vkm_vec4_div_scalar(planes + i, magnitude, planes + i);
+    }
+  }
+}
+
+// Tests axis aligned boxes against planes, setting visible[i] to false if box i is entirely outside any of them. Boxes
+// crossing a plane count as visible, like for frustum culling. Only the corner furthest along each normal is tested.
+static void vkm_batch_aabbs_test_planes(
+  const vkm_vec4* planes,
+  const size_t plane_count,
+  const vkm_vec3_soa* mins,
+  const vkm_vec3_soa* maxs,
+  bool* visible,
+  const size_t count
+) {
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  for (; i + CVKM_BATCH_WIDTH <= count; i += CVKM_BATCH_WIDTH) {
+    int outside = 0;
+    for (size_t j = 0; j < plane_count && outside != 0xf; j++) {
+      const vkm_vec4* plane = planes + j;
+      const vkm_simd_vec4
+        x = vkm_simd_load((plane->x > 0.0f ? maxs->x : mins->x) + i),
+        y = vkm_simd_load((plane->y > 0.0f ? maxs->y : mins->y) + i),
+        z = vkm_simd_load((plane->z > 0.0f ? maxs->z : mins->z) + i);
+      vkm_simd_vec4 distance = vkm_simd_muladd(vkm_simd_splat(plane->x), x, vkm_simd_splat(plane->w));
+      distance = vkm_simd_muladd(vkm_simd_splat(plane->y), y, distance);
+      distance = vkm_simd_muladd(vkm_simd_splat(plane->z), z, distance);
+      outside |= vkm_simd_negative_mask(distance);
+    }
+    for (int lane = 0; lane < CVKM_BATCH_WIDTH; lane++) {
+      visible[i + lane] = !(outside & 1 << lane);
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    visible[i] = true;
+    for (size_t j = 0; j < plane_count; j++) {
+      const vkm_vec4* plane = planes + j;
+      const float
+        x = plane->x > 0.0f ? maxs->x[i] : mins->x[i],
+        y = plane->y > 0.0f ? maxs->y[i] : mins->y[i],
+        z = plane->z > 0.0f ? maxs->z[i] : mins->z[i];
+      if (plane->z * z + (plane->y * y + (plane->x * x + plane->w)) < 0.0f) {
+        visible[i] = false;
+        break;
+      }
+    }
+  }
+}
+
+// Normalizes vectors, leaving the zero ones as they are.
+static void vkm_batch_normalize(const vkm_vec3_soa* vectors, const vkm_vec3_soa* result, const size_t count) {
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  for (; i + CVKM_BATCH_WIDTH <= count; i += CVKM_BATCH_WIDTH) {
+    const vkm_simd_vec4 x = vkm_simd_load(vectors->x + i), y = vkm_simd_load(vectors->y + i);
+    const vkm_simd_vec4 z = vkm_simd_load(vectors->z + i);
+    const vkm_simd_vec4 sqr_magnitude = vkm_simd_muladd(z, z, vkm_simd_muladd(y, y, vkm_simd_mul(x, x)));
+    const vkm_simd_vec4 magnitude = vkm_simd_positive_or_one(vkm_simd_sqrt(sqr_magnitude));
+    vkm_simd_store(result->x + i, vkm_simd_div(x, magnitude));
+    vkm_simd_store(result->y + i, vkm_simd_div(y, magnitude));
+    vkm_simd_store(result->z + i, vkm_simd_div(z, magnitude));
+  }
+#endif
+  for (; i < count; i++) {
+    const float x = vectors->x[i], y = vectors->y[i], z = vectors->z[i];
+    float magnitude = vkm_sqrt(x * x + y * y + z * z);
+    if (!(magnitude > 0.0f)) {
+      magnitude = 1.0f;
+    }
+    result->x[i] = x / magnitude;
+    result->y[i] = y / magnitude;
+    result->z[i] = z / magnitude;
+  }
+}
+
+// Semi-implicit Euler step: velocities are advanced first, then positions with the new velocities. accelerations may be
+// NULL. These are plain arrays of vec3s, which are contiguous floats, so they go through SIMD without any conversion.
+static void vkm_batch_integrate(
+  Position3D* positions,
+  Velocity3D* velocities,
+  const Acceleration3D* accelerations,
+  const float delta_time,
+  const size_t count
+) {
+  float* position = positions->raw;
+  float* velocity = velocities->raw;
+  const float* acceleration = accelerations ? accelerations->raw : NULL;
+  const size_t float_count = count * 3;
+
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  const vkm_simd_vec4 delta = vkm_simd_splat(delta_time);
+  for (; i + CVKM_BATCH_WIDTH <= float_count; i += CVKM_BATCH_WIDTH) {
+    vkm_simd_vec4 new_velocity = vkm_simd_load(velocity + i);
+    if (acceleration) {
+      new_velocity = vkm_simd_muladd(vkm_simd_load(acceleration + i), delta, new_velocity);
+      vkm_simd_store(velocity + i, new_velocity);
+    }
+    vkm_simd_store(position + i, vkm_simd_muladd(new_velocity, delta, vkm_simd_load(position + i)));
+  }
+#endif
+  for (; i < float_count; i++) {
+    if (acceleration) {
+      velocity[i] += acceleration[i] * delta_time;
+    }
+    position[i] += velocity[i] * delta_time;
+  }
+}
+
+// Batch version of vkm_sincos_fast.
+static void vkm_batch_sincos_fast(const float* angles, float* sines, float* cosines, const size_t count) {
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  const vkm_simd_vec4
+    two_over_pi = vkm_simd_splat(CVKM_2_PI_F),
+    magic = vkm_simd_splat(CVKM_ROUND_MAGIC_F),
+    part1 = vkm_simd_splat(CVKM_PI_2_PART1_F),
+    part2 = vkm_simd_splat(CVKM_PI_2_PART2_F),
+    part3 = vkm_simd_splat(CVKM_PI_2_PART3_F),
+    one = vkm_simd_splat(1.0f),
+    half = vkm_simd_splat(0.5f);
+  for (; i + CVKM_BATCH_WIDTH <= count; i += CVKM_BATCH_WIDTH) {
+    const vkm_simd_vec4 angle = vkm_simd_load(angles + i);
+    const vkm_simd_vec4 shifted = vkm_simd_muladd(angle, two_over_pi, magic);
+    const vkm_simd_vec4 multiple = vkm_simd_sub(shifted, magic);
+    vkm_simd_vec4 r = vkm_simd_sub(angle, vkm_simd_mul(multiple, part1));
+    r = vkm_simd_sub(r, vkm_simd_mul(multiple, part2));
+    r = vkm_simd_sub(r, vkm_simd_mul(multiple, part3));
+    const vkm_simd_vec4 r2 = vkm_simd_mul(r, r);
+
+    // Same evaluation order as vkm_sin_polynomial and vkm_cos_polynomial.
+    vkm_simd_vec4 sine_terms = vkm_simd_muladd(r2, vkm_simd_splat(-1.9515295891e-4f), vkm_simd_splat(8.3321608736e-3f));
+    sine_terms = vkm_simd_muladd(r2, sine_terms, vkm_simd_splat(-1.6666654611e-1f));
+    const vkm_simd_vec4 r_sine = vkm_simd_muladd(vkm_simd_mul(r, r2), sine_terms, r);
+    vkm_simd_vec4 cosine_terms =
+      vkm_simd_muladd(r2, vkm_simd_splat(2.443315711809948e-5f), vkm_simd_splat(-1.388731625493765e-3f));
+    cosine_terms = vkm_simd_muladd(r2, cosine_terms, vkm_simd_splat(4.166664568298827e-2f));
+    const vkm_simd_vec4 r_cosine =
+      vkm_simd_muladd(vkm_simd_mul(r2, r2), cosine_terms, vkm_simd_sub(one, vkm_simd_mul(half, r2)));
+
+    vkm_simd_vec4 sine, cosine;
+    vkm_simd_sincos_quadrant(shifted, r_sine, r_cosine, &sine, &cosine);
+    vkm_simd_store(sines + i, sine);
+    vkm_simd_store(cosines + i, cosine);
+  }
+#endif
+  for (; i < count; i++) {
+    vkm_sincos_fast(angles[i], sines + i, cosines + i);
+  }
+}
+
+// Batch version of vkm_atan2_fast.
+static void vkm_batch_atan2_fast(const float* ys, const float* xs, float* results, const size_t count) {
+  size_t i = 0;
+#ifdef CVKM_HAS_SIMD
+  static const float coefficients[6] = {
+    0.99997726f, -0.33262347f, 0.19354346f, -0.11643287f, 0.05265332f, -0.01172120f,
+  };
+  const vkm_simd_vec4 zero = vkm_simd_splat(0.0f), pi_2 = vkm_simd_splat(CVKM_PI_2_F), pi = vkm_simd_splat(CVKM_PI_F);
+  for (; i + CVKM_BATCH_WIDTH <= count; i += CVKM_BATCH_WIDTH) {
+    const vkm_simd_vec4 x = vkm_simd_load(xs + i), y = vkm_simd_load(ys + i);
+    const vkm_simd_vec4 abs_x = vkm_simd_abs(x), abs_y = vkm_simd_abs(y);
+    const vkm_simd_vec4 max = vkm_simd_select_greater(abs_y, abs_x, abs_y, abs_x);
+    const vkm_simd_vec4 min = vkm_simd_select_greater(abs_y, abs_x, abs_x, abs_y);
+    const vkm_simd_vec4 t = vkm_simd_div(min, vkm_simd_positive_or_one(max));
+    const vkm_simd_vec4 t2 = vkm_simd_mul(t, t);
+
+    // Same evaluation order as vkm_atan_polynomial.
+    vkm_simd_vec4 angle = vkm_simd_splat(coefficients[5]);
+    for (int j = 4; j >= 0; j--) {
+      angle = vkm_simd_muladd(t2, angle, vkm_simd_splat(coefficients[j]));
+    }
+    angle = vkm_simd_mul(t, angle);
+
+    angle = vkm_simd_select_greater(abs_y, abs_x, vkm_simd_sub(pi_2, angle), angle);
+    angle = vkm_simd_select_greater(zero, x, vkm_simd_sub(pi, angle), angle);
+    vkm_simd_store(results + i, vkm_simd_copysign(angle, y));
+  }
+#endif
+  for (; i < count; i++) {
+    results[i] = vkm_atan2_fast(ys[i], xs[i]);
+  }
+}
+
+#undef CVKM_BATCH_WIDTH
+
 #ifdef CVKM_ENABLE_FLECS
 extern ECS_COMPONENT_DECLARE(vkm_bvec2);
 extern ECS_COMPONENT_DECLARE(vkm_ubvec2);
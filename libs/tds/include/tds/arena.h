@@ -0,0 +1,161 @@
+#pragma once
+#ifndef _TDS_ARENA_H_
+#define _TDS_ARENA_H_
+
+#include "private/common.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator. Allocating moves a cursor forward through big blocks taken from TDS_REALLOC, and everything
+// allocated after a mark is released at once by resetting to it, without visiting the allocations. Blocks given back by
+// a reset are kept around and reused, so an arena that is reset every frame or every job stops calling malloc after
+// warming up. Not thread safe, give each thread its own arena.
+//
+// Zero-initialized arenas are ready to use. Pass tds_arena_allocator() to the allocator field of a container to have it
+// live in the arena.
+
+// Minimum size of the blocks, an allocation that doesn't fit gets a block of its own.
+#ifndef TDS_ARENA_BLOCK_SIZE
+#define TDS_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+typedef struct tds_arena_block {
+    struct tds_arena_block* previous;
+    size_t size; // Bytes usable after the header.
+} tds_arena_block;
+
+typedef struct tds_arena {
+    tds_arena_block* block; // The block allocations are coming from, linked to the older ones.
+    tds_arena_block* spare; // Blocks released by resets, reused before allocating new ones.
+    size_t used; // Bytes taken from the current block.
+    void* last; // The most recent allocation, which can grow and shrink in place.
+    tds_allocator allocator; // Filled in by tds_arena_allocator.
+} tds_arena;
+
+typedef struct tds_arena_mark {
+    tds_arena_block* block;
+    size_t used;
+} tds_arena_mark;
+
+static inline char* tds_arena_block_data(tds_arena_block* block) {
+    return (char*)(block + 1);
+}
+
+// Makes a block with at least size bytes current, preferring spares.
+static inline void tds_arena_next_block(tds_arena* arena, const size_t size) {
+    tds_arena_block** spare = &arena->spare;
+    while (*spare && (*spare)->size < size) {
+        spare = &(*spare)->previous;
+    }
+
+    tds_arena_block* block = *spare;
+    if (block) {
+        *spare = block->previous;
+    } else {
+        const size_t block_size = size > TDS_ARENA_BLOCK_SIZE ? size : TDS_ARENA_BLOCK_SIZE;
+        block = TDS_REALLOC(NULL, sizeof(tds_arena_block) + block_size);
+        block->size = block_size;
+    }
+
+    block->previous = arena->block;
+    arena->block = block;
+    arena->used = 0;
+}
+
+// alignment must be a power of two.
+static inline void* tds_arena_alloc_aligned(tds_arena* arena, const size_t size, const size_t alignment) {
+    TDS_ASSERT(alignment && !(alignment & (alignment - 1)));
+
+    if (arena->block) {
+        const uintptr_t data = (uintptr_t)tds_arena_block_data(arena->block);
+        const size_t offset = ((data + arena->used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - data;
+        if (offset <= arena->block->size && size <= arena->block->size - offset) {
+            arena->used = offset + size;
+            arena->last = (void*)(data + offset);
+            return arena->last;
+        }
+    }
+
+    // Guard against overflow.
+    TDS_ASSERT(size <= SIZE_MAX - alignment - sizeof(tds_arena_block));
+
+    // Enough for any alignment of the block data.
+    tds_arena_next_block(arena, size + alignment - 1);
+    const uintptr_t data = (uintptr_t)tds_arena_block_data(arena->block);
+    const size_t offset = ((data + alignment - 1) & ~(uintptr_t)(alignment - 1)) - data;
+    arena->used = offset + size;
+    arena->last = (void*)(data + offset);
+    return arena->last;
+}
+
+static inline void* tds_arena_alloc(tds_arena* arena, const size_t size) {
+    return tds_arena_alloc_aligned(arena, size, alignof(max_align_t));
+}
+
+// Same contract as tds_allocator.reallocate. Only the most recent allocation can give memory back, anything else is
+// left in place until the next reset.
+static inline void* tds_arena_realloc(tds_arena* arena, void* pointer, const size_t old_size, const size_t new_size) {
+    if (!pointer) {
+        return new_size ? tds_arena_alloc(arena, new_size) : NULL;
+    }
+
+    if (pointer == arena->last) {
+        const size_t offset = (size_t)((char*)pointer - tds_arena_block_data(arena->block));
+        if (new_size <= arena->block->size - offset) {
+            arena->used = offset + new_size;
+            if (!new_size) {
+                arena->last = NULL;
+            }
+            return new_size ? pointer : NULL;
+        }
+    } else if (new_size <= old_size) {
+        return new_size ? pointer : NULL;
+    }
+
+    void* new_pointer = tds_arena_alloc(arena, new_size);
+    TDS_MEMMOVE(new_pointer, pointer, old_size);
+    return new_pointer;
+}
+
+static inline tds_arena_mark tds_arena_get_mark(const tds_arena* arena) {
+    return (tds_arena_mark){ .block = arena->block, .used = arena->used };
+}
+
+// Releases everything allocated since the mark was taken. Costs one step per block released, not per allocation.
+static inline void tds_arena_reset_to(tds_arena* arena, const tds_arena_mark mark) {
+    while (arena->block != mark.block) {
+        tds_arena_block* block = arena->block;
+        arena->block = block->previous;
+        block->previous = arena->spare;
+        arena->spare = block;
+    }
+    arena->used = mark.used;
+    arena->last = NULL;
+}
+
+static inline void tds_arena_reset(tds_arena* arena) {
+    tds_arena_reset_to(arena, (tds_arena_mark){ 0 });
+}
+
+static inline void* tds_arena_reallocate(void* context, void* pointer, const size_t old_size, const size_t new_size) {
+    return tds_arena_realloc(context, pointer, old_size, new_size);
+}
+
+// The returned allocator lives in the arena, so it stays valid as long as the arena does.
+static inline const tds_allocator* tds_arena_allocator(tds_arena* arena) {
+    arena->allocator = (tds_allocator){ .reallocate = tds_arena_reallocate, .context = arena };
+    return &arena->allocator;
+}
+
+static inline void tds_arena_fini(tds_arena* arena) {
+    tds_arena_reset(arena);
+    while (arena->spare) {
+        tds_arena_block* block = arena->spare;
+        arena->spare = block->previous;
+        TDS_FREE(block);
+    }
+    *arena = (tds_arena){ 0 };
+}
+#endif
@@ -5,15 +5,33 @@
 #define TDS_TYPE TDS_DEFAULT_TYPE_W_VALUE(dense_pool)
 #endif
 
+// Handles pack a generation in the top TDS_GENERATION_BITS bits and the sparse index in the rest. The generation of an
+// index is bumped every time it's freed, so handles to removed values go stale instead of aliasing whatever reuses the
+// index. Generations skip 0, which makes 0 a handle that is never valid.
+#ifndef TDS_GENERATION_BITS
+#define TDS_GENERATION_BITS 8
+#endif
+
+#define TDS_INDEX_BITS (sizeof(TDS_SIZE_T) * 8 - TDS_GENERATION_BITS)
+#define TDS_INDEX_MASK ((TDS_SIZE_T)(((TDS_SIZE_T)1 << TDS_INDEX_BITS) - 1))
+#define TDS_HANDLE_INDEX(handle) ((handle) & TDS_INDEX_MASK)
+#define TDS_HANDLE_GENERATION(handle) ((TDS_SIZE_T)(handle) >> TDS_INDEX_BITS)
+#define TDS_MAKE_HANDLE(generation, index) ((TDS_SIZE_T)((TDS_SIZE_T)(generation) << TDS_INDEX_BITS | (index)))
+
 #ifdef TDS_DECLARE
 typedef struct TDS_TYPE {
     TDS_VALUE_T* array;
+    // dense holds the handle of each value in array, followed by the freelist of handles to hand out next.
+    // sparse maps the index of a handle to its position in array.
     TDS_SIZE_T* dense, *sparse, count, capacity;
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
 } TDS_TYPE;
 
 TDS_SIZE_T TDS_FUNCTION(append)(TDS_TYPE* pool, TDS_VALUE_T value);
-TDS_SIZE_T TDS_FUNCTION(remove)(TDS_TYPE* pool, TDS_SIZE_T id);
-TDS_VALUE_T TDS_FUNCTION(get)(const TDS_TYPE* pool, TDS_SIZE_T id);
+TDS_SIZE_T TDS_FUNCTION(remove)(TDS_TYPE* pool, TDS_SIZE_T handle);
+TDS_VALUE_T TDS_FUNCTION(get)(const TDS_TYPE* pool, TDS_SIZE_T handle);
+void TDS_FUNCTION(set)(TDS_TYPE* pool, TDS_SIZE_T handle, TDS_VALUE_T value);
+char TDS_FUNCTION(valid)(const TDS_TYPE* pool, TDS_SIZE_T handle);
 TDS_SIZE_T TDS_FUNCTION(count)(const TDS_TYPE* pool);
 TDS_VALUE_T* TDS_FUNCTION(first)(const TDS_TYPE* pool);
 void TDS_FUNCTION(clear)(TDS_TYPE* pool);
@@ -21,44 +39,66 @@ void TDS_FUNCTION(fini)(TDS_TYPE* pool);
 #endif
 
 #ifdef TDS_IMPLEMENT
+// Same index, next generation.
+static TDS_SIZE_T TDS_FUNCTION(_next_generation)(const TDS_SIZE_T handle) {
+    TDS_SIZE_T generation = TDS_HANDLE_GENERATION(handle) + 1;
+    if (generation >> TDS_GENERATION_BITS) {
+        // Wrap around, skipping 0.
+        generation = 1;
+    }
+    return TDS_MAKE_HANDLE(generation, TDS_HANDLE_INDEX(handle));
+}
+
 TDS_SIZE_T TDS_FUNCTION(append)(TDS_TYPE* pool, const TDS_VALUE_T value) {
     TDS_ASSERT(pool->count <= pool->capacity);
-    // Guard against overflow.
-    TDS_ASSERT(pool->count < TDS_MAX_VALUE(TDS_SIZE_T));
+    // Guard against running out of handle indices.
+    TDS_ASSERT(pool->count <= TDS_INDEX_MASK);
 
     if (pool->count == pool->capacity) {
         TDS_SIZE_T new_capacity = pool->capacity ? pool->capacity * 2 : TDS_INITIAL_CAPACITY;
-        if (new_capacity < pool->capacity) {
+        if (new_capacity < pool->capacity || new_capacity > TDS_INDEX_MASK + 1) {
             // Guard against overflow.
-            new_capacity = TDS_MAX_VALUE(TDS_SIZE_T);
+            new_capacity = TDS_INDEX_MASK + 1;
         }
-        pool->capacity = new_capacity;
-        pool->array = TDS_REALLOC(pool->array, new_capacity * sizeof(*pool->array));
-        pool->dense = TDS_REALLOC(pool->dense, new_capacity * sizeof(*pool->dense));
-        pool->sparse = TDS_REALLOC(pool->sparse, new_capacity * sizeof(*pool->sparse));
-        const TDS_SIZE_T new_elements = new_capacity - pool->count;
+        pool->array = tds_reallocate(
+            pool->allocator,
+            pool->array,
+            pool->capacity * sizeof(*pool->array),
+            new_capacity * sizeof(*pool->array));
+        pool->dense = tds_reallocate(
+            pool->allocator,
+            pool->dense,
+            pool->capacity * sizeof(*pool->dense),
+            new_capacity * sizeof(*pool->dense));
+        pool->sparse = tds_reallocate(
+            pool->allocator,
+            pool->sparse,
+            pool->capacity * sizeof(*pool->sparse),
+            new_capacity * sizeof(*pool->sparse));
+        const TDS_SIZE_T new_elements = new_capacity - pool->capacity;
+        // 0 in dense marks indices that were never handed out, and sparse entries out of range fail validation.
+        TDS_MEMSET(pool->dense + pool->capacity, 0, new_elements * sizeof(*pool->dense));
         for (TDS_SIZE_T i = 0; i < new_elements; i++) {
-            pool->dense[pool->count + i] = TDS_MAX_VALUE(TDS_SIZE_T);
+            pool->sparse[pool->capacity + i] = TDS_MAX_VALUE(TDS_SIZE_T);
         }
+        pool->capacity = new_capacity;
     }
 
-    const TDS_SIZE_T new_sparse_id = pool->dense[pool->count] == TDS_MAX_VALUE(TDS_SIZE_T)
-        ? pool->count
-        : pool->dense[pool->count];
-    pool->sparse[new_sparse_id] = pool->count;
-    pool->dense[pool->count] = new_sparse_id;
+    const TDS_SIZE_T new_handle = pool->dense[pool->count]
+        ? pool->dense[pool->count]
+        : TDS_MAKE_HANDLE(1, pool->count);
+    pool->sparse[TDS_HANDLE_INDEX(new_handle)] = pool->count;
+    pool->dense[pool->count] = new_handle;
 
     pool->array[pool->count] = value;
     pool->count++;
-    return new_sparse_id;
+    return new_handle;
 }
 
-TDS_SIZE_T TDS_FUNCTION(remove)(TDS_TYPE* pool, const TDS_SIZE_T id) {
-    TDS_ASSERT(id < pool->capacity);
-    TDS_ASSERT(pool->sparse[id] < pool->count);
-    TDS_ASSERT(pool->dense[pool->sparse[id]] == id);
+TDS_SIZE_T TDS_FUNCTION(remove)(TDS_TYPE* pool, const TDS_SIZE_T handle) {
+    TDS_ASSERT(TDS_FUNCTION(valid)(pool, handle));
 
-    const TDS_SIZE_T dense_index = pool->sparse[id];
+    const TDS_SIZE_T dense_index = pool->sparse[TDS_HANDLE_INDEX(handle)];
 
 #ifdef TDS_VALUE_FINI
     TDS_VALUE_FINI(pool->array[dense_index]);
@@ -66,28 +106,46 @@ TDS_SIZE_T TDS_FUNCTION(remove)(TDS_TYPE* pool, const TDS_SIZE_T id) {
 
     const TDS_SIZE_T last_dense = --pool->count;
     if (dense_index != last_dense) {
-        const TDS_SIZE_T moved_id = pool->dense[last_dense];
+        const TDS_SIZE_T moved_handle = pool->dense[last_dense];
 
         // Move value.
         pool->array[dense_index] = pool->array[last_dense];
 
         // Fix mappings.
-        pool->dense[dense_index] = moved_id;
-        pool->sparse[moved_id] = dense_index;
+        pool->dense[dense_index] = moved_handle;
+        pool->sparse[TDS_HANDLE_INDEX(moved_handle)] = dense_index;
     }
 
-    // Put freed sparse id into freelist.
-    pool->dense[last_dense] = id;
+    // Put freed index into freelist, with a new generation so the removed handle goes stale.
+    pool->dense[last_dense] = TDS_FUNCTION(_next_generation)(handle);
 
     return dense_index;
 }
 
-TDS_VALUE_T TDS_FUNCTION(get)(const TDS_TYPE* pool, const TDS_SIZE_T id) {
-    TDS_ASSERT(id < pool->capacity);
-    TDS_ASSERT(pool->sparse[id] < pool->count);
-    TDS_ASSERT(pool->dense[pool->sparse[id]] == id);
+TDS_VALUE_T TDS_FUNCTION(get)(const TDS_TYPE* pool, const TDS_SIZE_T handle) {
+    TDS_ASSERT(TDS_FUNCTION(valid)(pool, handle));
 
-    return pool->array[pool->sparse[id]];
+    return pool->array[pool->sparse[TDS_HANDLE_INDEX(handle)]];
+}
+
+void TDS_FUNCTION(set)(TDS_TYPE* pool, const TDS_SIZE_T handle, const TDS_VALUE_T value) {
+    TDS_ASSERT(TDS_FUNCTION(valid)(pool, handle));
+
+    TDS_VALUE_T* slot = pool->array + pool->sparse[TDS_HANDLE_INDEX(handle)];
+#ifdef TDS_VALUE_FINI
+    TDS_VALUE_FINI(*slot);
+#endif
+    *slot = value;
+}
+
+char TDS_FUNCTION(valid)(const TDS_TYPE* pool, const TDS_SIZE_T handle) {
+    const TDS_SIZE_T index = TDS_HANDLE_INDEX(handle);
+    if (!handle || index >= pool->capacity) {
+        return 0;
+    }
+
+    const TDS_SIZE_T dense_index = pool->sparse[index];
+    return dense_index < pool->count && pool->dense[dense_index] == handle;
 }
 
 TDS_SIZE_T TDS_FUNCTION(count)(const TDS_TYPE* pool) {
@@ -99,13 +157,12 @@ TDS_VALUE_T* TDS_FUNCTION(first)(const TDS_TYPE* pool) {
 }
 
 void TDS_FUNCTION(clear)(TDS_TYPE* pool) {
-#ifdef TDS_VALUE_FINI
+    // The live handles are already in front of the freelist, so they only need their generation bumped to be freed.
     for (TDS_SIZE_T i = 0; i < pool->count; i++) {
+#ifdef TDS_VALUE_FINI
         TDS_VALUE_FINI(pool->array[i]);
-    }
 #endif
-    for (TDS_SIZE_T i = 0; i < pool->capacity; i++) {
-        pool->dense[i] = TDS_MAX_VALUE(TDS_SIZE_T);
+        pool->dense[i] = TDS_FUNCTION(_next_generation)(pool->dense[i]);
     }
     pool->count = 0;
 }
@@ -116,11 +173,18 @@ void TDS_FUNCTION(fini)(TDS_TYPE* pool) {
         TDS_VALUE_FINI(pool->array[i]);
     }
 #endif
-    TDS_FREE(pool->array);
-    TDS_FREE(pool->dense);
-    TDS_FREE(pool->sparse);
-    *pool= (TDS_TYPE){ 0 };
+    tds_free(pool->allocator, pool->array, pool->capacity * sizeof(*pool->array));
+    tds_free(pool->allocator, pool->dense, pool->capacity * sizeof(*pool->dense));
+    tds_free(pool->allocator, pool->sparse, pool->capacity * sizeof(*pool->sparse));
+    *pool = (TDS_TYPE){ .allocator = pool->allocator };
 }
 #endif
 
+#undef TDS_GENERATION_BITS
+#undef TDS_INDEX_BITS
+#undef TDS_INDEX_MASK
+#undef TDS_HANDLE_INDEX
+#undef TDS_HANDLE_GENERATION
+#undef TDS_MAKE_HANDLE
+
 #include "private/end.inc"
@@ -20,6 +20,7 @@ typedef struct TDS_TYPE {
     TDS_ENTRY_T* buckets;
     TDS_SIZE_T count;
     TDS_SIZE_T capacity; // Always a prime number.
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
 } TDS_TYPE;
 
 typedef struct TDS_JOIN2(TDS_TYPE, _iter_t) {
@@ -30,7 +31,13 @@ typedef struct TDS_JOIN2(TDS_TYPE, _iter_t) {
 } TDS_JOIN2(TDS_TYPE, _iter_t);
 
 TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key);
+// Looks up a batch of keys, storing a pointer to each value (or NULL) in results. Returns how many were found.
+TDS_SIZE_T TDS_FUNCTION(get_many)(const TDS_TYPE* map, const TDS_KEY_T* keys, TDS_SIZE_T count, TDS_VALUE_T** results);
+// Makes room for count entries in total, so that many can be held without rehashing.
+void TDS_FUNCTION(reserve)(TDS_TYPE* map, TDS_SIZE_T count);
 void TDS_FUNCTION(set)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value);
+// Sets count key-value pairs, sizing the map once up front. On an empty map this is how to bulk-build one.
+void TDS_FUNCTION(set_many)(TDS_TYPE* map, const TDS_KEY_T* keys, const TDS_VALUE_T* values, TDS_SIZE_T count);
 TDS_JOIN2(TDS_TYPE, _iter_t) TDS_FUNCTION(iter)(const TDS_TYPE* map);
 char TDS_FUNCTION(next)(TDS_JOIN2(TDS_TYPE, _iter_t)* iter);
 void TDS_FUNCTION(remove)(TDS_TYPE* map, TDS_KEY_T key);
@@ -40,12 +47,7 @@ void TDS_FUNCTION(fini)(TDS_TYPE* map);
 #endif
 
 #ifdef TDS_IMPLEMENT
-TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key) {
-    if (!map->buckets) {
-        return NULL;
-    }
-
-    const uint64_t hash = TDS_HASH_KEY(key);
+static TDS_ENTRY_T* TDS_FUNCTION(_find)(const TDS_TYPE* map, TDS_KEY_T key, const uint64_t hash) {
     TDS_SIZE_T index = hash % map->capacity;
     // The "for" instead of a "while" loop is just to guard against infinite loops.
     for (TDS_SIZE_T i = 0; i < map->capacity; i++) {
@@ -62,7 +64,7 @@ TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key) {
         if (cur->hash == hash && cur->key == key) {
 #endif
             // Key found.
-            return &cur->value;
+            return cur;
         }
 
         index = (index + 1) % map->capacity;
@@ -72,92 +74,53 @@ TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key) {
     return NULL;
 }
 
-void TDS_FUNCTION(set)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value) {
-    if (!map->buckets) {
-        // Yeah, we ignore TDS_INITIAL_CAPACITY here because we need the capacity to be a prime number.
-        // TODO: Well, use the next prime then.
-        map->capacity = 11;
-        map->buckets = TDS_CALLOC(map->capacity, sizeof(TDS_ENTRY_T));
-    }
-
-    TDS_SIZE_T index;
-
-    // Ensure the map has room for at least one more entry.
-    // Check load factor > 0.75 by using integer math instead of floating-point math.
-    if ((map->count + 1) * 4 > map->capacity * 3) {
-        // Find the smaller prime number that is at least as big as the required capacity.
-        static const unsigned long long prime_list[] = {
-            2, 3, 5, 11, 17, 37, 67, 131, 257, 521, 1031, 2053, 4099, 8209, 16411, 32771, 65537, 131101, 262147,
-            524309, 1048583, 2097169, 4194319, 8388617, 16777259, 33554467, 67108879, 134217757, 268435459, 536870923,
-            1073741827, 2147483659, 4294967311, 8589934609, 17179869209, 34359738421, 68719476767, 137438953481,
-            274877906951, 549755813911, 1099511627791, 2199023255579, 4398046511119, 8796093022237, 17592186044423,
-            35184372088891, 70368744177679, 140737488355333, 281474976710677, 562949953421381, 1125899906842679,
-            2251799813685269, 4503599627370517, 9007199254740997, 18014398509482143, 36028797018963971,
-            72057594037928017, 144115188075855881, 288230376151711813, 576460752303423619, 1152921504606847009,
-            2305843009213693967, 4611686018427388039, 9223372036854775837ull,
-        };
+static void TDS_FUNCTION(_rehash)(TDS_TYPE* map, const TDS_SIZE_T new_capacity) {
+    TDS_ENTRY_T* new_buckets = tds_callocate(map->allocator, new_capacity * sizeof(TDS_ENTRY_T));
+    for (TDS_SIZE_T i = 0; i < map->capacity; i++) {
+        TDS_ENTRY_T entry = map->buckets[i];
+        if (!entry.occupied) {
+            continue;
+        }
 
-        TDS_SIZE_T new_capacity = map->capacity * 2;
-        if (new_capacity < map->capacity) {
-            // Handle overflow.
-            new_capacity = TDS_MAX_VALUE(TDS_SIZE_T);
-        } else {
-            for (unsigned i = 0; i < TDS_COUNTOF(prime_list); i++) {
-                if (prime_list[i] < new_capacity) {
-                    continue;
-                }
+        entry.probe_sequence_length = 0;
 
-                new_capacity = (TDS_SIZE_T)prime_list[i];
+        // Insert entry.
+        TDS_SIZE_T index = entry.hash % new_capacity;
+        while (1) {
+            TDS_ENTRY_T* cur = new_buckets + index;
+            if (!cur->occupied) {
+                new_buckets[index] = entry;
                 break;
             }
-        }
 
-        // Rehashing.
-        TDS_ENTRY_T* new_buckets = TDS_CALLOC(new_capacity, sizeof(TDS_ENTRY_T));
-        for (TDS_SIZE_T i = 0; i < map->capacity; i++) {
-            TDS_ENTRY_T entry = map->buckets[i];
-            if (!entry.occupied) {
-                continue;
-            }
-
-            entry.probe_sequence_length = 0;
-
-            // Insert entry.
-            index = entry.hash % new_capacity;
-            while (1) {
-                TDS_ENTRY_T* cur = new_buckets + index;
-                if (!cur->occupied) {
-                    new_buckets[index] = entry;
-                    break;
-                }
-
-                // Robin Hood: Swap if our probe distance is higher.
-                if (cur->probe_sequence_length < entry.probe_sequence_length) {
-                    const TDS_ENTRY_T temp = *cur;
-                    *cur = entry;
-                    entry = temp;
-                }
-                index = (index + 1) % new_capacity;
-                entry.probe_sequence_length++;
-                TDS_ASSERT(entry.probe_sequence_length < new_capacity);
+            // Robin Hood: Swap if our probe distance is higher.
+            if (cur->probe_sequence_length < entry.probe_sequence_length) {
+                const TDS_ENTRY_T temp = *cur;
+                *cur = entry;
+                entry = temp;
             }
+            index = (index + 1) % new_capacity;
+            entry.probe_sequence_length++;
+            TDS_ASSERT(entry.probe_sequence_length < new_capacity);
         }
-
-        TDS_FREE(map->buckets);
-        map->buckets = new_buckets;
-        map->capacity = new_capacity;
     }
 
-    // Do the insertion.
+    tds_free(map->allocator, map->buckets, map->capacity * sizeof(TDS_ENTRY_T));
+    map->buckets = new_buckets;
+    map->capacity = new_capacity;
+}
+
+// The caller must make sure there's room for one more entry.
+static void TDS_FUNCTION(_insert)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value, const uint64_t hash) {
     TDS_ENTRY_T new_entry = {
-        .hash = TDS_HASH_KEY(key),
+        .hash = hash,
         .probe_sequence_length = 0,
         .key = key,
         .value = value,
         .occupied = 1,
     };
 
-    index = new_entry.hash % map->capacity;
+    TDS_SIZE_T index = new_entry.hash % map->capacity;
     while (1) {
         TDS_ENTRY_T* cur = map->buckets + index;
         if (!cur->occupied) {
@@ -190,6 +153,107 @@ void TDS_FUNCTION(set)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value) {
     }
 }
 
+TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key) {
+    if (!map->buckets) {
+        return NULL;
+    }
+
+    TDS_ENTRY_T* entry = TDS_FUNCTION(_find)(map, key, TDS_HASH_KEY(key));
+    return entry ? &entry->value : NULL;
+}
+
+TDS_SIZE_T TDS_FUNCTION(get_many)(
+    const TDS_TYPE* map,
+    const TDS_KEY_T* keys,
+    const TDS_SIZE_T count,
+    TDS_VALUE_T** results
+) {
+    TDS_SIZE_T found = 0;
+    if (!map->buckets) {
+        for (TDS_SIZE_T i = 0; i < count; i++) {
+            results[i] = NULL;
+        }
+        return found;
+    }
+
+    uint64_t hashes[TDS_BATCH_SIZE];
+    for (TDS_SIZE_T batch = 0; batch < count; batch += TDS_BATCH_SIZE) {
+        const TDS_SIZE_T batch_count = count - batch < TDS_BATCH_SIZE ? count - batch : TDS_BATCH_SIZE;
+
+        // Hash the whole batch and prefetch its buckets first, so the cache misses overlap instead of being paid one
+        // after the other.
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            const TDS_KEY_T key = keys[batch + i];
+            hashes[i] = TDS_HASH_KEY(key);
+            TDS_PREFETCH(map->buckets + hashes[i] % map->capacity);
+        }
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            TDS_ENTRY_T* entry = TDS_FUNCTION(_find)(map, keys[batch + i], hashes[i]);
+            results[batch + i] = entry ? &entry->value : NULL;
+            found += entry != NULL;
+        }
+    }
+
+    return found;
+}
+
+void TDS_FUNCTION(reserve)(TDS_TYPE* map, const TDS_SIZE_T count) {
+    // Smallest capacity that keeps the load factor at or below 0.75.
+    unsigned long long required = (unsigned long long)count + (count + 2) / 3;
+    if (map->buckets && required <= map->capacity) {
+        return;
+    }
+
+    required = tds_next_prime(required);
+    TDS_FUNCTION(_rehash)(map, required > TDS_MAX_VALUE(TDS_SIZE_T) ? TDS_MAX_VALUE(TDS_SIZE_T) : (TDS_SIZE_T)required);
+}
+
+void TDS_FUNCTION(set)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value) {
+    if (!map->buckets) {
+        TDS_FUNCTION(reserve)(map, TDS_INITIAL_CAPACITY);
+    }
+
+    // Ensure the map has room for at least one more entry.
+    // Check load factor > 0.75 by using integer math instead of floating-point math.
+    if ((map->count + 1) * 4 > map->capacity * 3) {
+        TDS_SIZE_T new_capacity = map->capacity * 2;
+        if (new_capacity < map->capacity) {
+            // Handle overflow.
+            new_capacity = TDS_MAX_VALUE(TDS_SIZE_T);
+        } else {
+            // Find the smaller prime number that is at least as big as the required capacity.
+            const unsigned long long prime = tds_next_prime(new_capacity);
+            new_capacity = prime > TDS_MAX_VALUE(TDS_SIZE_T) ? TDS_MAX_VALUE(TDS_SIZE_T) : (TDS_SIZE_T)prime;
+        }
+
+        TDS_FUNCTION(_rehash)(map, new_capacity);
+    }
+
+    // Do the insertion.
+    TDS_FUNCTION(_insert)(map, key, value, TDS_HASH_KEY(key));
+}
+
+void TDS_FUNCTION(set_many)(TDS_TYPE* map, const TDS_KEY_T* keys, const TDS_VALUE_T* values, const TDS_SIZE_T count) {
+    // Size for the worst case of every key being new, so the loop below never rehashes.
+    TDS_FUNCTION(reserve)(map, map->count + count);
+
+    uint64_t hashes[TDS_BATCH_SIZE];
+    for (TDS_SIZE_T batch = 0; batch < count; batch += TDS_BATCH_SIZE) {
+        const TDS_SIZE_T batch_count = count - batch < TDS_BATCH_SIZE ? count - batch : TDS_BATCH_SIZE;
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            const TDS_KEY_T key = keys[batch + i];
+            hashes[i] = TDS_HASH_KEY(key);
+            TDS_PREFETCH(map->buckets + hashes[i] % map->capacity);
+        }
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            TDS_FUNCTION(_insert)(map, keys[batch + i], values[batch + i], hashes[i]);
+        }
+    }
+}
+
 TDS_JOIN2(TDS_TYPE, _iter_t) TDS_FUNCTION(iter)(const TDS_TYPE* map) {
     return (TDS_JOIN2(TDS_TYPE, _iter_t)) {
         .map = map,
@@ -304,8 +368,8 @@ void TDS_FUNCTION(fini)(TDS_TYPE* map) {
 #endif
     }
 #endif
-    TDS_FREE(map->buckets);
-    *map = (TDS_TYPE){ 0 };
+    tds_free(map->allocator, map->buckets, map->capacity * sizeof(TDS_ENTRY_T));
+    *map = (TDS_TYPE){ .allocator = map->allocator };
 }
 #endif
 
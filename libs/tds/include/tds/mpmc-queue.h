@@ -0,0 +1,154 @@
+#include "private/common.h"
+#include "private/begin.inc"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+
+// Bounded lock-free queue for any number of producer and consumer threads (Dmitry Vyukov's design). Each cell carries a
+// sequence number telling whose turn it is: producers and consumers claim a position with a single compare-and-swap on
+// their own index, then hand the cell over by publishing the next sequence number. Like spsc-queue.h, the ring is
+// allocated once by init and push fails instead of growing.
+
+#ifndef TDS_TYPE
+#define TDS_TYPE TDS_DEFAULT_TYPE_W_VALUE(mpmc_queue)
+#endif
+
+#define TDS_ENTRY_T TDS_JOIN2(TDS_TYPE, _cell)
+
+// Sequence numbers are compared by their wrapped distance, which is "negative" in the upper half of the range.
+#define TDS_IS_BEHIND(a, b) ((TDS_SIZE_T)((a) - (b)) > TDS_MAX_VALUE(TDS_SIZE_T) / 2)
+
+#ifdef TDS_DECLARE
+typedef struct TDS_ENTRY_T {
+    _Atomic(TDS_SIZE_T) sequence;
+    TDS_VALUE_T value;
+} TDS_ENTRY_T;
+
+typedef struct TDS_TYPE {
+    // Written by init only.
+    TDS_ENTRY_T* cells;
+    TDS_SIZE_T capacity; // Always a power of two, and at least 2.
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
+
+    // Shared by the producers. Indices only ever increase and are wrapped when indexing into cells.
+    alignas(TDS_CACHE_LINE_SIZE) _Atomic(TDS_SIZE_T) tail;
+
+    // Shared by the consumers.
+    alignas(TDS_CACHE_LINE_SIZE) _Atomic(TDS_SIZE_T) head;
+} TDS_TYPE;
+
+// Allocates room for at least capacity values. Not thread safe, call it before handing the queue out.
+void TDS_FUNCTION(init)(TDS_TYPE* queue, TDS_SIZE_T capacity);
+// Returns 0 if the queue is full.
+char TDS_FUNCTION(push)(TDS_TYPE* queue, TDS_VALUE_T value);
+// Returns 0 if the queue is empty.
+char TDS_FUNCTION(pop)(TDS_TYPE* queue, TDS_VALUE_T* value);
+// Only exact while no thread is pushing or popping, otherwise a snapshot.
+TDS_SIZE_T TDS_FUNCTION(count)(TDS_TYPE* queue);
+// Not thread safe.
+void TDS_FUNCTION(fini)(TDS_TYPE* queue);
+#endif
+
+#ifdef TDS_IMPLEMENT
+void TDS_FUNCTION(init)(TDS_TYPE* queue, const TDS_SIZE_T capacity) {
+    // Guard against overflow, the distance between the indices has to fit.
+    TDS_ASSERT(capacity && capacity <= TDS_MAX_VALUE(TDS_SIZE_T) / 2 + 1);
+
+    TDS_SIZE_T new_capacity = 2;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    queue->cells = tds_reallocate(queue->allocator, NULL, 0, new_capacity * sizeof(TDS_ENTRY_T));
+    queue->capacity = new_capacity;
+    for (TDS_SIZE_T i = 0; i < new_capacity; i++) {
+        // A cell is free for the producer whose position matches its sequence.
+        atomic_init(&queue->cells[i].sequence, i);
+    }
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->head, 0);
+}
+
+char TDS_FUNCTION(push)(TDS_TYPE* queue, const TDS_VALUE_T value) {
+    TDS_SIZE_T tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    TDS_ENTRY_T* cell;
+    while (1) {
+        cell = queue->cells + (tail & (queue->capacity - 1));
+        const TDS_SIZE_T sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if (sequence == tail) {
+            // Our turn, claim the position. On failure tail is reloaded and we try the next one.
+            if (atomic_compare_exchange_weak_explicit(
+                &queue->tail,
+                &tail,
+                (TDS_SIZE_T)(tail + 1),
+                memory_order_relaxed,
+                memory_order_relaxed)) {
+                break;
+            }
+        } else if (TDS_IS_BEHIND(sequence, tail)) {
+            // The cell still holds the value from one lap ago.
+            return 0;
+        } else {
+            // Another producer got here first.
+            tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+
+    cell->value = value;
+    atomic_store_explicit(&cell->sequence, (TDS_SIZE_T)(tail + 1), memory_order_release);
+    return 1;
+}
+
+char TDS_FUNCTION(pop)(TDS_TYPE* queue, TDS_VALUE_T* value) {
+    TDS_SIZE_T head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    TDS_ENTRY_T* cell;
+    while (1) {
+        cell = queue->cells + (head & (queue->capacity - 1));
+        const TDS_SIZE_T sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        const TDS_SIZE_T filled = (TDS_SIZE_T)(head + 1);
+        if (sequence == filled) {
+            if (atomic_compare_exchange_weak_explicit(
+                &queue->head,
+                &head,
+                filled,
+                memory_order_relaxed,
+                memory_order_relaxed)) {
+                break;
+            }
+        } else if (TDS_IS_BEHIND(sequence, filled)) {
+            // No producer has filled the cell yet.
+            return 0;
+        } else {
+            // Another consumer got here first.
+            head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+
+    *value = cell->value;
+    // Free the cell for the producer one lap ahead.
+    atomic_store_explicit(&cell->sequence, (TDS_SIZE_T)(head + queue->capacity), memory_order_release);
+    return 1;
+}
+
+TDS_SIZE_T TDS_FUNCTION(count)(TDS_TYPE* queue) {
+    const TDS_SIZE_T head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    const TDS_SIZE_T tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    return (TDS_SIZE_T)(tail - head);
+}
+
+void TDS_FUNCTION(fini)(TDS_TYPE* queue) {
+#ifdef TDS_VALUE_FINI
+    TDS_VALUE_T value;
+    while (TDS_FUNCTION(pop)(queue, &value)) {
+        TDS_VALUE_FINI(value);
+    }
+#endif
+    tds_free(queue->allocator, queue->cells, queue->capacity * sizeof(TDS_ENTRY_T));
+    queue->cells = NULL;
+    queue->capacity = 0;
+}
+#endif
+
+#undef TDS_IS_BEHIND
+
+#include "private/end.inc"
@@ -71,9 +71,92 @@
 #endif
 #endif
 
-#ifndef TDS_INITIAL_CAPACITY
-#define TDS_INITIAL_CAPACITY 4
+#include <stddef.h>
+
+// Every container has an allocator field. While it's NULL, the container uses the global macros above, otherwise all of
+// its memory comes from reallocate. old_size is 0 for new allocations and new_size is 0 for frees, so that an arena can
+// grow its last allocation in place and ignore frees.
+typedef struct tds_allocator {
+    void* (*reallocate)(void* context, void* pointer, size_t old_size, size_t new_size);
+    void* context;
+} tds_allocator;
+
+static inline void* tds_reallocate(
+    const tds_allocator* allocator,
+    void* pointer,
+    const size_t old_size,
+    const size_t new_size
+) {
+    if (allocator) {
+        return allocator->reallocate(allocator->context, pointer, old_size, new_size);
+    }
+    if (!new_size) {
+        TDS_FREE(pointer);
+        return NULL;
+    }
+    return TDS_REALLOC(pointer, new_size);
+}
+
+static inline void* tds_callocate(const tds_allocator* allocator, const size_t size) {
+    if (!allocator) {
+        return TDS_CALLOC(1, size);
+    }
+    void* pointer = allocator->reallocate(allocator->context, NULL, 0, size);
+    if (pointer) {
+        TDS_MEMSET(pointer, 0, size);
+    }
+    return pointer;
+}
+
+static inline void tds_free(const tds_allocator* allocator, void* pointer, const size_t size) {
+    if (pointer) {
+        tds_reallocate(allocator, pointer, size, 0);
+    }
+}
+
+// How many keys the batched functions hash and prefetch before probing.
+#ifndef TDS_BATCH_SIZE
+#define TDS_BATCH_SIZE 16
 #endif
 
+// Fields of the concurrent containers written by different threads are kept this far apart to avoid false sharing.
+#ifndef TDS_CACHE_LINE_SIZE
+#define TDS_CACHE_LINE_SIZE 64
+#endif
+
+#ifndef TDS_PREFETCH
+#if defined(__GNUC__) || defined(__clang__)
+#define TDS_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define TDS_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#else
+#define TDS_PREFETCH(address) ((void)(address))
+#endif
+#endif
+
+// The hash tables keep a prime capacity. Returns the smallest prime in this roughly doubling table that is at least as
+// big as the required capacity, or the biggest one if none is.
+static inline unsigned long long tds_next_prime(const unsigned long long minimum) {
+    static const unsigned long long prime_list[] = {
+        2, 3, 5, 11, 17, 37, 67, 131, 257, 521, 1031, 2053, 4099, 8209, 16411, 32771, 65537, 131101, 262147,
+        524309, 1048583, 2097169, 4194319, 8388617, 16777259, 33554467, 67108879, 134217757, 268435459, 536870923,
+        1073741827, 2147483659, 4294967311, 8589934609, 17179869209, 34359738421, 68719476767, 137438953481,
+        274877906951, 549755813911, 1099511627791, 2199023255579, 4398046511119, 8796093022237, 17592186044423,
+        35184372088891, 70368744177679, 140737488355333, 281474976710677, 562949953421381, 1125899906842679,
+        2251799813685269, 4503599627370517, 9007199254740997, 18014398509482143, 36028797018963971,
+        72057594037928017, 144115188075855881, 288230376151711813, 576460752303423619, 1152921504606847009,
+        2305843009213693967, 4611686018427388039, 9223372036854775837ull,
+    };
+
+    for (unsigned i = 0; i < TDS_COUNTOF(prime_list); i++) {
+        if (prime_list[i] >= minimum) {
+            return prime_list[i];
+        }
+    }
+
+    return prime_list[TDS_COUNTOF(prime_list) - 1];
+}
+
 #define TDS_FUNCTION(name) TDS_JOIN3(TDS_TYPE, _, name)
 #endif
@@ -0,0 +1,106 @@
+#pragma once
+#ifndef _TDS_PRIVATE_GROUP_H_
+#define _TDS_PRIVATE_GROUP_H_
+
+#include <stdint.h>
+
+// Control bytes of the group-probed containers. A full slot stores the low 7 bits of its hash, so any control byte with
+// the sign bit set is one of the special markers below.
+#define TDS_CONTROL_EMPTY ((int8_t)-128)
+#define TDS_CONTROL_DELETED ((int8_t)-2)
+
+// How many control bytes are compared at once.
+#define TDS_GROUP_WIDTH 16
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TDS_GROUP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define TDS_GROUP_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Bitmask with one bit set for every control byte of a group that matched. NEON has no movemask instruction, so there
+// we keep the top bit of each nibble instead of one bit per byte. Use the functions below instead of assuming a layout.
+typedef uint64_t tds_group_mask;
+
+#ifdef TDS_GROUP_NEON
+#define TDS_GROUP_MASK_STRIDE 4
+#else
+#define TDS_GROUP_MASK_STRIDE 1
+#endif
+
+static inline unsigned tds_count_trailing_zeros(const uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&index, x);
+#else
+    if (_BitScanForward(&index, (unsigned long)x)) {
+        return (unsigned)index;
+    }
+    _BitScanForward(&index, (unsigned long)(x >> 32));
+    index += 32;
+#endif
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+#ifdef TDS_GROUP_NEON
+static inline tds_group_mask tds_group_neon_mask(const uint8x16_t comparison) {
+    // Narrowing shift packs byte i of the comparison into nibble i.
+    const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(comparison), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+}
+#endif
+
+static inline tds_group_mask tds_group_match(const int8_t* control, const int8_t h2) {
+#if defined(TDS_GROUP_SSE2)
+    const __m128i group = _mm_loadu_si128((const __m128i*)control);
+    return (tds_group_mask)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+#elif defined(TDS_GROUP_NEON)
+    return tds_group_neon_mask(vceqq_s8(vld1q_s8(control), vdupq_n_s8(h2)));
+#else
+    tds_group_mask mask = 0;
+    for (unsigned i = 0; i < TDS_GROUP_WIDTH; i++) {
+        mask |= (tds_group_mask)(control[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline tds_group_mask tds_group_match_empty(const int8_t* control) {
+    return tds_group_match(control, TDS_CONTROL_EMPTY);
+}
+
+static inline tds_group_mask tds_group_match_empty_or_deleted(const int8_t* control) {
+#if defined(TDS_GROUP_SSE2)
+    // Both markers have the sign bit set, which is exactly what movemask extracts.
+    return (tds_group_mask)(unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)control));
+#elif defined(TDS_GROUP_NEON)
+    return tds_group_neon_mask(vcltq_s8(vld1q_s8(control), vdupq_n_s8(0)));
+#else
+    tds_group_mask mask = 0;
+    for (unsigned i = 0; i < TDS_GROUP_WIDTH; i++) {
+        mask |= (tds_group_mask)(control[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+// Index inside the group of the lowest match. The mask must not be zero.
+static inline unsigned tds_group_mask_first(const tds_group_mask mask) {
+    return tds_count_trailing_zeros(mask) / TDS_GROUP_MASK_STRIDE;
+}
+
+// Drops the lowest match.
+static inline tds_group_mask tds_group_mask_next(const tds_group_mask mask) {
+    return mask & (mask - 1);
+}
+#endif
@@ -19,10 +19,17 @@ typedef struct TDS_TYPE {
     TDS_ENTRY_T* buckets;
     TDS_SIZE_T count;
     TDS_SIZE_T capacity; // Always a prime number.
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
 } TDS_TYPE;
 
 int TDS_FUNCTION(contains)(const TDS_TYPE* set, TDS_VALUE_T value);
+// Checks a batch of values, storing 1 or 0 for each in results (which may be NULL). Returns how many were found.
+TDS_SIZE_T TDS_FUNCTION(contains_many)(const TDS_TYPE* set, const TDS_VALUE_T* values, TDS_SIZE_T count, char* results);
+// Makes room for count values in total, so that many can be held without rehashing.
+void TDS_FUNCTION(reserve)(TDS_TYPE* set, TDS_SIZE_T count);
 void TDS_FUNCTION(add)(TDS_TYPE* set, TDS_VALUE_T value);
+// Adds count values, sizing the set once up front. On an empty set this is how to bulk-build one.
+void TDS_FUNCTION(add_many)(TDS_TYPE* set, const TDS_VALUE_T* values, TDS_SIZE_T count);
 void TDS_FUNCTION(remove)(TDS_TYPE* set, TDS_VALUE_T value);
 TDS_SIZE_T TDS_FUNCTION(count)(const TDS_TYPE* set);
 void TDS_FUNCTION(clear)(TDS_TYPE* set);
@@ -30,119 +37,75 @@ void TDS_FUNCTION(fini)(TDS_TYPE* set);
 #endif
 
 #ifdef TDS_IMPLEMENT
-int TDS_FUNCTION(contains)(const TDS_TYPE* set, const TDS_VALUE_T value) {
-    if (!set->buckets) {
-        return 0;
-    }
-    
-    const uint64_t hash = rapidhash(&value, sizeof(value));
+static int TDS_FUNCTION(_find)(const TDS_TYPE* set, const TDS_VALUE_T value, const uint64_t hash) {
     TDS_SIZE_T index = hash % set->capacity;
     // The "for" instead of a "while" loop is just to guard against infinite loops.
     for (TDS_SIZE_T i = 0; i < set->capacity; i++) {
         TDS_ENTRY_T* cur = set->buckets + index;
-    
+
         if (!cur->occupied) {
             // Value not found.
             return 0;
         }
-    
+
         if (cur->hash == hash && cur->value == value) {
             // Value found.
             return 1;
         }
-    
+
         index = (index + 1) % set->capacity;
     }
-    
+
     TDS_ASSERT(0);
     return 0;
 }
 
-void TDS_FUNCTION(add)(TDS_TYPE* set, const TDS_VALUE_T value) {
-    if (!set->buckets) {
-        // Yeah, we ignore TDS_INITIAL_CAPACITY here because we need the capacity to be a prime number.
-        // TODO: Well, use the next prime then.
-        set->capacity = 11;
-        set->buckets = TDS_CALLOC(set->capacity, sizeof(TDS_ENTRY_T));
-    }
-
-    TDS_SIZE_T index;
-  
-    // Ensure the set has room for at least one more entry.
-    // Check load factor > 0.75 by using integer math instead of floating-point math.
-    if ((set->count + 1) * 4 > set->capacity * 3) {
-        // Find the smaller prime number that is at least as big as the required capacity.
-        static const unsigned long long prime_list[] = {
-            2, 3, 5, 11, 17, 37, 67, 131, 257, 521, 1031, 2053, 4099, 8209, 16411, 32771, 65537, 131101, 262147,
-            524309, 1048583, 2097169, 4194319, 8388617, 16777259, 33554467, 67108879, 134217757, 268435459, 536870923,
-            1073741827, 2147483659, 4294967311, 8589934609, 17179869209, 34359738421, 68719476767, 137438953481,
-            274877906951, 549755813911, 1099511627791, 2199023255579, 4398046511119, 8796093022237, 17592186044423,
-            35184372088891, 70368744177679, 140737488355333, 281474976710677, 562949953421381, 1125899906842679,
-            2251799813685269, 4503599627370517, 9007199254740997, 18014398509482143, 36028797018963971,
-            72057594037928017, 144115188075855881, 288230376151711813, 576460752303423619, 1152921504606847009,
-            2305843009213693967, 4611686018427388039, 9223372036854775837ull,
-        };
+static void TDS_FUNCTION(_rehash)(TDS_TYPE* set, const TDS_SIZE_T new_capacity) {
+    TDS_ENTRY_T* new_buckets = tds_callocate(set->allocator, new_capacity * sizeof(TDS_ENTRY_T));
+    for (TDS_SIZE_T i = 0; i < set->capacity; i++) {
+        TDS_ENTRY_T entry = set->buckets[i];
+        if (!entry.occupied) {
+            continue;
+        }
 
-        TDS_SIZE_T new_capacity = set->capacity * 2;
-        if (new_capacity < set->capacity) {
-            // Handle overflow.
-            new_capacity = TDS_MAX_VALUE(TDS_SIZE_T);
-        } else {
-            for (unsigned i = 0; i < TDS_COUNTOF(prime_list); i++) {
-                if (prime_list[i] < new_capacity) {
-                    continue;
-                }
+        entry.probe_sequence_length = 0;
 
-                new_capacity = (TDS_SIZE_T)prime_list[i];
+        // Insert entry.
+        TDS_SIZE_T index = entry.hash % new_capacity;
+        while (1) {
+            TDS_ENTRY_T* cur = new_buckets + index;
+            if (!cur->occupied) {
+                new_buckets[index] = entry;
                 break;
             }
-        }
 
-        // Rehashing.
-        TDS_ENTRY_T* new_buckets = TDS_CALLOC(new_capacity, sizeof(TDS_ENTRY_T));
-        for (TDS_SIZE_T i = 0; i < set->capacity; i++) {
-            TDS_ENTRY_T entry = set->buckets[i];
-            if (!entry.occupied) {
-                continue;
-            }
-
-            entry.probe_sequence_length = 0;
-
-            // Insert entry.
-            index = entry.hash % new_capacity;
-            while (1) {
-                TDS_ENTRY_T* cur = new_buckets + index;
-                if (!cur->occupied) {
-                    new_buckets[index] = entry;
-                    break;
-                }
-
-                // Robin Hood: Swap if our probe distance is higher.
-                if (cur->probe_sequence_length < entry.probe_sequence_length) {
-                    const TDS_ENTRY_T temp = *cur;
-                    *cur = entry;
-                    entry = temp;
-                }
-                index = (index + 1) % new_capacity;
-                entry.probe_sequence_length++;
-                TDS_ASSERT(entry.probe_sequence_length < new_capacity);
+            // Robin Hood: Swap if our probe distance is higher.
+            if (cur->probe_sequence_length < entry.probe_sequence_length) {
+                const TDS_ENTRY_T temp = *cur;
+                *cur = entry;
+                entry = temp;
             }
+            index = (index + 1) % new_capacity;
+            entry.probe_sequence_length++;
+            TDS_ASSERT(entry.probe_sequence_length < new_capacity);
         }
-
-        TDS_FREE(set->buckets);
-        set->buckets = new_buckets;
-        set->capacity = new_capacity;
     }
 
-    // Do the insertion.
+    tds_free(set->allocator, set->buckets, set->capacity * sizeof(TDS_ENTRY_T));
+    set->buckets = new_buckets;
+    set->capacity = new_capacity;
+}
+
+// The caller must make sure there's room for one more entry.
+static void TDS_FUNCTION(_insert)(TDS_TYPE* set, const TDS_VALUE_T value, const uint64_t hash) {
     TDS_ENTRY_T new_entry = {
-        .hash = rapidhash(&value, sizeof(value)),
+        .hash = hash,
         .probe_sequence_length = 0,
         .value = value,
         .occupied = 1,
     };
 
-    index = new_entry.hash % set->capacity;
+    TDS_SIZE_T index = new_entry.hash % set->capacity;
     while (1) {
         TDS_ENTRY_T* cur = set->buckets + index;
         if (!cur->occupied) {
@@ -170,6 +133,106 @@ void TDS_FUNCTION(add)(TDS_TYPE* set, const TDS_VALUE_T value) {
     }
 }
 
+int TDS_FUNCTION(contains)(const TDS_TYPE* set, const TDS_VALUE_T value) {
+    if (!set->buckets) {
+        return 0;
+    }
+
+    return TDS_FUNCTION(_find)(set, value, rapidhash(&value, sizeof(value)));
+}
+
+TDS_SIZE_T TDS_FUNCTION(contains_many)(
+    const TDS_TYPE* set,
+    const TDS_VALUE_T* values,
+    const TDS_SIZE_T count,
+    char* results
+) {
+    TDS_SIZE_T found = 0;
+    if (!set->buckets) {
+        if (results) {
+            TDS_MEMSET(results, 0, count);
+        }
+        return found;
+    }
+
+    uint64_t hashes[TDS_BATCH_SIZE];
+    for (TDS_SIZE_T batch = 0; batch < count; batch += TDS_BATCH_SIZE) {
+        const TDS_SIZE_T batch_count = count - batch < TDS_BATCH_SIZE ? count - batch : TDS_BATCH_SIZE;
+
+        // Hash the whole batch and prefetch its buckets first, so the cache misses overlap instead of being paid one
+        // after the other.
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            hashes[i] = rapidhash(&values[batch + i], sizeof(values[batch + i]));
+            TDS_PREFETCH(set->buckets + hashes[i] % set->capacity);
+        }
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            const int contained = TDS_FUNCTION(_find)(set, values[batch + i], hashes[i]);
+            if (results) {
+                results[batch + i] = (char)contained;
+            }
+            found += (TDS_SIZE_T)contained;
+        }
+    }
+
+    return found;
+}
+
+void TDS_FUNCTION(reserve)(TDS_TYPE* set, const TDS_SIZE_T count) {
+    // Smallest capacity that keeps the load factor at or below 0.75.
+    unsigned long long required = (unsigned long long)count + (count + 2) / 3;
+    if (set->buckets && required <= set->capacity) {
+        return;
+    }
+
+    required = tds_next_prime(required);
+    TDS_FUNCTION(_rehash)(set, required > TDS_MAX_VALUE(TDS_SIZE_T) ? TDS_MAX_VALUE(TDS_SIZE_T) : (TDS_SIZE_T)required);
+}
+
+void TDS_FUNCTION(add)(TDS_TYPE* set, const TDS_VALUE_T value) {
+    if (!set->buckets) {
+        TDS_FUNCTION(reserve)(set, TDS_INITIAL_CAPACITY);
+    }
+
+    // Ensure the set has room for at least one more entry.
+    // Check load factor > 0.75 by using integer math instead of floating-point math.
+    if ((set->count + 1) * 4 > set->capacity * 3) {
+        TDS_SIZE_T new_capacity = set->capacity * 2;
+        if (new_capacity < set->capacity) {
+            // Handle overflow.
+            new_capacity = TDS_MAX_VALUE(TDS_SIZE_T);
+        } else {
+            // Find the smaller prime number that is at least as big as the required capacity.
+            const unsigned long long prime = tds_next_prime(new_capacity);
+            new_capacity = prime > TDS_MAX_VALUE(TDS_SIZE_T) ? TDS_MAX_VALUE(TDS_SIZE_T) : (TDS_SIZE_T)prime;
+        }
+
+        TDS_FUNCTION(_rehash)(set, new_capacity);
+    }
+
+    // Do the insertion.
+    TDS_FUNCTION(_insert)(set, value, rapidhash(&value, sizeof(value)));
+}
+
+void TDS_FUNCTION(add_many)(TDS_TYPE* set, const TDS_VALUE_T* values, const TDS_SIZE_T count) {
+    // Size for the worst case of every value being new, so the loop below never rehashes.
+    TDS_FUNCTION(reserve)(set, set->count + count);
+
+    uint64_t hashes[TDS_BATCH_SIZE];
+    for (TDS_SIZE_T batch = 0; batch < count; batch += TDS_BATCH_SIZE) {
+        const TDS_SIZE_T batch_count = count - batch < TDS_BATCH_SIZE ? count - batch : TDS_BATCH_SIZE;
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            hashes[i] = rapidhash(&values[batch + i], sizeof(values[batch + i]));
+            TDS_PREFETCH(set->buckets + hashes[i] % set->capacity);
+        }
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            TDS_FUNCTION(_insert)(set, values[batch + i], hashes[i]);
+        }
+    }
+}
+
 void TDS_FUNCTION(remove)(TDS_TYPE* set, const TDS_VALUE_T value) {
     if (!set->buckets) {
         return;
@@ -247,8 +310,8 @@ void TDS_FUNCTION(fini)(TDS_TYPE* set) {
         TDS_VALUE_FINI((it.value));
     }
 #endif
-    TDS_FREE(set->buckets);
-    *set = (TDS_TYPE){ 0 };
+    tds_free(set->allocator, set->buckets, set->capacity * sizeof(TDS_ENTRY_T));
+    *set = (TDS_TYPE){ .allocator = set->allocator };
 }
 #endif
 
@@ -0,0 +1,108 @@
+#include "private/common.h"
+#include "private/begin.inc"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread. The ring is allocated once by init and
+// push fails instead of growing, so neither side ever allocates or blocks. Each side keeps a private copy of the index
+// owned by the other one and only reloads it when the ring looks full or empty, which keeps the cache lines of the two
+// threads apart in the common case.
+
+#ifndef TDS_TYPE
+#define TDS_TYPE TDS_DEFAULT_TYPE_W_VALUE(spsc_queue)
+#endif
+
+#ifdef TDS_DECLARE
+typedef struct TDS_TYPE {
+    // Written by init only.
+    TDS_VALUE_T* array;
+    TDS_SIZE_T capacity; // Always a power of two.
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
+
+    // Owned by the producer. Indices only ever increase and are wrapped when indexing into array.
+    alignas(TDS_CACHE_LINE_SIZE) _Atomic(TDS_SIZE_T) tail;
+    TDS_SIZE_T cached_head;
+
+    // Owned by the consumer.
+    alignas(TDS_CACHE_LINE_SIZE) _Atomic(TDS_SIZE_T) head;
+    TDS_SIZE_T cached_tail;
+} TDS_TYPE;
+
+// Allocates room for at least capacity values. Not thread safe, call it before handing the queue out.
+void TDS_FUNCTION(init)(TDS_TYPE* queue, TDS_SIZE_T capacity);
+// Producer only. Returns 0 if the queue is full.
+char TDS_FUNCTION(push)(TDS_TYPE* queue, TDS_VALUE_T value);
+// Consumer only. Returns 0 if the queue is empty.
+char TDS_FUNCTION(pop)(TDS_TYPE* queue, TDS_VALUE_T* value);
+// Only exact while neither side is running, otherwise a snapshot.
+TDS_SIZE_T TDS_FUNCTION(count)(TDS_TYPE* queue);
+void TDS_FUNCTION(fini)(TDS_TYPE* queue);
+#endif
+
+#ifdef TDS_IMPLEMENT
+void TDS_FUNCTION(init)(TDS_TYPE* queue, const TDS_SIZE_T capacity) {
+    // Guard against overflow, the distance between the indices has to fit.
+    TDS_ASSERT(capacity && capacity <= TDS_MAX_VALUE(TDS_SIZE_T) / 2 + 1);
+
+    TDS_SIZE_T new_capacity = 1;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    queue->array = tds_reallocate(queue->allocator, NULL, 0, new_capacity * sizeof(TDS_VALUE_T));
+    queue->capacity = new_capacity;
+    atomic_init(&queue->tail, 0);
+    queue->cached_head = 0;
+    atomic_init(&queue->head, 0);
+    queue->cached_tail = 0;
+}
+
+char TDS_FUNCTION(push)(TDS_TYPE* queue, const TDS_VALUE_T value) {
+    const TDS_SIZE_T tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if ((TDS_SIZE_T)(tail - queue->cached_head) == queue->capacity) {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if ((TDS_SIZE_T)(tail - queue->cached_head) == queue->capacity) {
+            return 0;
+        }
+    }
+
+    queue->array[tail & (queue->capacity - 1)] = value;
+    atomic_store_explicit(&queue->tail, (TDS_SIZE_T)(tail + 1), memory_order_release);
+    return 1;
+}
+
+char TDS_FUNCTION(pop)(TDS_TYPE* queue, TDS_VALUE_T* value) {
+    const TDS_SIZE_T head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head == queue->cached_tail) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->cached_tail) {
+            return 0;
+        }
+    }
+
+    *value = queue->array[head & (queue->capacity - 1)];
+    atomic_store_explicit(&queue->head, (TDS_SIZE_T)(head + 1), memory_order_release);
+    return 1;
+}
+
+TDS_SIZE_T TDS_FUNCTION(count)(TDS_TYPE* queue) {
+    const TDS_SIZE_T head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    const TDS_SIZE_T tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    return (TDS_SIZE_T)(tail - head);
+}
+
+void TDS_FUNCTION(fini)(TDS_TYPE* queue) {
+#ifdef TDS_VALUE_FINI
+    TDS_VALUE_T value;
+    while (TDS_FUNCTION(pop)(queue, &value)) {
+        TDS_VALUE_FINI(value);
+    }
+#endif
+    tds_free(queue->allocator, queue->array, queue->capacity * sizeof(TDS_VALUE_T));
+    queue->array = NULL;
+    queue->capacity = 0;
+}
+#endif
+
+#include "private/end.inc"
@@ -0,0 +1,360 @@
+#include "private/common.h"
+#include "private/group.h"
+#include "private/begin.inc"
+
+// Same API as hashmap.h, different layout: keys and values live in a dense slot array and probing only reads a separate
+// array of one control byte per slot, holding 7 bits of the hash of the key in it or an empty/deleted marker. Control
+// bytes are compared a whole group at a time, so a miss is usually answered after loading 16 bytes and no slot at all.
+
+#ifndef TDS_TYPE
+#define TDS_TYPE TDS_DEFAULT_TYPE_W_KEY_VALUE(swiss_hashmap)
+#endif
+
+#define TDS_ENTRY_T TDS_JOIN2(TDS_TYPE, _slot)
+
+#ifdef TDS_DECLARE
+typedef struct TDS_ENTRY_T {
+    TDS_KEY_T key;
+    TDS_VALUE_T value;
+} TDS_ENTRY_T;
+
+typedef struct TDS_TYPE {
+    int8_t* control;
+    TDS_ENTRY_T* slots;
+    TDS_SIZE_T count;
+    TDS_SIZE_T capacity; // Always a power of two, and at least TDS_GROUP_WIDTH.
+    TDS_SIZE_T growth_left; // Inserts left before rehashing. Deleted slots are not given back until then.
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
+} TDS_TYPE;
+
+typedef struct TDS_JOIN2(TDS_TYPE, _iter_t) {
+    const TDS_TYPE* map;
+    TDS_SIZE_T _index;
+    TDS_KEY_T key;
+    TDS_VALUE_T* value;
+} TDS_JOIN2(TDS_TYPE, _iter_t);
+
+TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key);
+// Looks up a batch of keys, storing a pointer to each value (or NULL) in results. Returns how many were found.
+TDS_SIZE_T TDS_FUNCTION(get_many)(const TDS_TYPE* map, const TDS_KEY_T* keys, TDS_SIZE_T count, TDS_VALUE_T** results);
+// Makes room for count entries in total, so that many can be held without rehashing.
+void TDS_FUNCTION(reserve)(TDS_TYPE* map, TDS_SIZE_T count);
+void TDS_FUNCTION(set)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value);
+// Sets count key-value pairs, sizing the map once up front. On an empty map this is how to bulk-build one.
+void TDS_FUNCTION(set_many)(TDS_TYPE* map, const TDS_KEY_T* keys, const TDS_VALUE_T* values, TDS_SIZE_T count);
+TDS_JOIN2(TDS_TYPE, _iter_t) TDS_FUNCTION(iter)(const TDS_TYPE* map);
+char TDS_FUNCTION(next)(TDS_JOIN2(TDS_TYPE, _iter_t)* iter);
+void TDS_FUNCTION(remove)(TDS_TYPE* map, TDS_KEY_T key);
+TDS_SIZE_T TDS_FUNCTION(count)(const TDS_TYPE* map);
+void TDS_FUNCTION(clear)(TDS_TYPE* map);
+void TDS_FUNCTION(fini)(TDS_TYPE* map);
+#endif
+
+#ifdef TDS_IMPLEMENT
+// Maximum load factor of 7/8, the usual choice for this kind of table.
+#define TDS_MAX_GROWTH(capacity) ((capacity) - (capacity) / 8)
+
+// Returns the slot index holding the key, or TDS_MAX_VALUE(TDS_SIZE_T) if it's not in the map.
+static TDS_SIZE_T TDS_FUNCTION(_find)(const TDS_TYPE* map, TDS_KEY_T key, const uint64_t hash) {
+    const int8_t h2 = (int8_t)(hash & 0x7f);
+    const TDS_SIZE_T group_mask = map->capacity / TDS_GROUP_WIDTH - 1;
+    TDS_SIZE_T group = (TDS_SIZE_T)(hash >> 7) & group_mask;
+
+    // Triangular probing over groups visits every group exactly once when the group count is a power of two.
+    for (TDS_SIZE_T step = 1; step <= group_mask + 1; step++) {
+        const int8_t* control = map->control + group * TDS_GROUP_WIDTH;
+
+        for (tds_group_mask matches = tds_group_match(control, h2); matches; matches = tds_group_mask_next(matches)) {
+            const TDS_SIZE_T index = group * TDS_GROUP_WIDTH + tds_group_mask_first(matches);
+#ifdef TDS_KEY_EQUALS
+            if (TDS_KEY_EQUALS(map->slots[index].key, key)) {
+#else
+            if (map->slots[index].key == key) {
+#endif
+                return index;
+            }
+        }
+
+        if (tds_group_match_empty(control)) {
+            // An insert would have stopped here, so the key can't be further along.
+            return TDS_MAX_VALUE(TDS_SIZE_T);
+        }
+
+        group = (group + step) & group_mask;
+    }
+
+    return TDS_MAX_VALUE(TDS_SIZE_T);
+}
+
+// First empty or deleted slot along the probe sequence of the hash. The map must have at least one.
+static TDS_SIZE_T TDS_FUNCTION(_find_free)(const TDS_TYPE* map, const uint64_t hash) {
+    const TDS_SIZE_T group_mask = map->capacity / TDS_GROUP_WIDTH - 1;
+    TDS_SIZE_T group = (TDS_SIZE_T)(hash >> 7) & group_mask;
+
+    for (TDS_SIZE_T step = 1; step <= group_mask + 1; step++) {
+        const tds_group_mask available = tds_group_match_empty_or_deleted(map->control + group * TDS_GROUP_WIDTH);
+        if (available) {
+            return group * TDS_GROUP_WIDTH + tds_group_mask_first(available);
+        }
+
+        group = (group + step) & group_mask;
+    }
+
+    TDS_ASSERT(0);
+    return TDS_MAX_VALUE(TDS_SIZE_T);
+}
+
+static void TDS_FUNCTION(_rehash)(TDS_TYPE* map, const TDS_SIZE_T new_capacity) {
+    TDS_ASSERT(new_capacity >= TDS_GROUP_WIDTH && !(new_capacity & (new_capacity - 1)));
+    TDS_ASSERT(map->count <= TDS_MAX_GROWTH(new_capacity));
+
+    TDS_TYPE new_map = {
+        .control = tds_reallocate(map->allocator, NULL, 0, new_capacity),
+        .slots = tds_reallocate(map->allocator, NULL, 0, new_capacity * sizeof(TDS_ENTRY_T)),
+        .count = map->count,
+        .capacity = new_capacity,
+        .growth_left = TDS_MAX_GROWTH(new_capacity) - map->count,
+        .allocator = map->allocator,
+    };
+    TDS_MEMSET(new_map.control, TDS_CONTROL_EMPTY, new_capacity);
+
+    // Every key is known to be unique, so skip the lookups and drop each one in the first free slot.
+    for (TDS_SIZE_T i = 0; i < map->capacity; i++) {
+        if (map->control[i] < 0) {
+            continue;
+        }
+
+        const uint64_t hash = TDS_HASH_KEY(map->slots[i].key);
+        const TDS_SIZE_T index = TDS_FUNCTION(_find_free)(&new_map, hash);
+        new_map.control[index] = (int8_t)(hash & 0x7f);
+        new_map.slots[index] = map->slots[i];
+    }
+
+    tds_free(map->allocator, map->control, map->capacity);
+    tds_free(map->allocator, map->slots, map->capacity * sizeof(TDS_ENTRY_T));
+    *map = new_map;
+}
+
+// Updates the key if it's already there, otherwise takes a free slot. The caller must make sure growth is left.
+static void TDS_FUNCTION(_insert)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value, const uint64_t hash) {
+    TDS_SIZE_T index = TDS_FUNCTION(_find)(map, key, hash);
+    if (index != TDS_MAX_VALUE(TDS_SIZE_T)) {
+        // Key matches, update the value.
+        map->slots[index].value = value;
+        return;
+    }
+
+    TDS_ASSERT(map->growth_left);
+    index = TDS_FUNCTION(_find_free)(map, hash);
+    // Reusing a deleted slot doesn't shorten any probe sequence, so only empty slots consume growth.
+    map->growth_left -= map->control[index] == TDS_CONTROL_EMPTY;
+    map->control[index] = (int8_t)(hash & 0x7f);
+    map->slots[index] = (TDS_ENTRY_T){
+        .key = key,
+        .value = value,
+    };
+    map->count++;
+}
+
+TDS_VALUE_T* TDS_FUNCTION(get)(const TDS_TYPE* map, TDS_KEY_T key) {
+    if (!map->control) {
+        return NULL;
+    }
+
+    const TDS_SIZE_T index = TDS_FUNCTION(_find)(map, key, TDS_HASH_KEY(key));
+    return index == TDS_MAX_VALUE(TDS_SIZE_T) ? NULL : &map->slots[index].value;
+}
+
+TDS_SIZE_T TDS_FUNCTION(get_many)(
+    const TDS_TYPE* map,
+    const TDS_KEY_T* keys,
+    const TDS_SIZE_T count,
+    TDS_VALUE_T** results
+) {
+    TDS_SIZE_T found = 0;
+    if (!map->control) {
+        for (TDS_SIZE_T i = 0; i < count; i++) {
+            results[i] = NULL;
+        }
+        return found;
+    }
+
+    const TDS_SIZE_T group_mask = map->capacity / TDS_GROUP_WIDTH - 1;
+    uint64_t hashes[TDS_BATCH_SIZE];
+    for (TDS_SIZE_T batch = 0; batch < count; batch += TDS_BATCH_SIZE) {
+        const TDS_SIZE_T batch_count = count - batch < TDS_BATCH_SIZE ? count - batch : TDS_BATCH_SIZE;
+
+        // Hash the whole batch and prefetch the first group of each key, so the cache misses overlap.
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            const TDS_KEY_T key = keys[batch + i];
+            hashes[i] = TDS_HASH_KEY(key);
+            TDS_PREFETCH(map->control + ((TDS_SIZE_T)(hashes[i] >> 7) & group_mask) * TDS_GROUP_WIDTH);
+        }
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            const TDS_SIZE_T index = TDS_FUNCTION(_find)(map, keys[batch + i], hashes[i]);
+            results[batch + i] = index == TDS_MAX_VALUE(TDS_SIZE_T) ? NULL : &map->slots[index].value;
+            found += index != TDS_MAX_VALUE(TDS_SIZE_T);
+        }
+    }
+
+    return found;
+}
+
+void TDS_FUNCTION(reserve)(TDS_TYPE* map, const TDS_SIZE_T count) {
+    if (map->control && count <= map->count + map->growth_left) {
+        return;
+    }
+
+    TDS_SIZE_T new_capacity = map->control ? map->capacity : TDS_GROUP_WIDTH;
+    while (TDS_MAX_GROWTH(new_capacity) < count) {
+        // Guard against overflow.
+        TDS_ASSERT(new_capacity <= TDS_MAX_VALUE(TDS_SIZE_T) / 2);
+        new_capacity *= 2;
+    }
+    TDS_FUNCTION(_rehash)(map, new_capacity);
+}
+
+void TDS_FUNCTION(set)(TDS_TYPE* map, TDS_KEY_T key, TDS_VALUE_T value) {
+    const uint64_t hash = TDS_HASH_KEY(key);
+
+    if (!map->control) {
+        TDS_FUNCTION(reserve)(map, TDS_INITIAL_CAPACITY);
+    } else if (!map->growth_left) {
+        const TDS_SIZE_T index = TDS_FUNCTION(_find)(map, key, hash);
+        if (index != TDS_MAX_VALUE(TDS_SIZE_T)) {
+            // Key matches, update the value. No need to grow for that.
+            map->slots[index].value = value;
+            return;
+        }
+
+        // If deleted slots are what's eating the budget, rehashing at the same size is enough to get it back.
+        TDS_SIZE_T new_capacity = map->capacity;
+        if (map->count * 2 >= TDS_MAX_GROWTH(map->capacity)) {
+            // Guard against overflow.
+            TDS_ASSERT(map->capacity <= TDS_MAX_VALUE(TDS_SIZE_T) / 2);
+            new_capacity *= 2;
+        }
+        TDS_FUNCTION(_rehash)(map, new_capacity);
+    }
+
+    TDS_FUNCTION(_insert)(map, key, value, hash);
+}
+
+void TDS_FUNCTION(set_many)(TDS_TYPE* map, const TDS_KEY_T* keys, const TDS_VALUE_T* values, const TDS_SIZE_T count) {
+    // Size for the worst case of every key being new, so the loop below never rehashes.
+    TDS_FUNCTION(reserve)(map, map->count + count);
+
+    const TDS_SIZE_T group_mask = map->capacity / TDS_GROUP_WIDTH - 1;
+    uint64_t hashes[TDS_BATCH_SIZE];
+    for (TDS_SIZE_T batch = 0; batch < count; batch += TDS_BATCH_SIZE) {
+        const TDS_SIZE_T batch_count = count - batch < TDS_BATCH_SIZE ? count - batch : TDS_BATCH_SIZE;
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            const TDS_KEY_T key = keys[batch + i];
+            hashes[i] = TDS_HASH_KEY(key);
+            TDS_PREFETCH(map->control + ((TDS_SIZE_T)(hashes[i] >> 7) & group_mask) * TDS_GROUP_WIDTH);
+        }
+
+        for (TDS_SIZE_T i = 0; i < batch_count; i++) {
+            TDS_FUNCTION(_insert)(map, keys[batch + i], values[batch + i], hashes[i]);
+        }
+    }
+}
+
+TDS_JOIN2(TDS_TYPE, _iter_t) TDS_FUNCTION(iter)(const TDS_TYPE* map) {
+    return (TDS_JOIN2(TDS_TYPE, _iter_t)) {
+        .map = map,
+        ._index = 0,
+    };
+}
+
+char TDS_FUNCTION(next)(TDS_JOIN2(TDS_TYPE, _iter_t)* iter) {
+    while (iter->_index < iter->map->capacity) {
+        const TDS_SIZE_T index = iter->_index++;
+        if (iter->map->control[index] >= 0) {
+            iter->key = iter->map->slots[index].key;
+            iter->value = &iter->map->slots[index].value;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void TDS_FUNCTION(remove)(TDS_TYPE* map, TDS_KEY_T key) {
+    if (!map->control) {
+        return;
+    }
+
+    const TDS_SIZE_T index = TDS_FUNCTION(_find)(map, key, TDS_HASH_KEY(key));
+    if (index == TDS_MAX_VALUE(TDS_SIZE_T)) {
+        // Key not found.
+        return;
+    }
+
+#ifdef TDS_KEY_FINI
+    TDS_KEY_FINI((map->slots[index].key));
+#endif
+#ifdef TDS_VALUE_FINI
+    TDS_VALUE_FINI((map->slots[index].value));
+#endif
+    map->count--;
+
+    // Lookups stop at the first group with an empty slot. If this group already had one, no probe sequence ever went
+    // past it and the slot can be emptied for real. Otherwise leave a tombstone so later keys are still reachable.
+    int8_t* control = map->control + index / TDS_GROUP_WIDTH * TDS_GROUP_WIDTH;
+    if (tds_group_match_empty(control)) {
+        map->control[index] = TDS_CONTROL_EMPTY;
+        map->growth_left++;
+    } else {
+        map->control[index] = TDS_CONTROL_DELETED;
+    }
+}
+
+TDS_SIZE_T TDS_FUNCTION(count)(const TDS_TYPE* map) {
+    return map->count;
+}
+
+void TDS_FUNCTION(clear)(TDS_TYPE* map) {
+#if defined(TDS_VALUE_FINI) || defined(TDS_KEY_FINI)
+    TDS_JOIN2(TDS_TYPE, _iter_t) it = TDS_FUNCTION(iter)(map);
+    while (TDS_FUNCTION(next)(&it)) {
+#ifdef TDS_KEY_FINI
+        TDS_KEY_FINI(it.key);
+#endif
+#ifdef TDS_VALUE_FINI
+        TDS_VALUE_FINI(*it.value);
+#endif
+    }
+#endif
+    if (map->control) {
+        TDS_MEMSET(map->control, TDS_CONTROL_EMPTY, map->capacity);
+        map->growth_left = TDS_MAX_GROWTH(map->capacity);
+    }
+    map->count = 0;
+}
+
+void TDS_FUNCTION(fini)(TDS_TYPE* map) {
+#if defined(TDS_VALUE_FINI) || defined(TDS_KEY_FINI)
+    if (map->control) {
+        TDS_JOIN2(TDS_TYPE, _iter_t) it = TDS_FUNCTION(iter)(map);
+        while (TDS_FUNCTION(next)(&it)) {
+#ifdef TDS_KEY_FINI
+            TDS_KEY_FINI(it.key);
+#endif
+#ifdef TDS_VALUE_FINI
+            TDS_VALUE_FINI(*it.value);
+#endif
+        }
+    }
+#endif
+    tds_free(map->allocator, map->control, map->capacity);
+    tds_free(map->allocator, map->slots, map->capacity * sizeof(TDS_ENTRY_T));
+    *map = (TDS_TYPE){ .allocator = map->allocator };
+}
+
+#undef TDS_MAX_GROWTH
+#endif
+
+#include "private/end.inc"
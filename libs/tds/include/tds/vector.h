@@ -9,6 +9,7 @@
 typedef struct TDS_TYPE {
     TDS_VALUE_T* array;
     TDS_SIZE_T count, capacity;
+    const tds_allocator* allocator; // NULL uses the global TDS_REALLOC and TDS_FREE.
 } TDS_TYPE;
 
 void TDS_FUNCTION(append)(TDS_TYPE* vec, TDS_VALUE_T value);
@@ -32,8 +33,12 @@ void TDS_FUNCTION(append)(TDS_TYPE* vec, const TDS_VALUE_T value) {
             // Guard against overflow.
             new_capacity = TDS_MAX_VALUE(TDS_SIZE_T);
         }
+        vec->array = tds_reallocate(
+            vec->allocator,
+            vec->array,
+            sizeof(TDS_VALUE_T) * vec->capacity,
+            sizeof(TDS_VALUE_T) * new_capacity);
         vec->capacity = new_capacity;
-        vec->array = TDS_REALLOC(vec->array, sizeof(TDS_VALUE_T) * vec->capacity);
     }
 
     vec->array[vec->count] = value;
@@ -82,8 +87,8 @@ void TDS_FUNCTION(fini)(TDS_TYPE* vec) {
         TDS_VALUE_FINI(vec->array[i]);
     }
 #endif
-    TDS_FREE(vec->array);
-    *vec = (TDS_TYPE){ 0 };
+    tds_free(vec->allocator, vec->array, sizeof(TDS_VALUE_T) * vec->capacity);
+    *vec = (TDS_TYPE){ .allocator = vec->allocator };
 }
 #endif
 
@@ -1,8 +1,14 @@
 import argparse
-import shutil
+from concurrent.futures import ProcessPoolExecutor
+import hashlib
+import json
+import os
+import struct
 import subprocess
 from pathlib import Path
 import sys
+import tempfile
+import zlib
 
 # ---------------- CONFIG ----------------
 
@@ -23,7 +29,28 @@ SHADER_DIRS = [
 
 SHADER_STAGES = {'vert', 'frag', 'comp'}
 
+BLOCK_REGISTRY = SOURCE_DIR / 'blocks.json'
+BLOCK_NAME_LENGTH = 32
+# Which texture of a block goes on each face, in the order of the faces in cube.vert.
+BLOCK_FACE_TEXTURES = ['sides', 'sides', 'top', 'bottom', 'sides', 'sides']
+BLOCK_LIGHT_MAX = 15
+
 ASTCENC_COMMAND = 'astcenc-avx2'
+ASTCENC_OPTIONS = ['4x4', '-exhaustive']
+GLSLC_OPTIONS = ['--target-env=vulkan1.0']
+
+# Built assets are kept here by the hash of their source and options, so unchanged assets are skipped.
+CACHE_DIR = Path('.asset-cache')
+CACHE_MANIFEST = CACHE_DIR / 'manifest.json'
+# Bump when a change to this script changes what it builds from the same sources.
+CACHE_VERSION = 1
+
+# Everything the game loads at runtime goes in one pack per platform, see write_pack().
+PACK_NAME = 'assets.ncpak'
+PACK_MAGIC = b'NCPK'
+PACK_VERSION = 1
+PACK_ALIGNMENT = 16
+PACK_ENTRY_NAME_LENGTH = 56
 
 # ---------------------------------------
 
@@ -66,84 +93,477 @@ def strip_exif_if_requested(path: Path, enabled: bool):
     clean.save(path)
 
 
-def process_textures(compress_android, strip_exif):
-    for base_dir in TEXTURE_DIRS:
-        for img in base_dir.rglob('*'):
-            if img.suffix.lower() not in IMAGE_EXTS:
-                continue
+def decode_png(path: Path):
+    """Decodes an 8-bit, non-interlaced RGB or RGBA PNG to its size and tightly packed RGBA rows."""
+    data = path.read_bytes()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError(f'{path} is not a PNG file.')
+
+    header = None
+    compressed = bytearray()
+    position = 8
+    while position < len(data):
+        length, kind = struct.unpack('>I4s', data[position:position + 8])
+        chunk = data[position + 8:position + 8 + length]
+        position += length + 12
+        if kind == b'IHDR':
+            header = struct.unpack('>IIBBBBB', chunk)
+        elif kind == b'IDAT':
+            compressed += chunk
+        elif kind == b'IEND':
+            break
+
+    width, height, bit_depth, color_type, _, _, interlace = header
+    if bit_depth != 8 or color_type not in (2, 6) or interlace:
+        raise ValueError(f'{path}: only 8-bit, non-interlaced RGB and RGBA PNGs are supported.')
+
+    channels = 4 if color_type == 6 else 3
+    stride = width * channels
+    filtered = zlib.decompress(compressed)
+    previous = bytearray(stride)
+    pixels = bytearray()
+    for y in range(height):
+        start = y * (stride + 1)
+        filter_type = filtered[start]
+        row = bytearray(filtered[start + 1:start + 1 + stride])
+        for i in range(stride):
+            left = row[i - channels] if i >= channels else 0
+            up = previous[i]
+            up_left = previous[i - channels] if i >= channels else 0
+            if filter_type == 1:
+                row[i] = (row[i] + left) & 0xFF
+            elif filter_type == 2:
+                row[i] = (row[i] + up) & 0xFF
+            elif filter_type == 3:
+                row[i] = (row[i] + (left + up) // 2) & 0xFF
+            elif filter_type == 4:
+                estimate = left + up - up_left
+                distances = (abs(estimate - left), abs(estimate - up), abs(estimate - up_left))
+                predictor = (left, up, up_left)[distances.index(min(distances))]
+                row[i] = (row[i] + predictor) & 0xFF
+
+        if channels == 3:
+            pixels += b''.join(bytes(row[i:i + 3]) + b'\xff' for i in range(0, stride, 3))
+        else:
+            pixels += row
+        previous = row
+
+    return width, height, bytes(pixels)
+
+
+def encode_png(path: Path, width, height, pixels):
+    """Writes tightly packed RGBA rows as an unfiltered PNG, for tools that only take image files."""
+    def chunk(kind, data):
+        return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data))
+
+    stride = width * 4
+    rows = b''.join(b'\x00' + pixels[y * stride:(y + 1) * stride] for y in range(height))
+    path.write_bytes(
+        b'\x89PNG\r\n\x1a\n'
+        + chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 6, 0, 0, 0))
+        + chunk(b'IDAT', zlib.compress(rows, 9))
+        + chunk(b'IEND', b''))
+
+
+def mip_chain(width, height, pixels):
+    """
+    Returns every mip level of a square, power of two RGBA image down to 1x1, largest first. Each level is a 2x2 box filter
+    of the previous one, averaging the texels as stored since the game samples them as UNORM.
+    """
+    levels = [pixels]
+    while width > 1:
+        source = levels[-1]
+        width //= 2
+        height //= 2
+        level = bytearray(width * height * 4)
+        for y in range(height):
+            for x in range(width):
+                for channel in range(4):
+                    top = ((y * 2) * width * 2 + x * 2) * 4 + channel
+                    bottom = top + width * 2 * 4
+                    total = source[top] + source[top + 4] + source[bottom] + source[bottom + 4]
+                    level[(y * width + x) * 4 + channel] = (total + 2) // 4
+        levels.append(bytes(level))
+    return levels
+
+
+def rgb565(color):
+    return (color[0] >> 3) << 11 | (color[1] >> 2) << 5 | color[2] >> 3
+
+
+def bc1_palette(color0, color1):
+    """The 4 RGBA colors a BC1 block with these RGB565 endpoints decodes to, rounded like the decoder in main.c."""
+    def expand(color):
+        red, green, blue = color >> 11, color >> 5 & 0x3F, color & 0x1F
+        return red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2
+
+    a, b = expand(color0), expand(color1)
+    if color0 > color1:
+        return [
+            (*a, 255),
+            (*b, 255),
+            (*((2 * x + y) // 3 for x, y in zip(a, b)), 255),
+            (*((x + 2 * y) // 3 for x, y in zip(a, b)), 255),
+        ]
+    # The 3 color mode, which spends the last index on transparent black.
+    return [(*a, 255), (*b, 255), (*((x + y) // 2 for x, y in zip(a, b)), 255), (0, 0, 0, 0)]
+
+
+def bc1_block(texels):
+    """
+    Encodes 16 RGBA texels as a BC1 block. Texels with alpha under 128 become transparent, which costs the block its
+    fourth color. Endpoints are searched among the block's own colors and its bounding box, which suits the few-color
+    textures we have.
+    """
+    transparent = [texel[3] < 128 for texel in texels]
+    opaque = [texel for texel, clear in zip(texels, transparent) if not clear]
+    candidates = {rgb565(texel) for texel in opaque}
+    if opaque:
+        candidates.add(rgb565([min(texel[i] for texel in opaque) for i in range(3)]))
+        candidates.add(rgb565([max(texel[i] for texel in opaque) for i in range(3)]))
+    candidates = sorted(candidates) or [0]
+
+    best = None
+    for i, low in enumerate(candidates):
+        for high in candidates[i:]:
+            # The order of the endpoints selects the mode.
+            color0, color1 = (low, high) if any(transparent) else (high, low)
+            palette = bc1_palette(color0, color1)
+            usable = range(4) if color0 > color1 else range(3)
+            error = 0
+            indices = 0
+            for texel_index, (texel, clear) in enumerate(zip(texels, transparent)):
+                if clear:
+                    index = 3
+                else:
+                    distances = [sum((texel[c] - palette[j][c]) ** 2 for c in range(3)) for j in usable]
+                    index = distances.index(min(distances))
+                    error += distances[index]
+                indices |= index << (texel_index * 2)
+            if best is None or error < best[0]:
+                best = error, struct.pack('<HHI', color0, color1, indices)
+    return best[1]
+
+
+def bc1_encode(length, pixels):
+    """Encodes one square mip level as BC1. Levels smaller than a block repeat their edge texels to fill it."""
+    blocks = bytearray()
+    for block_y in range(0, length, 4):
+        for block_x in range(0, length, 4):
+            texels = []
+            for y in range(4):
+                for x in range(4):
+                    offset = (min(block_y + y, length - 1) * length + min(block_x + x, length - 1)) * 4
+                    texels.append(pixels[offset:offset + 4])
+            blocks += bc1_block(texels)
+    return bytes(blocks)
+
+
+def astc_payload(path: Path):
+    """Checks the header of a 2D ASTC file and returns the blocks that follow it."""
+    data = path.read_bytes()
+    magic, block_x, block_y, block_z = struct.unpack('<IBBB', data[:7])
+    # The dimensions are 24-bit little endian, x, y then z.
+    depth = int.from_bytes(data[13:16], 'little')
+    if magic != 0x5ca1ab13 or block_z != 1 or depth != 1:
+        raise ValueError(f'{path} is not a 2D ASTC file.')
+    return data[16:]
+
+
+def write_pack(path: Path, entries):
+    """
+    Writes entries, a dict of names to bytes, as one file the game maps at startup:
+    - header: magic, version, entry count and a reserved word, all 32-bit little endian
+    - table of contents: per entry, a null-terminated name padded to PACK_ENTRY_NAME_LENGTH bytes, then the offset and
+      size of its blob as 32-bit little endian
+    - blobs, each starting at a multiple of PACK_ALIGNMENT from the start of the file
+    """
+    path.parent.mkdir(parents=True, exist_ok=True)
+
+    offset = 16 + len(entries) * (PACK_ENTRY_NAME_LENGTH + 8)
+    table = bytearray()
+    blobs = bytearray()
+    for name, blob in sorted(entries.items()):
+        encoded_name = name.encode()
+        if len(encoded_name) >= PACK_ENTRY_NAME_LENGTH:
+            raise ValueError(f'Asset name {name} is too long for the pack.')
+
+        padding = -(offset + len(blobs)) % PACK_ALIGNMENT
+        blobs += bytes(padding)
+        table += struct.pack(f'<{PACK_ENTRY_NAME_LENGTH}sII', encoded_name, offset + len(blobs), len(blob))
+        blobs += blob
+
+    data = struct.pack('<4sIII', PACK_MAGIC, PACK_VERSION, len(entries), 0) + table + blobs
+    # Leave an unchanged pack alone so the builds that package it stay up to date.
+    if path.exists() and path.read_bytes() == data:
+        print(f'[PACK] {path} is up to date')
+        return
 
-            strip_exif_if_requested(img, strip_exif)
+    print(f'[PACK] Writing {len(entries)} assets -> {path}')
+    path.write_bytes(data)
 
-            rel = img.relative_to(base_dir.parent)
-            block = '4x4'
 
-            # -------- ANDROID --------
-            android_out_dir = ANDROID_ASSETS / rel.parent
-            android_out_dir.mkdir(parents=True, exist_ok=True)
+def decode_texture(path: Path):
+    width, height, pixels = decode_png(path)
+    if width != height or width & (width - 1):
+        raise ValueError(f'{path} must be square with a power of two size to be mipmapped.')
+    return width, height, pixels
 
-            if compress_android:
-                out = android_out_dir / (img.stem + '.astc')
-                print(f'[ANDROID] Compressing {img} -> {out}')
-                run([
-                    ASTCENC_COMMAND,
-                    '-cl',
-                    str(img),
-                    str(out),
-                    block,
-                    '-exhaustive',
-                ])
-            else:
-                out = android_out_dir / img.name
-                print(f'[ANDROID] Copying {img} -> {out}')
-                shutil.copy2(img, out)
 
-            # -------- PC --------
-            pc_out_dir = PC_ASSETS / rel.parent
-            pc_out_dir.mkdir(parents=True, exist_ok=True)
+# Recipes turning one source file into one pack entry. They run in worker processes, so they only take picklable
+# arguments, and return None or raise on failure. Textures hold their whole mip chain back to back, largest level first.
+
+def build_bc1_texture(source: Path):
+    width, height, pixels = decode_texture(source)
+    return b''.join(bc1_encode(width >> level, level_pixels)
+                    for level, level_pixels in enumerate(mip_chain(width, height, pixels)))
 
-            # No compression for now.
-            out = pc_out_dir / img.name
-            print(f'[PC] Copying {img} -> {out}')
-            shutil.copy2(img, out)
-            strip_exif_if_requested(out, strip_exif)
 
+def build_android_texture(source: Path):
+    width, height, pixels = decode_texture(source)
+    payload = b''
+    with tempfile.TemporaryDirectory() as temp_dir:
+        for level, level_pixels in enumerate(mip_chain(width, height, pixels)):
+            level_image = Path(temp_dir) / f'{level}.png'
+            level_out = Path(temp_dir) / f'{level}.astc'
+            encode_png(level_image, width >> level, height >> level, level_pixels)
+            # Levels under the block size still take a whole block. Every worker runs its own astcenc, so keep each one
+            # on a single thread.
+            if not run([ASTCENC_COMMAND, '-cl', str(level_image), str(level_out), *ASTCENC_OPTIONS, '-j', '1']):
+                return None
+            payload += astc_payload(level_out)
+    return payload
+
+
+def build_shader(source: Path):
+    with tempfile.TemporaryDirectory() as temp_dir:
+        out = Path(temp_dir) / 'shader.spv'
+        if not run(['glslc', *GLSLC_OPTIONS, str(source), '-o', str(out)]):
+            return None
+        return out.read_bytes()
+
+
+RECIPES = {
+    'bc1-texture': (build_bc1_texture, []),
+    'android-texture': (build_android_texture, [ASTCENC_COMMAND, *ASTCENC_OPTIONS]),
+    # Shaders don't use #include yet, so their own source is all they depend on.
+    'shader': (build_shader, ['glslc', *GLSLC_OPTIONS]),
+}
+
+
+def list_assets(compress_android, strip_exif):
+    """
+    Yields the pack, entry name, recipe and source of every asset. Textures are named after the encoding they're stored
+    in, and the game picks the smallest one the GPU supports. Every pack has BC1, which the game can also decode itself
+    when the GPU can't sample it, and Android adds ASTC since few phones support BC.
+    """
+    for base_dir in TEXTURE_DIRS:
+        for img in sorted(base_dir.rglob('*')):
+            if img.suffix.lower() not in IMAGE_EXTS:
+                continue
 
-def compile_shaders():
-    out_dir = PC_ASSETS / 'shaders'
-    out_dir.mkdir(parents=True, exist_ok=True)
-    out_dir_android = ANDROID_ASSETS / 'shaders'
-    out_dir_android.mkdir(parents=True, exist_ok=True)
+            strip_exif_if_requested(img, strip_exif)
+            name = img.relative_to(base_dir.parent).with_suffix('').as_posix()
+            yield 'pc', f'{name}.bc1', 'bc1-texture', img
+            yield 'android', f'{name}.bc1', 'bc1-texture', img
+            if compress_android:
+                yield 'android', f'{name}.astc', 'android-texture', img
 
     for base_dir in SHADER_DIRS:
-        for shader in base_dir.rglob('*'):
+        for shader in sorted(base_dir.rglob('*')):
             stage = shader.suffix.lstrip('.')
             if stage not in SHADER_STAGES:
                 continue
 
-            out = out_dir / f'{shader.stem}-{stage}.spv'
-            out_android = out_dir_android / f'{shader.stem}-{stage}.spv'
+            name = f'shaders/{shader.stem}-{stage}.spv'
+            yield 'pc', name, 'shader', shader
+            yield 'android', name, 'shader', shader
+
+
+def texture_names():
+    return {img.relative_to(base_dir.parent).with_suffix('').as_posix()
+            for base_dir in TEXTURE_DIRS
+            for img in base_dir.rglob('*')
+            if img.suffix.lower() in IMAGE_EXTS}
+
+
+def compile_block_registry(path: Path):
+    """
+    Compiles the block types listed in path into the "blocks" pack entry, read in place by nc__load_block_registry():
+    - type count and texture count, as 32-bit little endian
+    - the opaque, solid and emissive bitsets, each one bit per type in 32-bit little endian words
+    - the light emitted by each type, one byte per type, padded to 4 bytes
+    - the texture layer of each face of each type, 16-bit little endian in the order of the faces in cube.vert, padded
+      to 4 bytes
+    - the null-terminated name of each type, padded to BLOCK_NAME_LENGTH bytes
+    - the pack name of each texture, without its encoding suffix, padded to PACK_ENTRY_NAME_LENGTH bytes
+    Type 0 is air. The other types are numbered in the order of the file, so only ever add new ones at the end. Textures
+    get a layer in the order blocks first use them, unused ones aren't loaded.
+    """
+    blocks = json.loads(path.read_text())['blocks']
+    available_textures = texture_names()
+
+    names = ['air']
+    textures = []
+    face_layers = [[0] * len(BLOCK_FACE_TEXTURES)]
+    properties = {'opaque': [False], 'solid': [False], 'emissive': [False]}
+    light = [0]
+    for block in blocks:
+        name = block['name']
+        if name in names or len(name.encode()) >= BLOCK_NAME_LENGTH:
+            raise ValueError(f'{path}: block name {name} is taken or too long.')
+        names.append(name)
+
+        block_textures = block['textures']
+        if isinstance(block_textures, str):
+            block_textures = {face: block_textures for face in ('top', 'sides', 'bottom')}
+        layers = []
+        for face in BLOCK_FACE_TEXTURES:
+            texture = f'textures/{block_textures[face]}'
+            if texture not in available_textures:
+                raise ValueError(f'{path}: {name} uses the missing texture {texture}.')
+            if texture not in textures:
+                textures.append(texture)
+            layers.append(textures.index(texture))
+        face_layers.append(layers)
+
+        level = block.get('light', 0)
+        if not 0 <= level <= BLOCK_LIGHT_MAX:
+            raise ValueError(f'{path}: the light of {name} must be between 0 and {BLOCK_LIGHT_MAX}.')
+        light.append(level)
+        properties['opaque'].append(block.get('opaque', True))
+        properties['solid'].append(block.get('solid', True))
+        properties['emissive'].append(level > 0)
+
+    if len(textures) > 0xFFFF:
+        raise ValueError(f'{path}: blocks use more textures than a face can refer to.')
+
+    def padded(data):
+        return data + bytes(-len(data) % 4)
+
+    def bitset(bits):
+        words = [0] * ((len(bits) + 31) // 32)
+        for i, bit in enumerate(bits):
+            words[i // 32] |= bool(bit) << (i % 32)
+        return struct.pack(f'<{len(words)}I', *words)
+
+    return (struct.pack('<II', len(names), len(textures))
+            + bitset(properties['opaque'])
+            + bitset(properties['solid'])
+            + bitset(properties['emissive'])
+            + padded(bytes(light))
+            + padded(b''.join(struct.pack('<6H', *layers) for layers in face_layers))
+            + b''.join(struct.pack(f'{BLOCK_NAME_LENGTH}s', name.encode()) for name in names)
+            + b''.join(struct.pack(f'{PACK_ENTRY_NAME_LENGTH}s', texture.encode()) for texture in textures))
+
+
+def cache_key(recipe, source: Path):
+    digest = hashlib.sha256()
+    digest.update(json.dumps([CACHE_VERSION, recipe, RECIPES[recipe][1]]).encode())
+    digest.update(source.read_bytes())
+    return digest.hexdigest()
+
+
+def cached_recipes():
+    """Returns the recipe of every build the last run left in the cache, by hash."""
+    try:
+        return json.loads(CACHE_MANIFEST.read_text())['builds']
+    except (OSError, ValueError, KeyError):
+        return {}
+
+
+def build_assets(assets, jobs):
+    """
+    Builds the assets missing from the cache in parallel, then returns the packs, or None if anything failed. The
+    manifest records the hash each entry was built from and the recipe of each build. Cached builds no entry uses
+    anymore are deleted, but only for the recipes this run used: a run without --compress-android keeps the ASTC
+    builds, which are by far the slowest to redo.
+    """
+    CACHE_DIR.mkdir(parents=True, exist_ok=True)
+
+    entries = {}
+    builds = {}
+    recipes = {}
+    sources = {}
+    with ProcessPoolExecutor(max_workers=jobs) as pool:
+        for pack, name, recipe, source in assets:
+            key = cache_key(recipe, source)
+            entries[f'{pack}/{name}'] = {'source': source.as_posix(), 'recipe': recipe, 'hash': key}
+            recipes[key] = recipe
+            sources[key] = source
+            if key in builds:
+                continue
 
-            print(f'[SHADER] Compiling {shader} -> {out}')
-            if run(['glslc', '--target-env=vulkan1.0', str(shader), '-o', str(out)]):
-                print(f'[SHADER] Copying {out} -> {out_android}')
-                shutil.copy2(out, out_android)
+            if (CACHE_DIR / key).exists():
+                print(f'[CACHE] {source} ({recipe}) is up to date')
+                builds[key] = None
+            else:
+                print(f'[BUILD] {source} ({recipe})')
+                builds[key] = pool.submit(RECIPES[recipe][0], source)
+
+        failed = False
+        for key, build in builds.items():
+            if build is None:
+                continue
+
+            # A bad source must not lose the builds that did finish, so it fails the run like a failed command.
+            try:
+                payload = build.result()
+            except Exception as error:
+                print(f'⚠️ Could not build {sources[key]} ({recipes[key]}): {error}', file=sys.stderr)
+                payload = None
+            if payload is None:
+                failed = True
+                continue
+
+            # Written aside first so an interrupted run never leaves a truncated build behind.
+            partial = CACHE_DIR / f'{key}.partial'
+            partial.write_bytes(payload)
+            partial.replace(CACHE_DIR / key)
+
+    used_recipes = set(recipes.values())
+    for key, recipe in cached_recipes().items():
+        if recipe not in used_recipes and (CACHE_DIR / key).exists():
+            recipes[key] = recipe
+    for path in CACHE_DIR.iterdir():
+        if path != CACHE_MANIFEST and path.name not in recipes:
+            path.unlink()
+    manifest = {'entries': entries, 'builds': recipes}
+    CACHE_MANIFEST.write_text(json.dumps(manifest, indent=4, sort_keys=True) + '\n')
+
+    if failed:
+        return None
+
+    packs = {'pc': {}, 'android': {}}
+    for entry, record in entries.items():
+        pack, name = entry.split('/', 1)
+        packs[pack][name] = (CACHE_DIR / record['hash']).read_bytes()
+    return packs
 
 
 def main():
     parser = argparse.ArgumentParser(description='Unlit asset pipeline.')
     parser.add_argument('--compress-android', action='store_true')
     parser.add_argument('--strip-exif', action='store_true')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(), help='Assets built at the same time.')
 
     args = parser.parse_args()
 
-    process_textures(
-        compress_android=args.compress_android,
-        strip_exif=args.strip_exif,
-    )
-    print('Textures done.')
+    packs = build_assets(list_assets(args.compress_android, args.strip_exif), args.jobs)
+    if packs is None:
+        print('Some assets failed to build, the packs were left untouched.', file=sys.stderr)
+        sys.exit(1)
+
+    # Too quick to build to be worth caching, and it depends on which textures exist on top of its own source.
+    print(f'[BUILD] {BLOCK_REGISTRY}')
+    block_registry = compile_block_registry(BLOCK_REGISTRY)
+    packs['pc']['blocks'] = block_registry
+    packs['android']['blocks'] = block_registry
 
-    compile_shaders()
-    print('Shaders compiled.')
+    write_pack(PC_ASSETS / PACK_NAME, packs['pc'])
+    if not args.compress_android:
+        print('[PACK] The Android pack has no ASTC textures, they need --compress-android.')
+    write_pack(ANDROID_ASSETS / PACK_NAME, packs['android'])
 
 
 if __name__ == "__main__":
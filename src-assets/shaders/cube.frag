@@ -2,11 +2,14 @@
 layout(early_fragment_tests) in;
 
 layout(location = 0) in vec3 in_uv;
+layout(location = 1) in float in_light;
+layout(location = 2) in float in_ambient_occlusion;
 
 layout(set = 2, binding = 0) uniform sampler2DArray terrain_textures;
 
 layout(location = 0) out vec4 out_color;
 
 void main() {
-    out_color = texture(terrain_textures, in_uv);
+    vec4 color = texture(terrain_textures, in_uv);
+    out_color = vec4(color.rgb * in_light * in_ambient_occlusion, color.a);
 }
@@ -1,78 +1,125 @@
 #version 450
 
-layout(location = 0) in uvec4 in_position_and_block_type;
+// Skylight in the high nibble, block light in the low nibble.
+layout(set = 0, binding = 0) uniform usampler3D light_texture;
+
+// One word per face, drawn as 6 vertices: 4 bits per coordinate within the section, 2 bits of ambient occlusion per
+// corner, then the block type. See NC__FACE in main.c.
+layout(std430, set = 0, binding = 1) readonly buffer face_buffer {
+    uint faces[];
+};
+
+// The texture layer of every face of every block type, in the order of the faces below, two 16-bit layers per word.
+layout(std430, set = 0, binding = 2) readonly buffer face_layer_buffer {
+    uint face_layers[];
+};
 
 layout(std140, set = 1, binding = 0) uniform global_uniforms {
     mat4 view_projection;
+    float sky_brightness;
 } uniforms;
 
+// Every face of a draw belongs to the same section and faces the same way.
+layout(std140, set = 1, binding = 1) uniform draw_uniforms {
+    ivec3 section_origin;
+    int face;
+} draw;
+
 // Note: mediump is bugged with PowerVR Rogue
 layout(location = 0) out vec3 out_uv;
+layout(location = 1) out float out_light;
+layout(location = 2) out float out_ambient_occlusion;
 
-const vec3 cube_vertices[] = vec3[](
+// Four corners per face, counter-clockwise.
+const vec3 cube_corners[] = vec3[](
     // right face
     vec3(1.0, 1.0, 0.0),
     vec3(1.0, 0.0, 0.0),
-    vec3(1.0, 0.0, 1.0),
-
     vec3(1.0, 0.0, 1.0),
     vec3(1.0, 1.0, 1.0),
-    vec3(1.0, 1.0, 0.0),
 
     // left face
     vec3(0.0, 1.0, 1.0),
     vec3(0.0, 0.0, 1.0),
-    vec3(0.0, 0.0, 0.0),
-
     vec3(0.0, 0.0, 0.0),
     vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 1.0, 1.0),
 
     // up face
     vec3(0.0, 1.0, 1.0),
     vec3(0.0, 1.0, 0.0),
-    vec3(1.0, 1.0, 0.0),
-
     vec3(1.0, 1.0, 0.0),
     vec3(1.0, 1.0, 1.0),
-    vec3(0.0, 1.0, 1.0),
 
     // down face
     vec3(0.0, 0.0, 0.0),
     vec3(0.0, 0.0, 1.0),
-    vec3(1.0, 0.0, 1.0),
-
     vec3(1.0, 0.0, 1.0),
     vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 0.0, 0.0),
 
     // back face
     vec3(0.0, 1.0, 0.0),
     vec3(0.0, 0.0, 0.0),
-    vec3(1.0, 0.0, 0.0),
-
     vec3(1.0, 0.0, 0.0),
     vec3(1.0, 1.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
 
     // front face
     vec3(1.0, 1.0, 1.0),
     vec3(1.0, 0.0, 1.0),
     vec3(0.0, 0.0, 1.0),
+    vec3(0.0, 1.0, 1.0));
 
-    vec3(0.0, 0.0, 1.0),
-    vec3(0.0, 1.0, 1.0),
-    vec3(1.0, 1.0, 1.0));
-
-const vec2 cube_uvs[] = vec2[](
+const vec2 corner_uvs[] = vec2[](
     vec2(0.0, 0.0),
     vec2(0.0, 1.0),
     vec2(1.0, 1.0),
-    vec2(1.0, 1.0),
-    vec2(1.0, 0.0),
-    vec2(0.0, 0.0));
+    vec2(1.0, 0.0));
+
+// The two triangles of a face, split along one diagonal or the other.
+const uint quad_corners[] = uint[](0u, 1u, 2u, 2u, 3u, 0u);
+const uint flipped_quad_corners[] = uint[](1u, 2u, 3u, 3u, 0u, 1u);
+
+// In the order of the faces above.
+const ivec3 face_normals[] = ivec3[](
+    ivec3(1, 0, 0),
+    ivec3(-1, 0, 0),
+    ivec3(0, 1, 0),
+    ivec3(0, -1, 0),
+    ivec3(0, 0, -1),
+    ivec3(0, 0, 1));
+
+// Each light level is 80% as bright as the next one.
+float light_brightness(uint level) {
+    return pow(0.8, 15.0 - float(level));
+}
 
 void main() {
-    gl_Position = uniforms.view_projection * vec4(in_position_and_block_type.xyz + cube_vertices[gl_VertexIndex], 1.0);
-    out_uv = vec3(cube_uvs[gl_VertexIndex % 6], in_position_and_block_type.w - 1);
+    uint packed_face = faces[gl_VertexIndex / 6];
+    int face = draw.face;
+    ivec3 position = draw.section_origin + ivec3(packed_face & 0xFu, packed_face >> 4 & 0xFu, packed_face >> 8 & 0xFu);
+    uint face_ambient_occlusion = packed_face >> 12;
+    uvec4 corner_ambient_occlusion = uvec4(
+        face_ambient_occlusion,
+        face_ambient_occlusion >> 2,
+        face_ambient_occlusion >> 4,
+        face_ambient_occlusion >> 6) & 3u;
+
+    // Split along the darker diagonal, otherwise the occlusion is interpolated unevenly across the face.
+    bool flip = corner_ambient_occlusion.x + corner_ambient_occlusion.z
+        > corner_ambient_occlusion.y + corner_ambient_occlusion.w;
+    uint corner = flip ? flipped_quad_corners[gl_VertexIndex % 6] : quad_corners[gl_VertexIndex % 6];
+
+    uint block_face = (packed_face >> 20) * 6u + uint(face);
+    uint layer = face_layers[block_face / 2u] >> (block_face % 2u * 16u) & 0xFFFFu;
+
+    gl_Position = uniforms.view_projection * vec4(vec3(position) + cube_corners[face * 4 + corner], 1.0);
+    out_uv = vec3(corner_uvs[corner], layer);
+    out_ambient_occlusion = 0.4 + 0.2 * float(corner_ambient_occlusion[corner]);
+
+    // A face is lit by the air in front of it. Outside the chunk is open sky.
+    ivec3 neighbor = position + face_normals[face];
+    uint light = 0xF0u;
+    if (all(greaterThanEqual(neighbor, ivec3(0))) && all(lessThan(neighbor, textureSize(light_texture, 0)))) {
+        light = texelFetch(light_texture, neighbor, 0).r;
+    }
+    out_light = max(light_brightness(light >> 4) * uniforms.sky_brightness, light_brightness(light & 0xFu));
 }
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) flat in vec2 in_max_uv;
+
+layout(set = 2, binding = 0) uniform sampler2D scene_texture;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+    out_color = texture(scene_texture, min(in_uv, in_max_uv));
+}
@@ -0,0 +1,24 @@
+#version 450
+
+// The scene only covers the top left of the scene texture, see nc__resolution_scale in main.c. Linear filtering would
+// blend in the texels past it, so sampling stops at the center of the last ones.
+layout(std140, set = 1, binding = 0) uniform upscale_uniforms {
+    vec2 scene_extent;
+    vec2 max_uv;
+} uniforms;
+
+layout(location = 0) out vec2 out_uv;
+layout(location = 1) flat out vec2 out_max_uv;
+
+// One triangle covering the whole target, the parts outside it are clipped.
+const vec2 triangle_vertices[] = vec2[](
+    vec2(-1.0, -1.0),
+    vec2( 3.0, -1.0),
+    vec2(-1.0,  3.0));
+
+void main() {
+    vec2 position = triangle_vertices[gl_VertexIndex];
+    gl_Position = vec4(position, 0.0, 1.0);
+    out_uv = vec2(position.x + 1.0, 1.0 - position.y) * 0.5 * uniforms.scene_extent;
+    out_max_uv = uniforms.max_uv;
+}
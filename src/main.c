@@ -1,10 +1,28 @@
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef ANDROID
+#include <android/asset_manager.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define CVKM_LH
+// Only the SSE paths of cvkm are checked against the scalar ones by tests/cvkm-parity, the NEON ones haven't been built
+// and run on AArch64 yet, so ARM builds like the Android one stay scalar until then.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CVKM_SIMD
+#endif
 #include <cvkm.h>
 #include <SDL3/SDL.h>
 #define SDL_MAIN_USE_CALLBACKS
@@ -13,49 +31,153 @@
 
 #include <novacube/version.h>
 
-typedef uint8_t nc__block_type;
+typedef uint16_t nc__block_type;
 
 enum {
+    // The other types come from the block registry.
     NC__BLOCK_TYPE_AIR = 0,
-    NC__BLOCK_TYPE_STONE = 1,
-    NC__BLOCK_TYPE_DIRT = 2,
-    NC__BLOCK_TYPE_GRASS = 3,
-    NC__BLOCK_TYPE_COUNT = 3,
 };
 
 #ifdef ANDROID
 #define NC__ASSETS_BASE_PATH ""
-#define NC__TEXTURE_FILE_EXTENSION ".astc"
 #else
 #define NC__ASSETS_BASE_PATH "assets/"
-#define NC__TEXTURE_FILE_EXTENSION ".png"
 #endif
-
-static const char* nc__terrain_texture_paths[] = {
-    NC__ASSETS_BASE_PATH "textures/stone" NC__TEXTURE_FILE_EXTENSION,
-    NC__ASSETS_BASE_PATH "textures/dirt" NC__TEXTURE_FILE_EXTENSION,
-    NC__ASSETS_BASE_PATH "textures/grass" NC__TEXTURE_FILE_EXTENSION,
-};
+#define NC__PACK_PATH NC__ASSETS_BASE_PATH "assets.ncpak"
+
+typedef struct nc__texture_encoding_t {
+    const char* name;
+    SDL_GPUTextureFormat format;
+    // Suffix of the pack entries holding the textures.
+    const char* suffix;
+    // Bytes per 4x4 block in the pack.
+    Uint32 block_size;
+    // The textures are stored as BC1 and expanded to RGBA8 on the CPU.
+    bool decode_bc1;
+} nc__texture_encoding_t;
 
 typedef struct nc__block_t {
     vkm_ubvec3 position;
+    // One byte per face in the order of cube.vert, holding 2 bits of ambient occlusion per corner, from 0 (darkest) to
+    // 3 (open).
+    uint8_t ambient_occlusion[6];
     nc__block_type type;
 } nc__block_t;
 
+// The "blocks" entry of the pack, compiled from src-assets/blocks.json by prepare-assets.py, which documents the
+// layout. Everything points into the mapped pack. Properties are bitsets indexed by block type, see nc__block_is.
+typedef struct nc__block_registry_t {
+    // Air included.
+    uint32_t type_count;
+    uint32_t texture_count;
+    const uint32_t* opaque;
+    const uint32_t* solid;
+    const uint32_t* emissive;
+    const uint8_t* light_emission;
+    // The texture layer of every face of every type, in the order of the faces in cube.vert. Uploaded as is to
+    // nc__face_layer_buffer.
+    const uint16_t* face_layers;
+    const char (*type_names)[32];
+    // Pack names without their encoding suffix, in layer order.
+    const char (*texture_names)[56];
+} nc__block_registry_t;
+
+typedef struct nc__vertex_uniforms_t {
+    vkm_mat4 view_projection;
+    float sky_brightness;
+} nc__vertex_uniforms_t;
+
+// How frames are paced: the present mode, how many frames SDL lets the CPU queue ahead of the GPU and an optional frame
+// rate cap. Present modes the window doesn't support fall back to VSYNC, which is always supported.
+typedef struct nc__pacing_profile_t {
+    const char* name;
+    SDL_GPUPresentMode present_mode;
+    Uint32 frames_in_flight;
+    // 0 leaves the frame rate to the present mode.
+    Uint32 target_fps;
+} nc__pacing_profile_t;
+
+// A frame submitted to the GPU, and how far nc__staging_head was when it was.
+typedef struct nc__frame_t {
+    SDL_GPUFence* fence;
+    Uint64 staging_end;
+} nc__frame_t;
+
+// Pushed before each draw of the faces of a section facing one direction.
+typedef struct nc__draw_uniforms_t {
+    int32_t section_origin[3];
+    uint32_t face;
+} nc__draw_uniforms_t;
+
+// How a render pass treats the contents of one of its targets, see nc__run_render_passes.
+typedef enum nc__target_use_t {
+    // Draws over what the frame's earlier passes left.
+    NC__ATTACHMENT_KEEP,
+    // Starts from the clear value.
+    NC__ATTACHMENT_CLEAR,
+    // Overwrites every pixel, or doesn't touch the target at all.
+    NC__ATTACHMENT_DISCARD,
+} nc__target_use_t;
+
+// A pass of the frame as declared, before nc__run_render_passes merges it with the ones around it.
+typedef struct nc__render_pass_t {
+    SDL_GPUTexture* color_target;
+    nc__target_use_t color_use;
+    SDL_FColor clear_color;
+    // Cleared to 1 when depth_use is NC__ATTACHMENT_CLEAR. Every pipeline declares a depth target, even when it doesn't
+    // test against it, so that passes into the same color target can share a render pass.
+    SDL_GPUTexture* depth_target;
+    nc__target_use_t depth_use;
+    // Textures the pass samples, which the passes drawing into them have to store.
+    SDL_GPUTexture* inputs[2];
+    void (*record)(SDL_GPUCommandBuffer* command_buffer, SDL_GPURenderPass* render_pass, const void* data);
+    const void* data;
+} nc__render_pass_t;
+
+typedef struct nc__scene_pass_t {
+    vkm_mat4 view_projection;
+    // Of the top left part of the target the scene is drawn into.
+    Uint32 width, height;
+} nc__scene_pass_t;
+
+typedef struct nc__upscale_uniforms_t {
+    float scene_extent[2];
+    float max_uv[2];
+} nc__upscale_uniforms_t;
+
+// A section to draw this frame, see nc__sort_visible_sections.
+typedef struct nc__section_draw_t {
+    float distance_squared;
+    uint32_t section_index;
+} nc__section_draw_t;
+
+// Axis-aligned, in blocks.
+typedef struct nc__box_t {
+    vkm_vec3 min, max;
+} nc__box_t;
+
 typedef struct nc__camera_t {
     vkm_vec3 position;
     float yaw, pitch;
 } nc__camera_t;
 
-typedef struct nc__astc_header {
+// Layout of the asset pack written by prepare-assets.py, all little endian. The header is followed by entry_count
+// entries, then by the blobs, each starting at a multiple of 16 bytes from the start of the file. Textures are stored
+// ready for upload with their whole mip chain, largest level first, and named after their encoding: every pack has a
+// "<name>.bc1" of BC1 blocks, and the Android one also has a "<name>.astc" of ASTC 4x4 blocks without their file header
+// when built with --compress-android. See nc__texture_encodings for how one is picked.
+typedef struct nc__pack_header_t {
     uint8_t magic[4];
-    uint8_t block_x;
-    uint8_t block_y;
-    uint8_t block_z;
-    uint8_t dim_x[3];
-    uint8_t dim_y[3];
-    uint8_t dim_z[3];
-} nc__astc_header;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+} nc__pack_header_t;
+
+typedef struct nc__pack_entry_t {
+    char name[56]; // Null terminated.
+    uint32_t offset;
+    uint32_t size;
+} nc__pack_entry_t;
 
 typedef struct nc__touch_event_t {
     vkm_vec2 initial_pos, current_pos;
@@ -66,21 +188,79 @@ typedef struct nc__touch_event_t {
 #ifndef ANDROID
 #define NC__BACKGROUND_DELAY 100
 #endif
+// While nothing changes, frames are only drawn this often, see nc__frame_needed.
+#define NC__IDLE_REDRAW_INTERVAL SDL_NS_PER_SECOND
+// Frame time statistics are logged this often, see nc__record_frame_time.
+#define NC__FRAME_STATS_INTERVAL (5 * SDL_NS_PER_SECOND)
+// The battery is checked this often, and the battery saver profile used below this charge.
+#define NC__POWER_CHECK_INTERVAL (10 * SDL_NS_PER_SECOND)
+#define NC__LOW_BATTERY_PERCENT 20
+// Indices into nc__pacing_profiles.
+#ifdef ANDROID
+#define NC__DEFAULT_PACING_PROFILE 3
+#else
+#define NC__DEFAULT_PACING_PROFILE 0
+#endif
+#define NC__BATTERY_SAVER_PROFILE 4
+// The scene is drawn at between this and the full window resolution, see nc__update_resolution_scale.
+#define NC__RESOLUTION_SCALE_MIN 0.5f
+// How much of the full resolution is won back per second while frames are within budget, and how fast the limit set
+// by the last drop wears off.
+#define NC__RESOLUTION_SCALE_RECOVERY 0.05f
+#define NC__RESOLUTION_SCALE_LIMIT_RECOVERY 0.002f
 #define NC__CHUNK_LENGTH 256
 #define NC__CHUNK_COUNT (NC__CHUNK_LENGTH * NC__CHUNK_LENGTH * NC__CHUNK_LENGTH)
-#define NC__CHUNK_SIZE (NC__CHUNK_COUNT * sizeof(nc__block_t))
 #define NC__CHUNK_INDEX(x, y, z) ((x) + ((y) * NC__CHUNK_LENGTH) + ((z) * NC__CHUNK_LENGTH * NC__CHUNK_LENGTH))
+// The chunk is meshed and drawn in sections, so a change only remeshes the sections around it.
+#define NC__SECTION_LENGTH 16
+#define NC__SECTIONS_PER_AXIS (NC__CHUNK_LENGTH / NC__SECTION_LENGTH)
+#define NC__SECTION_COUNT (NC__SECTIONS_PER_AXIS * NC__SECTIONS_PER_AXIS * NC__SECTIONS_PER_AXIS)
+#define NC__SECTION_INDEX(x, y, z) \
+    ((x) + ((y) * NC__SECTIONS_PER_AXIS) + ((z) * NC__SECTIONS_PER_AXIS * NC__SECTIONS_PER_AXIS))
+// One 32-bit word per visible face, read by cube.vert: 4 bits per coordinate within the section, the 8 bits of
+// ambient occlusion of the face, then the block type. The section and the direction of the face come with the draw.
+#define NC__FACE(x, y, z, ambient_occlusion, type) ((uint32_t)(x) | (uint32_t)(y) << 4 | (uint32_t)(z) << 8 \
+    | (uint32_t)(ambient_occlusion) << 12 | (uint32_t)(type) << 20)
+#define NC__FACE_TYPE_LIMIT 4096
+// One face per position of the chunk, it takes a contrived world to need more.
+#define NC__FACE_CAPACITY NC__CHUNK_COUNT
+// Every upload after startup goes through this much staging memory, shared by the frames in flight.
+#define NC__STAGING_SIZE (8 * 1024 * 1024)
+#define NC__STAGING_ALIGNMENT 16
+#define NC__FRAMES_IN_FLIGHT 3
 #define NC__MOUSE_SENSITIVITY vkm_deg2rad(0.2f)
 #define NC__TOUCHSCREEN_SENSITIVITY 15.0f
 #define NC__MOVEMENT_SPEED 5.0f
+#define NC__SPAWN_POSITION { { 127.5f, 127.5f, 124.0f } }
+// The player's box, around the camera at eye height.
+#define NC__PLAYER_WIDTH 0.6f
+#define NC__PLAYER_HEIGHT 1.8f
+#define NC__PLAYER_EYE_HEIGHT 1.6f
+// How far a moving box stops short of the block it runs into, so that the block isn't among the ones it overlaps.
+#define NC__COLLISION_MARGIN 0.001f
+// The game world advances in ticks of fixed length, however fast frames are drawn, see nc__tick.
+#define NC__TICK_RATE 30
+#define NC__TICK_DURATION (1.0 / NC__TICK_RATE)
+// Frames slower than this many ticks slow the game down, rather than running more ticks that make the next frame slower
+// still.
+#define NC__MAX_TICKS_PER_FRAME 5
 #define NC__COUNTOF(a) (sizeof(a) / sizeof(*a))
 #define NC__TERRAIN_TEXTURE_LENGTH 16
-#ifdef ANDROID
-// astc 4x4: 1 byte per texel
-#define NC__TERRAIN_TEXTURE_SIZE (NC__TERRAIN_TEXTURE_LENGTH * NC__TERRAIN_TEXTURE_LENGTH)
-#else
-#define NC__TERRAIN_TEXTURE_SIZE (NC__TERRAIN_TEXTURE_LENGTH * NC__TERRAIN_TEXTURE_LENGTH * 4)
-#endif
+#define NC__PACK_VERSION 1
+// Light levels go from 0 to 15, skylight is kept in the high nibble of nc__light and block light in the low one.
+#define NC__LIGHT_MAX 15
+#define NC__SKY_LIGHT_SHIFT 4
+#define NC__BLOCK_LIGHT_SHIFT 0
+// Light queue entries carry a chunk index in the low 24 bits and, for removals, the former light level above them.
+#define NC__LIGHT_NODE(index, level) ((uint32_t)(index) | (uint32_t)(level) << 24)
+#define NC__LIGHT_NODE_INDEX(node) ((node) & 0xFFFFFFu)
+#define NC__LIGHT_NODE_LEVEL(node) ((uint8_t)((node) >> 24))
+#define NC__DIRECTION_DOWN 3
+// 16x16 down to 1x1.
+#define NC__TERRAIN_TEXTURE_LEVELS 5
+#define NC__TERRAIN_LEVEL_LENGTH(level) (NC__TERRAIN_TEXTURE_LENGTH >> (level))
+#define NC__BC1_BLOCK_SIZE 8
+#define NC__DECODE_THREAD_MAX 16
 #ifdef NDEBUG
 #define NC__BUILD_TYPE "Release"
 #else
@@ -94,109 +274,559 @@ typedef struct nc__touch_event_t {
     } \
 } while (false)
 
+// Smallest first, the first one the GPU can sample and the pack holds is used. BC1 is in every pack, so decoding it
+// ourselves works everywhere.
+static const nc__texture_encoding_t nc__texture_encodings[] = {
+    { "BC1", SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM, ".bc1", NC__BC1_BLOCK_SIZE, false },
+    { "ASTC 4x4", SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM, ".astc", 16, false },
+    { "RGBA8 decoded from BC1", SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, ".bc1", NC__BC1_BLOCK_SIZE, true },
+};
+
 static SDL_GPUDevice* nc__gpu_device;
 static SDL_Window* nc__window;
-static SDL_GPUTexture* nc__depth_texture;
+// The asset pack, mapped read only by nc__open_pack.
+static const void* nc__pack;
+static size_t nc__pack_size;
+#ifdef ANDROID
+// Owns the AAsset backing nc__pack.
+static SDL_IOStream* nc__pack_stream;
+#endif
+// The scene is drawn into the top left of these at nc__resolution_scale, then scaled up into the swapchain.
+static SDL_GPUTexture* nc__scene_texture, *nc__depth_texture;
 static vkm_usvec2 nc__viewport_size;
+static float nc__resolution_scale = 1.0f, nc__resolution_scale_limit = 1.0f;
+// Smoothed frame time and the time a frame may take at the pacing profile's frame rate, in seconds.
+static double nc__average_frame_time, nc__frame_budget;
 #define TDS_VALUE_T nc__block_t
 #define TDS_TYPE nc__block_dense_pool_t
 #define TDS_INITIAL_CAPACITY NC__CHUNK_COUNT
 #include <tds/dense-pool.h>
 static nc__block_dense_pool_t nc__chunk;
+// Handle of the block at every position of the chunk, for neighbor lookups. 0 is air, it's never a valid handle.
+static uint32_t* nc__block_handles;
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE nc__light_queue_t
+#include <tds/vector.h>
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE nc__face_vector_t
+#include <tds/vector.h>
+
+// The visible faces of a section, one list per direction, so that the directions facing away from the camera are
+// skipped whole.
+typedef struct nc__section_t {
+    nc__face_vector_t faces[6];
+    // The region of nc__face_buffer the section was given by nc__upload_faces, in faces, and what's drawn from it.
+    uint32_t region_first, region_size;
+    uint32_t first_faces[6];
+    uint32_t face_counts[6];
+    // Needs meshing.
+    bool dirty;
+    // Meshed but not uploaded yet.
+    bool stale;
+} nc__section_t;
+
+static nc__section_t nc__sections[NC__SECTION_COUNT];
+static nc__section_draw_t nc__section_draws[NC__SECTION_COUNT];
+static bool nc__sections_dirty, nc__sections_stale;
+// The regions of nc__face_buffer are handed out from here on.
+static uint32_t nc__face_buffer_end;
+static uint8_t* nc__light;
+static nc__light_queue_t nc__light_queue, nc__light_removal_queue;
+// Bounds of the light changed since the last upload to nc__light_texture.
+static bool nc__light_dirty;
+static vkm_ubvec3 nc__light_dirty_min, nc__light_dirty_max;
+static SDL_GPUTexture* nc__light_texture;
+// Scales skylight in cube.vert, so the time of day never touches nc__light.
+static float nc__sky_brightness = 1.0f;
 static bool nc__foreground = true;
-static SDL_GPUBuffer* nc__vertex_buffer;
-static SDL_GPUTransferBuffer* nc__transfer_buffer;
+// Set for changes to what the window shows that nc__frame_needed can't see otherwise, cleared once a frame is drawn.
+static bool nc__redraw = true;
+// The state the last frame was drawn with.
+static nc__camera_t nc__drawn_camera;
+static vkm_usvec2 nc__drawn_scene_size;
+static Uint64 nc__drawn_ticks;
+static SDL_GPUBuffer* nc__face_buffer;
+// A ring of staging memory, see nc__allocate_staging. Mapped from nc__begin_staging to nc__submit_frame.
+static SDL_GPUTransferBuffer* nc__staging_buffer;
+static uint8_t* nc__staging_mapped;
+// Bytes ever allocated and ever given back, the difference is in use. Wrapped into the buffer when indexing.
+static Uint64 nc__staging_head, nc__staging_tail;
+// The frames in flight, from the oldest at nc__frame_index.
+static nc__frame_t nc__frames[NC__FRAMES_IN_FLIGHT];
+static unsigned nc__frame_index;
+// Its position is interpolated between the player's positions at the last two ticks. Its orientation follows the mouse
+// and touches every frame, outside of ticks, to respond as fast as possible.
 static nc__camera_t nc__camera = {
-    .position = { { 127.5f, 127.5f, 124.0f } },
+    .position = NC__SPAWN_POSITION,
 };
+static vkm_vec3 nc__player_position = NC__SPAWN_POSITION, nc__previous_player_position = NC__SPAWN_POSITION;
+// Time that has passed but hasn't been simulated by a tick yet, in seconds.
+static double nc__tick_time;
 static const bool* nc__keyboard_state;
+static nc__block_registry_t nc__blocks;
 static SDL_GPUTexture* nc__terrain_textures;
+static SDL_GPUBuffer* nc__face_layer_buffer;
 static SDL_GPUSampler* nc__texture_sampler;
-static SDL_GPUGraphicsPipeline* nc__pipeline, *nc__reticle_pipeline;
+// Picked with F1 to F5, in this order.
+static const nc__pacing_profile_t nc__pacing_profiles[] = {
+    { "VSync", SDL_GPU_PRESENTMODE_VSYNC, 2, 0 },
+    { "Low latency", SDL_GPU_PRESENTMODE_MAILBOX, 1, 0 },
+    { "Uncapped", SDL_GPU_PRESENTMODE_IMMEDIATE, 3, 0 },
+    // Phones with 90 and 120 Hz screens heat up and throttle at their full refresh rate.
+    { "60 FPS", SDL_GPU_PRESENTMODE_VSYNC, 2, 60 },
+    { "Battery saver", SDL_GPU_PRESENTMODE_VSYNC, 1, 30 },
+};
+
+static SDL_GPUGraphicsPipeline* nc__pipeline, *nc__reticle_pipeline, *nc__upscale_pipeline;
+static SDL_GPUSampler* nc__upscale_sampler;
+static SDL_GPUTextureFormat nc__swapchain_format;
+static const nc__pacing_profile_t* nc__pacing_profile;
+// Set once a profile is picked by hand, which turns off switching to the battery saver automatically.
+static bool nc__pacing_profile_picked;
+// When the frame rate cap lets the next frame start.
+static Uint64 nc__next_frame_ticks;
 static nc__touch_event_t nc__move_touch, nc__look_touch;
-static nc__block_type selected_type = NC__BLOCK_TYPE_STONE;
+static nc__block_type selected_type = 1;
+
+// In the order of the faces in cube.vert.
+static const vkm_bvec3 nc__directions[] = {
+    { { 1, 0, 0 } },
+    { { -1, 0, 0 } },
+    { { 0, 1, 0 } },
+    { { 0, -1, 0 } },
+    { { 0, 0, -1 } },
+    { { 0, 0, 1 } },
+};
 
-static bool nc__load_astc_header(const char* data, nc__astc_header* header) {
-    if (*(uint32_t*)data != 0x5ca1ab13) {
-        return SDL_SetError("Invalid ASTC header.");
+// Same as cube_corners in cube.vert.
+static const vkm_ubvec3 nc__face_corners[][4] = {
+    { { { 1, 1, 0 } }, { { 1, 0, 0 } }, { { 1, 0, 1 } }, { { 1, 1, 1 } } },
+    { { { 0, 1, 1 } }, { { 0, 0, 1 } }, { { 0, 0, 0 } }, { { 0, 1, 0 } } },
+    { { { 0, 1, 1 } }, { { 0, 1, 0 } }, { { 1, 1, 0 } }, { { 1, 1, 1 } } },
+    { { { 0, 0, 0 } }, { { 0, 0, 1 } }, { { 1, 0, 1 } }, { { 1, 0, 0 } } },
+    { { { 0, 1, 0 } }, { { 0, 0, 0 } }, { { 1, 0, 0 } }, { { 1, 1, 0 } } },
+    { { { 1, 1, 1 } }, { { 1, 0, 1 } }, { { 0, 0, 1 } }, { { 0, 1, 1 } } },
+};
+
+static void nc__close_pack(void) {
+    if (!nc__pack) {
+        return;
     }
 
-    memcpy(header, data, sizeof(*header));
-    return true;
+#ifdef ANDROID
+    SDL_CloseIO(nc__pack_stream);
+    nc__pack_stream = NULL;
+#elif defined(_WIN32)
+    UnmapViewOfFile(nc__pack);
+#else
+    munmap((void*)nc__pack, nc__pack_size);
+#endif
+    nc__pack = NULL;
+    nc__pack_size = 0;
+    // It points into the pack.
+    nc__blocks = (nc__block_registry_t){ 0 };
 }
 
-// TODO: Review for memory correctness.
-static bool nc__load_texture(const char* path, char* data, const unsigned index) {
+// Maps the asset pack for the lifetime of the game, so loading an asset is a lookup and the page cache does the rest.
+static bool nc__open_pack(void) {
 #ifdef ANDROID
-    size_t size;
-    char* file_data = SDL_LoadFile(path, &size);
-    if (!file_data) {
+    // The pack is stored uncompressed in the APK (see build.gradle), which lets the asset manager map it in place.
+    nc__pack_stream = SDL_IOFromFile(NC__PACK_PATH, "rb");
+    if (!nc__pack_stream) {
         return false;
     }
-    if (size < sizeof(nc__astc_header)) {
-        SDL_free(file_data);
-        return false;
+
+    AAsset* asset = SDL_GetPointerProperty(
+        SDL_GetIOProperties(nc__pack_stream),
+        SDL_PROP_IOSTREAM_ANDROID_AASSET_POINTER,
+        NULL);
+    nc__pack = asset ? AAsset_getBuffer(asset) : NULL;
+    if (!nc__pack) {
+        SDL_CloseIO(nc__pack_stream);
+        nc__pack_stream = NULL;
+        return SDL_SetError("Couldn't map %s.", NC__PACK_PATH);
+    }
+    nc__pack_size = (size_t)AAsset_getLength64(asset);
+#elif defined(_WIN32)
+    const HANDLE file = CreateFileA(
+        NC__PACK_PATH,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return SDL_SetError("Couldn't open %s.", NC__PACK_PATH);
     }
 
-    nc__astc_header header;
-    if (!nc__load_astc_header(file_data, &header)) {
-        SDL_free(file_data);
-        return false;
+    LARGE_INTEGER file_size;
+    const HANDLE mapping = GetFileSizeEx(file, &file_size)
+        ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)
+        : NULL;
+    CloseHandle(file);
+    if (!mapping) {
+        return SDL_SetError("Couldn't map %s.", NC__PACK_PATH);
     }
 
-    assert(header.block_x == 4);
-    assert(header.block_y == 4);
-    assert(header.block_z == 1);
-    // max 65535x65535 image
-    assert(!header.dim_x[2] && !header.dim_y[2]);
-    // z dimension must be 1 for 2D images
-    assert(header.dim_z[0] == 1 && !header.dim_z[1] && !header.dim_z[2]);
+    // The view keeps the mapping alive.
+    nc__pack = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!nc__pack) {
+        return SDL_SetError("Couldn't map %s.", NC__PACK_PATH);
+    }
+    nc__pack_size = (size_t)file_size.QuadPart;
+#else
+    const int file = open(NC__PACK_PATH, O_RDONLY);
+    if (file < 0) {
+        return SDL_SetError("Couldn't open %s.", NC__PACK_PATH);
+    }
 
-#ifndef NDEBUG
-    const uint16_t width = *(uint16_t*)header.dim_x;
-    assert(!header.dim_x[2]);
-    const uint16_t height = *(uint16_t*)header.dim_y;
-    assert(!header.dim_y[2]);
-    assert(width == height && width == NC__TERRAIN_TEXTURE_LENGTH);
+    struct stat file_stat;
+    void* mapping = fstat(file, &file_stat) || !file_stat.st_size
+        ? MAP_FAILED
+        : mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED) {
+        return SDL_SetError("Couldn't map %s.", NC__PACK_PATH);
+    }
+
+    nc__pack = mapping;
+    nc__pack_size = (size_t)file_stat.st_size;
 #endif
 
-    memcpy(data + NC__TERRAIN_TEXTURE_SIZE * index, file_data + sizeof(header), NC__TERRAIN_TEXTURE_SIZE);
-    SDL_free(file_data);
+    // Validate the whole table of contents once so lookups can trust it.
+    const nc__pack_header_t* header = nc__pack;
+    if (nc__pack_size < sizeof(*header)
+        || memcmp(header->magic, "NCPK", sizeof(header->magic))
+        || header->version != NC__PACK_VERSION
+        || header->entry_count > (nc__pack_size - sizeof(*header)) / sizeof(nc__pack_entry_t)) {
+        nc__close_pack();
+        return SDL_SetError("%s is not a valid asset pack.", NC__PACK_PATH);
+    }
+
+    const nc__pack_entry_t* entries = (const nc__pack_entry_t*)(header + 1);
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        if (entries[i].offset > nc__pack_size
+            || entries[i].size > nc__pack_size - entries[i].offset
+            || !memchr(entries[i].name, '\0', sizeof(entries[i].name))) {
+            nc__close_pack();
+            return SDL_SetError("%s is not a valid asset pack.", NC__PACK_PATH);
+        }
+    }
 
+    SDL_Log("Mapped %u assets from %s.", (unsigned)header->entry_count, NC__PACK_PATH);
     return true;
-#else
-    SDL_Surface* texture = SDL_LoadPNG(path);
-    if (!texture) {
+}
+
+// Returns a pointer into the mapped pack, valid until nc__close_pack.
+static const void* nc__find_asset(const char* name, size_t* size) {
+    const nc__pack_header_t* header = nc__pack;
+    const nc__pack_entry_t* entries = (const nc__pack_entry_t*)(header + 1);
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        if (!strcmp(entries[i].name, name)) {
+            *size = entries[i].size;
+            return (const char*)nc__pack + entries[i].offset;
+        }
+    }
+
+    SDL_SetError("%s is missing from %s.", name, NC__PACK_PATH);
+    return NULL;
+}
+
+// Points nc__blocks into the pack, after checking that everything it holds fits in the entry.
+static bool nc__load_block_registry(void) {
+    size_t size;
+    const uint8_t* data = nc__find_asset("blocks", &size);
+    if (!data) {
         return false;
     }
-    assert(texture->format == SDL_PIXELFORMAT_RGBA32);
-    assert(texture->w == texture->h && texture->w == NC__TERRAIN_TEXTURE_LENGTH);
 
-    memcpy(data + NC__TERRAIN_TEXTURE_SIZE * index, texture->pixels, NC__TERRAIN_TEXTURE_SIZE);
-    SDL_DestroySurface(texture);
+    uint32_t counts[2];
+    if (size < sizeof(counts)) {
+        return SDL_SetError("The block registry is truncated.");
+    }
+    memcpy(counts, data, sizeof(counts));
+    const uint32_t type_count = counts[0], texture_count = counts[1];
+    // Types have to fit in a face word, and layers in the 16 bits the face layer table has for them.
+    if (type_count < 2 || !texture_count || type_count > NC__FACE_TYPE_LIMIT || texture_count > UINT16_MAX + 1) {
+        return SDL_SetError("The block registry has %u types and %u textures.", type_count, texture_count);
+    }
+
+    const size_t bitset_size = (type_count + 31) / 32 * sizeof(uint32_t);
+    const size_t light_size = (type_count + 3) / 4 * 4;
+    const size_t face_layers_size = (size_t)type_count * NC__COUNTOF(nc__directions) * sizeof(uint16_t);
+    const size_t expected_size = sizeof(counts) + 3 * bitset_size + light_size + face_layers_size
+        + type_count * sizeof(*nc__blocks.type_names) + texture_count * sizeof(*nc__blocks.texture_names);
+    if (size != expected_size) {
+        return SDL_SetError("The block registry is %zu bytes, expected %zu.", size, expected_size);
+    }
+
+    const uint8_t* position = data + sizeof(counts);
+    nc__block_registry_t blocks = {
+        .type_count = type_count,
+        .texture_count = texture_count,
+    };
+    blocks.opaque = (const uint32_t*)position;
+    position += bitset_size;
+    blocks.solid = (const uint32_t*)position;
+    position += bitset_size;
+    blocks.emissive = (const uint32_t*)position;
+    position += bitset_size;
+    blocks.light_emission = position;
+    position += light_size;
+    blocks.face_layers = (const uint16_t*)position;
+    position += face_layers_size;
+    blocks.type_names = (const char (*)[32])position;
+    position += type_count * sizeof(*blocks.type_names);
+    blocks.texture_names = (const char (*)[56])position;
+
+    for (uint32_t i = 0; i < type_count; i++) {
+        if (!memchr(blocks.type_names[i], '\0', sizeof(*blocks.type_names))
+            || blocks.light_emission[i] > NC__LIGHT_MAX) {
+            return SDL_SetError("Block type %u is invalid.", i);
+        }
+        for (unsigned face = 0; face < NC__COUNTOF(nc__directions); face++) {
+            if (blocks.face_layers[i * NC__COUNTOF(nc__directions) + face] >= texture_count) {
+                return SDL_SetError("Block type %s uses a missing texture.", blocks.type_names[i]);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < texture_count; i++) {
+        if (!memchr(blocks.texture_names[i], '\0', sizeof(*blocks.texture_names))) {
+            return SDL_SetError("Texture %u of the block registry is invalid.", i);
+        }
+    }
+
+    nc__blocks = blocks;
+    SDL_Log("Loaded %u block types using %u textures.", type_count - 1, texture_count);
+    return true;
+}
+
+// Branch free, for the inner loops.
+static bool nc__block_is(const uint32_t* property, const nc__block_type type) {
+    return property[type >> 5] >> (type & 31) & 1;
+}
+
+// Returns 0 if the registry has no such block.
+static nc__block_type nc__find_block_type(const char* name) {
+    for (uint32_t i = 1; i < nc__blocks.type_count; i++) {
+        if (!strcmp(nc__blocks.type_names[i], name)) {
+            return (nc__block_type)i;
+        }
+    }
+    return NC__BLOCK_TYPE_AIR;
+}
+
+// Pass a block size of 0 for RGBA8. Levels smaller than a block still take a whole one.
+static Uint32 nc__terrain_level_size(const Uint32 block_size, const unsigned level) {
+    const Uint32 length = NC__TERRAIN_LEVEL_LENGTH(level);
+    if (!block_size) {
+        return length * length * 4;
+    }
+
+    const Uint32 blocks = (length + 3) / 4;
+    return blocks * blocks * block_size;
+}
+
+// A terrain texture with its whole mip chain, largest level first.
+static Uint32 nc__terrain_texture_size(const Uint32 block_size) {
+    Uint32 size = 0;
+    for (unsigned level = 0; level < NC__TERRAIN_TEXTURE_LEVELS; level++) {
+        size += nc__terrain_level_size(block_size, level);
+    }
+    return size;
+}
+
+static Uint32 nc__terrain_upload_size(const nc__texture_encoding_t* encoding) {
+    return nc__terrain_texture_size(encoding->decode_bc1 ? 0 : encoding->block_size);
+}
+
+static bool nc__find_terrain_texture(
+    const char* name,
+    const nc__texture_encoding_t* encoding,
+    const uint8_t** texture
+) {
+    char entry_name[sizeof(((nc__pack_entry_t*)NULL)->name)];
+    SDL_snprintf(entry_name, sizeof(entry_name), "%s%s", name, encoding->suffix);
 
+    size_t size;
+    *texture = nc__find_asset(entry_name, &size);
+    if (!*texture) {
+        return false;
+    }
+    if (size != nc__terrain_texture_size(encoding->block_size)) {
+        return SDL_SetError(
+            "%s is %zu bytes, expected %u.",
+            entry_name,
+            size,
+            (unsigned)nc__terrain_texture_size(encoding->block_size));
+    }
+    return true;
+}
+
+static const nc__texture_encoding_t* nc__choose_texture_encoding(void) {
+    for (unsigned i = 0; i < NC__COUNTOF(nc__texture_encodings); i++) {
+        const uint8_t* texture;
+        if (SDL_GPUTextureSupportsFormat(
+                nc__gpu_device,
+                nc__texture_encodings[i].format,
+                SDL_GPU_TEXTURETYPE_2D_ARRAY,
+                SDL_GPU_TEXTUREUSAGE_SAMPLER)
+            && nc__find_terrain_texture(nc__blocks.texture_names[0], nc__texture_encodings + i, &texture)) {
+            return nc__texture_encodings + i;
+        }
+    }
+
+    SDL_SetError("The GPU supports none of the texture formats in %s.", NC__PACK_PATH);
+    return NULL;
+}
+
+// Writes a width x height corner of the 4x4 texels of a BC1 block to rgba, which has a row every stride bytes.
+static void nc__decode_bc1_block(
+    const uint8_t* block,
+    uint8_t* rgba,
+    const Uint32 stride,
+    const Uint32 width,
+    const Uint32 height
+) {
+    const uint16_t endpoints[2] = {
+        (uint16_t)(block[0] | block[1] << 8),
+        (uint16_t)(block[2] | block[3] << 8),
+    };
+    const uint32_t indices = (uint32_t)block[4] | (uint32_t)block[5] << 8 | (uint32_t)block[6] << 16
+        | (uint32_t)block[7] << 24;
+
+    uint8_t palette[4][4];
+    for (unsigned i = 0; i < 2; i++) {
+        const unsigned red = endpoints[i] >> 11, green = endpoints[i] >> 5 & 0x3F, blue = endpoints[i] & 0x1F;
+        palette[i][0] = (uint8_t)(red << 3 | red >> 2);
+        palette[i][1] = (uint8_t)(green << 2 | green >> 4);
+        palette[i][2] = (uint8_t)(blue << 3 | blue >> 2);
+        palette[i][3] = 255;
+    }
+    for (unsigned channel = 0; channel < 3; channel++) {
+        const unsigned a = palette[0][channel], b = palette[1][channel];
+        if (endpoints[0] > endpoints[1]) {
+            palette[2][channel] = (uint8_t)((2 * a + b) / 3);
+            palette[3][channel] = (uint8_t)((a + 2 * b) / 3);
+        } else {
+            // The 3 color mode, the last index is transparent black.
+            palette[2][channel] = (uint8_t)((a + b) / 2);
+            palette[3][channel] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = endpoints[0] > endpoints[1] ? 255 : 0;
+
+    for (Uint32 y = 0; y < height; y++) {
+        for (Uint32 x = 0; x < width; x++) {
+            memcpy(rgba + y * stride + x * 4, palette[indices >> (y * 4 + x) * 2 & 3], 4);
+        }
+    }
+}
+
+static void nc__decode_bc1_texture(const uint8_t* texture, uint8_t* rgba) {
+    for (unsigned level = 0; level < NC__TERRAIN_TEXTURE_LEVELS; level++) {
+        const Uint32 length = NC__TERRAIN_LEVEL_LENGTH(level);
+        for (Uint32 y = 0; y < length; y += 4) {
+            for (Uint32 x = 0; x < length; x += 4) {
+                nc__decode_bc1_block(
+                    texture,
+                    rgba + (y * length + x) * 4,
+                    length * 4,
+                    SDL_min(length - x, 4),
+                    SDL_min(length - y, 4));
+                texture += NC__BC1_BLOCK_SIZE;
+            }
+        }
+        rgba += nc__terrain_level_size(0, level);
+    }
+}
+
+typedef struct nc__decode_job_t {
+    const uint8_t** textures;
+    uint8_t* data;
+    unsigned first, end;
+} nc__decode_job_t;
+
+static int nc__decode_terrain_textures(void* data) {
+    const nc__decode_job_t* job = data;
+    for (unsigned i = job->first; i < job->end; i++) {
+        nc__decode_bc1_texture(job->textures[i], job->data + (size_t)i * nc__terrain_texture_size(0));
+    }
+    return 0;
+}
+
+// Fills data, the mapped transfer buffer, with every texture of the block registry in the given encoding. Decoding is
+// split between threads, textures are copied as they are otherwise.
+static bool nc__load_terrain_textures(const nc__texture_encoding_t* encoding, uint8_t* data) {
+    const unsigned texture_count = nc__blocks.texture_count;
+    const uint8_t** textures = SDL_malloc(texture_count * sizeof(*textures));
+    if (!textures) {
+        return false;
+    }
+    for (unsigned i = 0; i < texture_count; i++) {
+        if (!nc__find_terrain_texture(nc__blocks.texture_names[i], encoding, textures + i)) {
+            SDL_free(textures);
+            return false;
+        }
+    }
+
+    if (!encoding->decode_bc1) {
+        const Uint32 size = nc__terrain_texture_size(encoding->block_size);
+        for (unsigned i = 0; i < texture_count; i++) {
+            memcpy(data + (size_t)i * size, textures[i], size);
+        }
+        SDL_free(textures);
+        return true;
+    }
+
+    const unsigned thread_count = (unsigned)SDL_clamp(
+        SDL_GetNumLogicalCPUCores(),
+        1,
+        (int)SDL_min(texture_count, NC__DECODE_THREAD_MAX));
+    nc__decode_job_t jobs[NC__DECODE_THREAD_MAX];
+    SDL_Thread* threads[NC__DECODE_THREAD_MAX] = { 0 };
+    for (unsigned i = 0; i < thread_count; i++) {
+        jobs[i] = (nc__decode_job_t){
+            .textures = textures,
+            .data = data,
+            .first = (unsigned)((size_t)texture_count * i / thread_count),
+            .end = (unsigned)((size_t)texture_count * (i + 1) / thread_count),
+        };
+    }
+    // This thread takes the first share, and any other one that couldn't get a thread of its own.
+    for (unsigned i = 1; i < thread_count; i++) {
+        threads[i] = SDL_CreateThread(nc__decode_terrain_textures, "nc__decode", jobs + i);
+    }
+    for (unsigned i = 0; i < thread_count; i++) {
+        if (!threads[i]) {
+            nc__decode_terrain_textures(jobs + i);
+        }
+    }
+    for (unsigned i = 1; i < thread_count; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDL_free(textures);
     return true;
-#endif
 }
 
 static SDL_GPUShader* nc__load_shader(
-    const char* path,
+    const char* name,
     const SDL_GPUShaderStage stage,
     const Uint32 sampler_count,
     const Uint32 uniform_buffer_count,
     const Uint32 storage_buffer_count,
     const Uint32 storage_texture_count
 ) {
-    void* code = NULL;
-    SDL_GPUShader* result = NULL;
-
     size_t code_size;
-    code = SDL_LoadFile(path, &code_size);
+    const void* code = nc__find_asset(name, &code_size);
     if (!code) {
         return NULL;
     }
 
-    result = SDL_CreateGPUShader(nc__gpu_device, &(SDL_GPUShaderCreateInfo){
+    return SDL_CreateGPUShader(nc__gpu_device, &(SDL_GPUShaderCreateInfo){
         .code_size = code_size,
         .code = code,
         .entrypoint = "main",
@@ -207,251 +837,1536 @@ static SDL_GPUShader* nc__load_shader(
         .num_storage_buffers = storage_buffer_count,
         .num_uniform_buffers = uniform_buffer_count,
     });
-
-    SDL_free(code);
-    return result;
 }
 
-SDL_AppResult SDL_AppInit(void** app_state, const int argc, char** argv) {
-    (void)app_state;
-    (void)argc;
-    (void)argv;
+static vkm_ubvec3 nc__chunk_position(const uint32_t index) {
+    return (vkm_ubvec3){ {
+        (uint8_t)(index % NC__CHUNK_LENGTH),
+        (uint8_t)(index / NC__CHUNK_LENGTH % NC__CHUNK_LENGTH),
+        (uint8_t)(index / (NC__CHUNK_LENGTH * NC__CHUNK_LENGTH)),
+    } };
+}
 
-    SDL_PropertiesID props = 0;
-    SDL_GPUTransferBuffer* transfer_buffer = NULL;
-    SDL_GPUCommandBuffer* command_buffer = NULL;
-    SDL_GPUShader
-            *vertex_shader = NULL,
-            *fragment_shader = NULL,
-            *reticle_vertex_shader = NULL,
-            *reticle_fragment_shader = NULL;
+// Returns false when the neighbor is outside the chunk.
+static bool nc__neighbor_index(const uint32_t index, const unsigned direction, uint32_t* neighbor) {
+    const vkm_ubvec3 position = nc__chunk_position(index);
+    const int x = position.x + nc__directions[direction].x;
+    const int y = position.y + nc__directions[direction].y;
+    const int z = position.z + nc__directions[direction].z;
+    if (x < 0 || x >= NC__CHUNK_LENGTH || y < 0 || y >= NC__CHUNK_LENGTH || z < 0 || z >= NC__CHUNK_LENGTH) {
+        return false;
+    }
 
-    SDL_Log("Novacube " NC__VERSION "\n"
-            "Build: " __DATE__ " " __TIME__ " " NC__BUILD_TYPE "\n"
-            "Git: " NC__GIT_DESCRIBE "\n"
-            "Commit: " NC__GIT_HASH);
+    *neighbor = NC__CHUNK_INDEX(x, y, z);
+    return true;
+}
 
-    SDL_SetHint(SDL_HINT_TOUCH_MOUSE_EVENTS, "0");
+// Air for handle 0.
+static nc__block_type nc__block_type_of(const uint32_t handle) {
+    return handle ? nc__block_dense_pool_t_get(&nc__chunk, handle).type : NC__BLOCK_TYPE_AIR;
+}
 
-    bool sdl_result = SDL_InitSubSystem(SDL_INIT_VIDEO);
-    NC__CHECK_SDL_RESULT(sdl_result);
+// 0 for air and outside the chunk.
+static uint32_t nc__block_handle_at(const vkm_ivec3 position) {
+    if (position.x < 0 || position.x >= NC__CHUNK_LENGTH
+        || position.y < 0 || position.y >= NC__CHUNK_LENGTH
+        || position.z < 0 || position.z >= NC__CHUNK_LENGTH) {
+        return 0;
+    }
+    return nc__block_handles[NC__CHUNK_INDEX(position.x, position.y, position.z)];
+}
 
-    props = SDL_CreateProperties();
-    NC__CHECK_SDL_RESULT(props);
-    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_SHADERS_SPIRV_BOOLEAN, true);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(
-            props,
-            SDL_PROP_GPU_DEVICE_CREATE_DEBUGMODE_BOOLEAN,
-#ifndef NDEBUG
-            true);
-#else
-            false);
-#endif
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(
-            props,
-            SDL_PROP_GPU_DEVICE_CREATE_PREFERLOWPOWER_BOOLEAN,
-            true);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_D3D12_ALLOW_FEWER_RESOURCE_SLOTS_BOOLEAN, true);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_CLIP_DISTANCE_BOOLEAN, false);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_DEPTH_CLAMPING_BOOLEAN, false);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_INDIRECT_DRAW_FIRST_INSTANCE_BOOLEAN, false);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_ANISOTROPY_BOOLEAN, false);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    SDL_GPUVulkanOptions options = {
-        .vulkan_api_version = VK_API_VERSION_1_0,
-    };
-    sdl_result = SDL_SetPointerProperty(props, SDL_PROP_GPU_DEVICE_CREATE_VULKAN_OPTIONS_POINTER, &options);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    nc__gpu_device = SDL_CreateGPUDeviceWithProperties(props);
-    NC__CHECK_SDL_RESULT(nc__gpu_device);
-    SDL_DestroyProperties(props);
+static uint8_t nc__get_light(const uint32_t index, const unsigned shift) {
+    return (uint8_t)(nc__light[index] >> shift & NC__LIGHT_MAX);
+}
 
-    props = SDL_GetGPUDeviceProperties(nc__gpu_device);
-    SDL_Log("%s", SDL_GetStringProperty(props, SDL_PROP_GPU_DEVICE_NAME_STRING, "Unknown GPU"));
+static void nc__set_light(const uint32_t index, const unsigned shift, const uint8_t level) {
+    nc__light[index] = (uint8_t)((nc__light[index] & ~(NC__LIGHT_MAX << shift)) | level << shift);
+
+    const vkm_ubvec3 position = nc__chunk_position(index);
+    if (nc__light_dirty) {
+        vkm_min(&nc__light_dirty_min, &position, &nc__light_dirty_min);
+        vkm_max(&nc__light_dirty_max, &position, &nc__light_dirty_max);
+    } else {
+        nc__light_dirty_min = position;
+        nc__light_dirty_max = position;
+        nc__light_dirty = true;
+    }
+}
 
-    SDL_WindowFlags flags = SDL_WINDOW_RESIZABLE;
-#ifdef ANDROID
-    // Android always has a fullscreen
-    flags |= SDL_WINDOW_FULLSCREEN;
-#endif
+// Floods light from the positions in nc__light_queue into the air and the blocks that aren't opaque around them, one
+// level dimmer per step. Skylight at full strength goes straight down without fading.
+static void nc__spread_light(const unsigned shift) {
+    for (uint32_t i = 0; i < nc__light_queue.count; i++) {
+        const uint32_t index = nc__light_queue.array[i];
+        const int level = nc__get_light(index, shift);
+        for (unsigned direction = 0; direction < NC__COUNTOF(nc__directions); direction++) {
+            uint32_t neighbor;
+            if (!nc__neighbor_index(index, direction, &neighbor)
+                || nc__block_is(nc__blocks.opaque, nc__block_type_of(nc__block_handles[neighbor]))) {
+                continue;
+            }
 
-    nc__window = SDL_CreateWindow("Novacube " NC__VERSION, 640, 480, flags);
-    NC__CHECK_SDL_RESULT(nc__window);
-    // get the actual window dimensions
-    int width, height;
-    sdl_result = SDL_GetWindowSize(nc__window, &width, &height);
-    NC__CHECK_SDL_RESULT(sdl_result);
-    nc__viewport_size.x = (uint16_t)width;
-    nc__viewport_size.y = (uint16_t)height;
+            const int new_level = shift == NC__SKY_LIGHT_SHIFT
+                && direction == NC__DIRECTION_DOWN
+                && level == NC__LIGHT_MAX ? level : level - 1;
+            if (nc__get_light(neighbor, shift) < new_level) {
+                nc__set_light(neighbor, shift, (uint8_t)new_level);
+                nc__light_queue_t_append(&nc__light_queue, neighbor);
+            }
+        }
+    }
+    nc__light_queue_t_clear(&nc__light_queue);
+}
 
-    sdl_result = SDL_ClaimWindowForGPUDevice(nc__gpu_device, nc__window);
-    NC__CHECK_SDL_RESULT(sdl_result);
+// Darkens everything that was lit through the positions in nc__light_removal_queue, which carry their former level.
+// Lit neighbors that don't depend on them are queued in nc__light_queue, so that nc__spread_light fills the gap back in.
+static void nc__remove_light(const unsigned shift) {
+    for (uint32_t i = 0; i < nc__light_removal_queue.count; i++) {
+        const uint32_t index = NC__LIGHT_NODE_INDEX(nc__light_removal_queue.array[i]);
+        const uint8_t level = NC__LIGHT_NODE_LEVEL(nc__light_removal_queue.array[i]);
+        for (unsigned direction = 0; direction < NC__COUNTOF(nc__directions); direction++) {
+            uint32_t neighbor;
+            if (!nc__neighbor_index(index, direction, &neighbor)) {
+                continue;
+            }
 
-    nc__depth_texture = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
-        .width = width,
-        .height = height,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = SDL_GPU_SAMPLECOUNT_1,
-    });
-    NC__CHECK_SDL_RESULT(nc__depth_texture);
+            const uint8_t neighbor_level = nc__get_light(neighbor, shift);
+            if (!neighbor_level) {
+                continue;
+            }
 
-    for (int z = 126; z < 129; z++) {
-        for (int y = 126; y < 129; y++) {
-            for (int x = 126; x < 129; x++) {
-                nc__block_dense_pool_t_append(&nc__chunk, (nc__block_t){
-                    .position = { { (uint8_t)x, (uint8_t)y, (uint8_t)z } },
-                    .type = y == 126 ? NC__BLOCK_TYPE_STONE : y == 127 ? NC__BLOCK_TYPE_DIRT : NC__BLOCK_TYPE_GRASS,
-                });
+            // Glowing blocks keep their own light.
+            const bool glowing = shift == NC__BLOCK_LIGHT_SHIFT
+                && nc__block_is(nc__blocks.emissive, nc__block_type_of(nc__block_handles[neighbor]));
+            if (!glowing && (neighbor_level < level || (shift == NC__SKY_LIGHT_SHIFT
+                && direction == NC__DIRECTION_DOWN
+                && level == NC__LIGHT_MAX))) {
+                nc__set_light(neighbor, shift, 0);
+                nc__light_queue_t_append(&nc__light_removal_queue, NC__LIGHT_NODE(neighbor, neighbor_level));
+            } else {
+                nc__light_queue_t_append(&nc__light_queue, neighbor);
             }
         }
     }
+    nc__light_queue_t_clear(&nc__light_removal_queue);
+}
 
-    nc__vertex_buffer = SDL_CreateGPUBuffer(nc__gpu_device, &(SDL_GPUBufferCreateInfo){
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-        .size = NC__CHUNK_SIZE,
-    });
-    NC__CHECK_SDL_RESULT(nc__vertex_buffer);
-    nc__transfer_buffer = SDL_CreateGPUTransferBuffer(nc__gpu_device, &(SDL_GPUTransferBufferCreateInfo){
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = NC__CHUNK_SIZE,
-    });
-    NC__CHECK_SDL_RESULT(nc__transfer_buffer);
+// Lights the whole chunk from scratch, once after generating it. Changes to blocks are handled incrementally by
+// nc__place_block and nc__remove_block.
+static void nc__compute_light(void) {
+    // Lowest y reached by direct skylight, for each column.
+    static uint16_t sky_heights[NC__CHUNK_LENGTH * NC__CHUNK_LENGTH];
 
-    nc__terrain_textures = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
-        .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
-#ifdef ANDROID
-        .format = SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM,
-#else
-        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
-#endif
-        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
-        .width = 16,
-        .height = 16,
-        .layer_count_or_depth = NC__BLOCK_TYPE_COUNT,
-        .num_levels = 1,
-    });
+    SDL_memset(sky_heights, 0, sizeof(sky_heights));
+    for (uint32_t i = 0; i < nc__chunk.count; i++) {
+        const nc__block_t block = nc__chunk.array[i];
+        if (!nc__block_is(nc__blocks.opaque, block.type)) {
+            continue;
+        }
+        uint16_t* sky_height = sky_heights + block.position.x + block.position.z * NC__CHUNK_LENGTH;
+        *sky_height = SDL_max(*sky_height, block.position.y + 1);
+    }
 
-    nc__texture_sampler = SDL_CreateGPUSampler(nc__gpu_device, &(SDL_GPUSamplerCreateInfo){
-        .min_filter = SDL_GPU_FILTER_NEAREST,
-        .mag_filter = SDL_GPU_FILTER_NEAREST,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+    // In memory order, the chunk is mostly empty.
+    for (int z = 0; z < NC__CHUNK_LENGTH; z++) {
+        for (int y = 0; y < NC__CHUNK_LENGTH; y++) {
+            uint8_t* row = nc__light + NC__CHUNK_INDEX(0, y, z);
+            for (int x = 0; x < NC__CHUNK_LENGTH; x++) {
+                row[x] = y >= sky_heights[x + z * NC__CHUNK_LENGTH] ? NC__LIGHT_MAX << NC__SKY_LIGHT_SHIFT : 0;
+            }
+        }
+    }
+
+    // Only the lit air next to a taller column can light anything that skylight doesn't reach directly.
+    for (int z = 0; z < NC__CHUNK_LENGTH; z++) {
+        for (int x = 0; x < NC__CHUNK_LENGTH; x++) {
+            const int sky_height = sky_heights[x + z * NC__CHUNK_LENGTH];
+            int neighbor_sky_height = sky_height;
+            for (unsigned direction = 0; direction < NC__COUNTOF(nc__directions); direction++) {
+                const int neighbor_x = x + nc__directions[direction].x, neighbor_z = z + nc__directions[direction].z;
+                if (nc__directions[direction].y
+                    || neighbor_x < 0 || neighbor_x >= NC__CHUNK_LENGTH
+                    || neighbor_z < 0 || neighbor_z >= NC__CHUNK_LENGTH) {
+                    continue;
+                }
+                neighbor_sky_height = SDL_max(neighbor_sky_height, sky_heights[neighbor_x + neighbor_z * NC__CHUNK_LENGTH]);
+            }
+            for (int y = sky_height; y < neighbor_sky_height; y++) {
+                nc__light_queue_t_append(&nc__light_queue, NC__CHUNK_INDEX(x, y, z));
+            }
+        }
+    }
+    nc__spread_light(NC__SKY_LIGHT_SHIFT);
+
+    for (uint32_t i = 0; i < nc__chunk.count; i++) {
+        const nc__block_t block = nc__chunk.array[i];
+        if (nc__block_is(nc__blocks.emissive, block.type)) {
+            const uint32_t index = NC__CHUNK_INDEX(block.position.x, block.position.y, block.position.z);
+            nc__set_light(index, NC__BLOCK_LIGHT_SHIFT, nc__blocks.light_emission[block.type]);
+            nc__light_queue_t_append(&nc__light_queue, index);
+        }
+    }
+    nc__spread_light(NC__BLOCK_LIGHT_SHIFT);
+
+    nc__light_dirty = true;
+    nc__light_dirty_min = (vkm_ubvec3){ { 0, 0, 0 } };
+    nc__light_dirty_max = (vkm_ubvec3){ { NC__CHUNK_LENGTH - 1, NC__CHUNK_LENGTH - 1, NC__CHUNK_LENGTH - 1 } };
+}
+
+static bool nc__is_opaque(const vkm_ivec3 position) {
+    return nc__block_is(nc__blocks.opaque, nc__block_type_of(nc__block_handle_at(position)));
+}
+
+// Each face corner is darkened by the opaque blocks touching it in front of the face: the two along its edges and the
+// one diagonally across. Both edges blocked is as dark as it gets, whatever the diagonal.
+static void nc__compute_ambient_occlusion(nc__block_t* block) {
+    for (unsigned face = 0; face < NC__COUNTOF(nc__directions); face++) {
+        const vkm_bvec3 normal = nc__directions[face];
+        const vkm_ivec3 front = { {
+            block->position.x + normal.x,
+            block->position.y + normal.y,
+            block->position.z + normal.z,
+        } };
+
+        uint8_t face_ambient_occlusion = 0;
+        for (unsigned corner = 0; corner < 4; corner++) {
+            vkm_ivec3 sides[2] = { front, front }, diagonal = front;
+            unsigned side = 0;
+            for (unsigned axis = 0; axis < 3; axis++) {
+                if (!normal.raw[axis]) {
+                    const int step = nc__face_corners[face][corner].raw[axis] ? 1 : -1;
+                    sides[side++].raw[axis] += step;
+                    diagonal.raw[axis] += step;
+                }
+            }
+
+            const int first = nc__is_opaque(sides[0]), second = nc__is_opaque(sides[1]);
+            const int ambient_occlusion = first && second ? 0 : 3 - first - second - nc__is_opaque(diagonal);
+            face_ambient_occlusion |= (uint8_t)(ambient_occlusion << corner * 2);
+        }
+        block->ambient_occlusion[face] = face_ambient_occlusion;
+    }
+}
+
+// Bakes the ambient occlusion again for the blocks around position, which just changed.
+static void nc__update_ambient_occlusion(const vkm_ubvec3 position) {
+    for (int z = position.z - 1; z <= position.z + 1; z++) {
+        for (int y = position.y - 1; y <= position.y + 1; y++) {
+            for (int x = position.x - 1; x <= position.x + 1; x++) {
+                const uint32_t handle = nc__block_handle_at((vkm_ivec3){ { x, y, z } });
+                if (!handle) {
+                    continue;
+                }
+
+                nc__block_t block = nc__block_dense_pool_t_get(&nc__chunk, handle);
+                nc__compute_ambient_occlusion(&block);
+                nc__block_dense_pool_t_set(&nc__chunk, handle, block);
+            }
+        }
+    }
+}
+
+static vkm_ivec3 nc__section_origin(const uint32_t section_index) {
+    return (vkm_ivec3){ {
+        (int)(section_index % NC__SECTIONS_PER_AXIS) * NC__SECTION_LENGTH,
+        (int)(section_index / NC__SECTIONS_PER_AXIS % NC__SECTIONS_PER_AXIS) * NC__SECTION_LENGTH,
+        (int)(section_index / (NC__SECTIONS_PER_AXIS * NC__SECTIONS_PER_AXIS)) * NC__SECTION_LENGTH,
+    } };
+}
+
+// Whether a face and its ambient occlusion can change depends on the blocks next to it, so a change at position reaches
+// into the sections around it.
+static void nc__mark_sections_dirty(const vkm_ubvec3 position) {
+    for (int z = position.z - 1; z <= position.z + 1; z++) {
+        for (int y = position.y - 1; y <= position.y + 1; y++) {
+            for (int x = position.x - 1; x <= position.x + 1; x++) {
+                if (x < 0 || x >= NC__CHUNK_LENGTH || y < 0 || y >= NC__CHUNK_LENGTH || z < 0 || z >= NC__CHUNK_LENGTH) {
+                    continue;
+                }
+                nc__sections[NC__SECTION_INDEX(
+                    x / NC__SECTION_LENGTH,
+                    y / NC__SECTION_LENGTH,
+                    z / NC__SECTION_LENGTH)].dirty = true;
+            }
+        }
+    }
+    nc__sections_dirty = true;
+}
+
+// Orders the faces of a section pointing one way from the layer nearest to a camera that sees them to the farthest. Such
+// a camera is past the section's highest x when they point towards +x, for example, so the faces with the highest x come
+// first. This doesn't depend on where the camera is, and along with drawing sections front to back, it keeps the depth
+// test rejecting hidden faces before cube.frag runs.
+static void nc__sort_faces_by_layer(nc__face_vector_t* faces, const unsigned face) {
+    unsigned axis = 0;
+    while (!nc__directions[face].raw[axis]) {
+        axis++;
+    }
+    // Faces store their position in the section as 4 bits per axis, see NC__FACE.
+    const unsigned shift = axis * 4;
+    const uint32_t last_layer = nc__directions[face].raw[axis] > 0 ? NC__SECTION_LENGTH - 1 : 0;
+
+    // A counting sort, since there are only NC__SECTION_LENGTH layers.
+    uint32_t layer_starts[NC__SECTION_LENGTH + 1] = { 0 };
+    for (size_t i = 0; i < faces->count; i++) {
+        const uint32_t layer = (faces->array[i] >> shift & (NC__SECTION_LENGTH - 1)) ^ last_layer;
+        layer_starts[layer + 1]++;
+    }
+    for (unsigned layer = 0; layer < NC__SECTION_LENGTH; layer++) {
+        layer_starts[layer + 1] += layer_starts[layer];
+    }
+    uint32_t sorted[NC__SECTION_LENGTH * NC__SECTION_LENGTH * NC__SECTION_LENGTH];
+    for (size_t i = 0; i < faces->count; i++) {
+        const uint32_t layer = (faces->array[i] >> shift & (NC__SECTION_LENGTH - 1)) ^ last_layer;
+        sorted[layer_starts[layer]++] = faces->array[i];
+    }
+    memcpy(faces->array, sorted, faces->count * sizeof(uint32_t));
+}
+
+// Lists the faces of the blocks in a section that aren't hidden by an opaque block. The border of the chunk is open.
+static void nc__mesh_section(const uint32_t section_index) {
+    nc__section_t* section = nc__sections + section_index;
+    for (unsigned face = 0; face < NC__COUNTOF(section->faces); face++) {
+        nc__face_vector_t_clear(section->faces + face);
+    }
+
+    const vkm_ivec3 origin = nc__section_origin(section_index);
+    for (int z = 0; z < NC__SECTION_LENGTH; z++) {
+        for (int y = 0; y < NC__SECTION_LENGTH; y++) {
+            for (int x = 0; x < NC__SECTION_LENGTH; x++) {
+                const uint32_t handle = nc__block_handles[NC__CHUNK_INDEX(origin.x + x, origin.y + y, origin.z + z)];
+                if (!handle) {
+                    continue;
+                }
+
+                const nc__block_t block = nc__block_dense_pool_t_get(&nc__chunk, handle);
+                for (unsigned face = 0; face < NC__COUNTOF(nc__directions); face++) {
+                    const vkm_ivec3 front = { {
+                        origin.x + x + nc__directions[face].x,
+                        origin.y + y + nc__directions[face].y,
+                        origin.z + z + nc__directions[face].z,
+                    } };
+                    if (!nc__is_opaque(front)) {
+                        nc__face_vector_t_append(
+                            section->faces + face,
+                            NC__FACE(x, y, z, block.ambient_occlusion[face], block.type));
+                    }
+                }
+            }
+        }
+    }
+    for (unsigned face = 0; face < NC__COUNTOF(section->faces); face++) {
+        nc__sort_faces_by_layer(section->faces + face, face);
+    }
+    section->dirty = false;
+}
+
+static void nc__mesh_dirty_sections(void) {
+    if (!nc__sections_dirty) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < NC__SECTION_COUNT; i++) {
+        if (nc__sections[i].dirty) {
+            nc__mesh_section(i);
+            nc__sections[i].stale = true;
+        }
+    }
+    nc__sections_dirty = false;
+    nc__sections_stale = true;
+}
+
+static void nc__place_block(const nc__block_t block) {
+    const uint32_t index = NC__CHUNK_INDEX(block.position.x, block.position.y, block.position.z);
+    assert(!nc__block_handles[index]);
+    nc__block_handles[index] = nc__block_dense_pool_t_append(&nc__chunk, block);
+    nc__update_ambient_occlusion(block.position);
+    nc__mark_sections_dirty(block.position);
+
+    // Whatever was lit through this position goes dark behind an opaque block.
+    const unsigned shifts[] = { NC__SKY_LIGHT_SHIFT, NC__BLOCK_LIGHT_SHIFT };
+    for (unsigned i = 0; i < NC__COUNTOF(shifts) && nc__block_is(nc__blocks.opaque, block.type); i++) {
+        const uint8_t level = nc__get_light(index, shifts[i]);
+        if (level) {
+            nc__set_light(index, shifts[i], 0);
+            nc__light_queue_t_append(&nc__light_removal_queue, NC__LIGHT_NODE(index, level));
+            nc__remove_light(shifts[i]);
+            nc__spread_light(shifts[i]);
+        }
+    }
+
+    if (nc__block_is(nc__blocks.emissive, block.type)) {
+        nc__set_light(index, NC__BLOCK_LIGHT_SHIFT, nc__blocks.light_emission[block.type]);
+        nc__light_queue_t_append(&nc__light_queue, index);
+        nc__spread_light(NC__BLOCK_LIGHT_SHIFT);
+    }
+}
+
+static void nc__remove_block(const uint32_t handle) {
+    const nc__block_t block = nc__block_dense_pool_t_get(&nc__chunk, handle);
+    const uint32_t index = NC__CHUNK_INDEX(block.position.x, block.position.y, block.position.z);
+    nc__block_dense_pool_t_remove(&nc__chunk, handle);
+    nc__block_handles[index] = 0;
+    nc__update_ambient_occlusion(block.position);
+    nc__mark_sections_dirty(block.position);
+
+    if (nc__block_is(nc__blocks.emissive, block.type)) {
+        nc__set_light(index, NC__BLOCK_LIGHT_SHIFT, 0);
+        nc__light_queue_t_append(
+                &nc__light_removal_queue,
+                NC__LIGHT_NODE(index, nc__blocks.light_emission[block.type]));
+        nc__remove_light(NC__BLOCK_LIGHT_SHIFT);
+        // Before the queue is reused for skylight below.
+        nc__spread_light(NC__BLOCK_LIGHT_SHIFT);
+    }
+
+    // Let the light around the new air flow into it.
+    const unsigned shifts[] = { NC__SKY_LIGHT_SHIFT, NC__BLOCK_LIGHT_SHIFT };
+    for (unsigned i = 0; i < NC__COUNTOF(shifts); i++) {
+        for (unsigned direction = 0; direction < NC__COUNTOF(nc__directions); direction++) {
+            uint32_t neighbor;
+            if (nc__neighbor_index(index, direction, &neighbor) && nc__get_light(neighbor, shifts[i])) {
+                nc__light_queue_t_append(&nc__light_queue, neighbor);
+            }
+        }
+        nc__spread_light(shifts[i]);
+    }
+}
+
+// Gives back the staging memory of the frames the GPU is done with, then maps the staging buffer for this frame. When
+// every frame is still in flight, waits for the oldest one, which also keeps the CPU from getting too far ahead.
+static bool nc__begin_staging(void) {
+    for (unsigned i = 0; i < NC__FRAMES_IN_FLIGHT; i++) {
+        nc__frame_t* frame = nc__frames + (nc__frame_index + i) % NC__FRAMES_IN_FLIGHT;
+        const bool oldest = !i;
+        if (!frame->fence) {
+            continue;
+        }
+        if (!SDL_QueryGPUFence(nc__gpu_device, frame->fence)) {
+            // Frames finish in order.
+            if (!oldest) {
+                break;
+            }
+            if (!SDL_WaitForGPUFences(nc__gpu_device, true, &frame->fence, 1)) {
+                return false;
+            }
+        }
+
+        SDL_ReleaseGPUFence(nc__gpu_device, frame->fence);
+        frame->fence = NULL;
+        nc__staging_tail = frame->staging_end;
+    }
+
+    nc__staging_mapped = SDL_MapGPUTransferBuffer(nc__gpu_device, nc__staging_buffer, false);
+    return nc__staging_mapped;
+}
+
+// Returns size bytes of the staging buffer, which the GPU is done reading, at offset. Returns NULL when the frames in
+// flight use too much of it, callers then leave the rest of their uploads for the next frames.
+static void* nc__allocate_staging(const Uint32 size, Uint32* offset) {
+    Uint64 start = (nc__staging_head + NC__STAGING_ALIGNMENT - 1) / NC__STAGING_ALIGNMENT * NC__STAGING_ALIGNMENT;
+    // Allocations never wrap around the end of the buffer.
+    if (start % NC__STAGING_SIZE + size > NC__STAGING_SIZE) {
+        start += NC__STAGING_SIZE - start % NC__STAGING_SIZE;
+    }
+    if (start + size - nc__staging_tail > NC__STAGING_SIZE) {
+        return NULL;
+    }
+
+    nc__staging_head = start + size;
+    *offset = (Uint32)(start % NC__STAGING_SIZE);
+    return nc__staging_mapped + *offset;
+}
+
+// Submits the frame, keeping its fence to know when its staging memory is free again.
+static bool nc__submit_frame(SDL_GPUCommandBuffer* command_buffer) {
+    SDL_UnmapGPUTransferBuffer(nc__gpu_device, nc__staging_buffer);
+    nc__staging_mapped = NULL;
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+    if (!fence) {
+        return false;
+    }
+
+    // nc__begin_staging emptied this slot.
+    nc__frames[nc__frame_index] = (nc__frame_t){
+        .fence = fence,
+        .staging_end = nc__staging_head,
+    };
+    nc__frame_index = (nc__frame_index + 1) % NC__FRAMES_IN_FLIGHT;
+    return true;
+}
+
+// Every section starts over with an empty region, and isn't drawn until uploaded again.
+static void nc__reset_face_buffer(void) {
+    for (uint32_t i = 0; i < NC__SECTION_COUNT; i++) {
+        nc__section_t* section = nc__sections + i;
+        section->region_first = 0;
+        section->region_size = 0;
+        for (unsigned face = 0; face < NC__COUNTOF(section->faces); face++) {
+            section->stale |= section->face_counts[face] || section->faces[face].count;
+            section->face_counts[face] = 0;
+        }
+    }
+    nc__face_buffer_end = 0;
+    nc__sections_stale = true;
+}
+
+// Meshes the sections that changed and uploads them, each to its own region of nc__face_buffer: the one it had if its
+// faces still fit, otherwise a new one at the end. Once the end is reached, the buffer starts over. Sections that don't
+// fit in the staging buffer this frame keep drawing their previous faces until the next ones.
+static void nc__upload_faces(SDL_GPUCopyPass* copy_pass) {
+    nc__mesh_dirty_sections();
+    if (!nc__sections_stale) {
+        return;
+    }
+
+    bool stale = false;
+    for (uint32_t i = 0; i < NC__SECTION_COUNT; i++) {
+        nc__section_t* section = nc__sections + i;
+        if (!section->stale) {
+            continue;
+        }
+
+        uint32_t face_count = 0;
+        for (unsigned face = 0; face < NC__COUNTOF(section->faces); face++) {
+            face_count += section->faces[face].count;
+        }
+        if (!face_count) {
+            // The region is kept for when the section has faces again.
+            SDL_memset(section->face_counts, 0, sizeof(section->face_counts));
+            section->stale = false;
+            continue;
+        }
+        if (face_count > section->region_size && nc__face_buffer_end + face_count > NC__FACE_CAPACITY) {
+            // The uploads already made this frame went to regions that are handed out again, so leave it at that.
+            SDL_Log("The face buffer is full, uploading every section again.");
+            nc__reset_face_buffer();
+            stale = true;
+            break;
+        }
+
+        Uint32 offset;
+        uint32_t* staging = nc__allocate_staging(face_count * sizeof(uint32_t), &offset);
+        if (!staging) {
+            stale = true;
+            break;
+        }
+        if (face_count > section->region_size) {
+            section->region_first = nc__face_buffer_end;
+            section->region_size = face_count;
+            nc__face_buffer_end += face_count;
+        }
+
+        uint32_t first_face = section->region_first;
+        for (unsigned face = 0; face < NC__COUNTOF(section->faces); face++) {
+            const uint32_t count = section->faces[face].count;
+            memcpy(staging + (first_face - section->region_first), section->faces[face].array, count * sizeof(uint32_t));
+            section->first_faces[face] = first_face;
+            section->face_counts[face] = count;
+            first_face += count;
+        }
+        SDL_UploadToGPUBuffer(
+                copy_pass,
+                &(SDL_GPUTransferBufferLocation){
+                    .transfer_buffer = nc__staging_buffer,
+                    .offset = offset,
+                },
+                &(SDL_GPUBufferRegion){
+                    .buffer = nc__face_buffer,
+                    .offset = section->region_first * (Uint32)sizeof(uint32_t),
+                    .size = face_count * (Uint32)sizeof(uint32_t),
+                },
+                false);
+        section->stale = false;
+    }
+    nc__sections_stale = stale;
+}
+
+// The faces of a section facing one direction can only be seen from in front of the nearest of them.
+static bool nc__section_faces_camera(const vkm_ivec3 origin, const unsigned face) {
+    for (unsigned axis = 0; axis < 3; axis++) {
+        const int direction = nc__directions[face].raw[axis];
+        if (direction > 0 && nc__camera.position.raw[axis] <= (float)(origin.raw[axis] + 1)) {
+            return false;
+        }
+        if (direction < 0 && nc__camera.position.raw[axis] >= (float)(origin.raw[axis] + NC__SECTION_LENGTH - 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int nc__compare_section_draws(const void* a, const void* b) {
+    const float distance_squared_a = ((const nc__section_draw_t*)a)->distance_squared;
+    const float distance_squared_b = ((const nc__section_draw_t*)b)->distance_squared;
+    return (distance_squared_a > distance_squared_b) - (distance_squared_a < distance_squared_b);
+}
+
+// Lists the sections with faces the camera could see in nc__section_draws, nearest first, and returns how many there
+// are. Far faces drawn before the near ones hiding them would all be shaded; this way the depth test rejects them first.
+static uint32_t nc__sort_visible_sections(void) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < NC__SECTION_COUNT; i++) {
+        const nc__section_t* section = nc__sections + i;
+        const vkm_ivec3 origin = nc__section_origin(i);
+        bool visible = false;
+        for (unsigned face = 0; face < NC__COUNTOF(section->faces) && !visible; face++) {
+            visible = section->face_counts[face] && nc__section_faces_camera(origin, face);
+        }
+        if (!visible) {
+            continue;
+        }
+
+        const vkm_vec3 offset = { {
+            (float)origin.x + NC__SECTION_LENGTH / 2.0f - nc__camera.position.x,
+            (float)origin.y + NC__SECTION_LENGTH / 2.0f - nc__camera.position.y,
+            (float)origin.z + NC__SECTION_LENGTH / 2.0f - nc__camera.position.z,
+        } };
+        nc__section_draws[count++] = (nc__section_draw_t){
+            .distance_squared = vkm_dot(&offset, &offset),
+            .section_index = i,
+        };
+    }
+    SDL_qsort(nc__section_draws, count, sizeof(*nc__section_draws), nc__compare_section_draws);
+    return count;
+}
+
+// Copies the light changed since the last call to nc__light_texture, as many slices along z as the staging buffer has
+// room for. The rest stays dirty for the next frames.
+static void nc__upload_light(SDL_GPUCopyPass* copy_pass) {
+    if (!nc__light_dirty) {
+        return;
+    }
+
+    const Uint32 width = nc__light_dirty_max.x - nc__light_dirty_min.x + 1;
+    const Uint32 height = nc__light_dirty_max.y - nc__light_dirty_min.y + 1;
+    Uint32 depth = nc__light_dirty_max.z - nc__light_dirty_min.z + 1;
+    Uint32 offset;
+    uint8_t* staging = nc__allocate_staging(width * height * depth, &offset);
+    while (!staging && depth > 1) {
+        depth /= 2;
+        staging = nc__allocate_staging(width * height * depth, &offset);
+    }
+    if (!staging) {
+        return;
+    }
+
+    for (Uint32 z = 0; z < depth; z++) {
+        for (Uint32 y = 0; y < height; y++) {
+            memcpy(
+                    staging + (z * height + y) * width,
+                    nc__light + NC__CHUNK_INDEX(
+                            nc__light_dirty_min.x,
+                            nc__light_dirty_min.y + y,
+                            nc__light_dirty_min.z + z),
+                    width);
+        }
+    }
+
+    SDL_UploadToGPUTexture(
+            copy_pass,
+            &(SDL_GPUTextureTransferInfo){
+                .transfer_buffer = nc__staging_buffer,
+                .offset = offset,
+                .pixels_per_row = width,
+                .rows_per_layer = height,
+            },
+            &(SDL_GPUTextureRegion){
+                .texture = nc__light_texture,
+                .x = nc__light_dirty_min.x,
+                .y = nc__light_dirty_min.y,
+                .z = nc__light_dirty_min.z,
+                .w = width,
+                .h = height,
+                .d = depth,
+            },
+            false);
+
+    if (nc__light_dirty_min.z + depth > nc__light_dirty_max.z) {
+        nc__light_dirty = false;
+    } else {
+        nc__light_dirty_min.z = (uint8_t)(nc__light_dirty_min.z + depth);
+    }
+}
+
+static bool nc__apply_pacing_profile(const nc__pacing_profile_t* profile) {
+    SDL_GPUPresentMode present_mode = profile->present_mode;
+    if (!SDL_WindowSupportsGPUPresentMode(nc__gpu_device, nc__window, present_mode)) {
+        present_mode = SDL_GPU_PRESENTMODE_VSYNC;
+    }
+    if (!SDL_SetGPUSwapchainParameters(nc__gpu_device, nc__window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, present_mode)
+        || !SDL_SetGPUAllowedFramesInFlight(nc__gpu_device, profile->frames_in_flight)) {
+        return false;
+    }
+
+    // Without a frame rate cap, frames are due as often as the display refreshes.
+    const SDL_DisplayMode* display_mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(nc__window));
+    const float refresh_rate = display_mode && display_mode->refresh_rate > 0.0f ? display_mode->refresh_rate : 60.0f;
+    nc__frame_budget = 1.0 / (profile->target_fps ? SDL_min((float)profile->target_fps, refresh_rate) : refresh_rate);
+    nc__average_frame_time = 0.0;
+    nc__resolution_scale_limit = 1.0f;
+
+    nc__pacing_profile = profile;
+    nc__next_frame_ticks = 0;
+    nc__redraw = true;
+    SDL_Log(
+        "Frame pacing: %s%s, %u frames in flight, %u FPS cap",
+        profile->name,
+        present_mode == profile->present_mode ? "" : " (VSync fallback)",
+        (unsigned)profile->frames_in_flight,
+        (unsigned)profile->target_fps);
+    return true;
+}
+
+// Sleeps until the frame rate cap lets the next frame start. A frame that's late by less than a period keeps the
+// schedule, so the average stays on target. Further behind, the schedule starts over rather than rushing frames out to
+// catch up.
+static void nc__limit_frame_rate(void) {
+    if (!nc__pacing_profile->target_fps) {
+        return;
+    }
+
+    const Uint64 period = SDL_NS_PER_SECOND / nc__pacing_profile->target_fps;
+    const Uint64 ticks = SDL_GetTicksNS();
+    if (ticks < nc__next_frame_ticks) {
+        // Sleeps most of the time, then spins for the last stretch.
+        SDL_DelayPrecise(nc__next_frame_ticks - ticks);
+        nc__next_frame_ticks += period;
+    } else if (ticks - nc__next_frame_ticks < period) {
+        nc__next_frame_ticks += period;
+    } else {
+        nc__next_frame_ticks = ticks + period;
+    }
+}
+
+#ifndef NDEBUG
+// Logs the mean, standard deviation and worst of the frame times every NC__FRAME_STATS_INTERVAL, to compare how evenly
+// the pacing profiles deliver frames. Debug builds only, release builds shouldn't fill the log.
+static void nc__record_frame_time(const Uint64 ticks, const double frame_time) {
+    static Uint64 start_ticks;
+    static Uint32 frame_count;
+    static double sum, square_sum, worst;
+
+    if (!start_ticks) {
+        start_ticks = ticks;
+    }
+    frame_count++;
+    sum += frame_time;
+    square_sum += frame_time * frame_time;
+    worst = SDL_max(worst, frame_time);
+    if (ticks - start_ticks < NC__FRAME_STATS_INTERVAL) {
+        return;
+    }
+
+    const double mean = sum / frame_count;
+    SDL_Log(
+        "Frame time: %.2f ms mean, %.2f ms standard deviation, %.2f ms worst over %u frames (%s, %.0f%% resolution)",
+        mean * 1000.0,
+        SDL_sqrt(SDL_max(square_sum / frame_count - mean * mean, 0.0)) * 1000.0,
+        worst * 1000.0,
+        (unsigned)frame_count,
+        nc__pacing_profile->name,
+        nc__resolution_scale * 100.0f);
+    start_ticks = ticks;
+    frame_count = 0;
+    sum = square_sum = worst = 0.0;
+}
+#endif
+
+// Drops the resolution scale as soon as frames run over budget, then slowly raises it again while they don't. Frames
+// can't finish early under VSync or a frame rate cap, so there's no telling how much headroom there is, only whether
+// there is some. Raising it straight back to where frames ran over would drop it again every second or two, so it
+// stays a bit below that until the limit wears off.
+static void nc__update_resolution_scale(const double frame_time) {
+    // A single hitch, like remeshing after an edit, shouldn't cost resolution for the next few seconds.
+    const double sample = SDL_min(frame_time, nc__frame_budget * 2.0);
+    nc__average_frame_time = nc__average_frame_time == 0.0
+        ? sample
+        : nc__average_frame_time + (sample - nc__average_frame_time) * 0.1;
+
+    if (nc__average_frame_time > nc__frame_budget * 1.1) {
+        nc__resolution_scale_limit = nc__resolution_scale * 0.95f;
+        // The cost of drawing the scene goes with its pixel count, the square of the scale.
+        nc__resolution_scale = SDL_max(
+            nc__resolution_scale * (float)SDL_sqrt(nc__frame_budget / nc__average_frame_time),
+            NC__RESOLUTION_SCALE_MIN);
+        // Starts over, so the frames drawn before the drop don't lower it again.
+        nc__average_frame_time = nc__frame_budget;
+    } else if (nc__average_frame_time < nc__frame_budget * 1.02) {
+        nc__resolution_scale_limit = SDL_min(
+            nc__resolution_scale_limit + NC__RESOLUTION_SCALE_LIMIT_RECOVERY * (float)frame_time,
+            1.0f);
+        nc__resolution_scale = SDL_max(
+            SDL_min(nc__resolution_scale + NC__RESOLUTION_SCALE_RECOVERY * (float)frame_time, nc__resolution_scale_limit),
+            nc__resolution_scale);
+    }
+}
+
+// The size the scene is drawn at, in pixels. The scale creeps up a little every frame while it recovers, but only a
+// change in size makes for a different frame.
+static vkm_usvec2 nc__scene_size(void) {
+    return (vkm_usvec2){ {
+        (uint16_t)SDL_max((int)((float)nc__viewport_size.x * nc__resolution_scale + 0.5f), 1),
+        (uint16_t)SDL_max((int)((float)nc__viewport_size.y * nc__resolution_scale + 0.5f), 1),
+    } };
+}
+
+// (Re)creates the scene and depth textures at the window size.
+static bool nc__create_render_targets(void) {
+    SDL_ReleaseGPUTexture(nc__gpu_device, nc__scene_texture);
+    SDL_ReleaseGPUTexture(nc__gpu_device, nc__depth_texture);
+    nc__scene_texture = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = nc__swapchain_format,
+        // Sampled by the upscale pass.
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = nc__viewport_size.x,
+        .height = nc__viewport_size.y,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+    });
+    nc__depth_texture = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
+        .width = nc__viewport_size.x,
+        .height = nc__viewport_size.y,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+    });
+    return nc__scene_texture && nc__depth_texture;
+}
+
+// Switches to the battery saver profile when running low on battery, and back once charging, unless a profile was
+// picked by hand.
+static bool nc__check_battery(const Uint64 ticks) {
+    static Uint64 last_check_ticks;
+    if (nc__pacing_profile_picked || (last_check_ticks && ticks - last_check_ticks < NC__POWER_CHECK_INTERVAL)) {
+        return true;
+    }
+    last_check_ticks = ticks;
+
+    int percent;
+    const SDL_PowerState state = SDL_GetPowerInfo(NULL, &percent);
+    const bool low = state == SDL_POWERSTATE_ON_BATTERY && percent >= 0 && percent <= NC__LOW_BATTERY_PERCENT;
+    const nc__pacing_profile_t* profile = nc__pacing_profiles
+        + (low ? NC__BATTERY_SAVER_PROFILE : NC__DEFAULT_PACING_PROFILE);
+    return profile == nc__pacing_profile || nc__apply_pacing_profile(profile);
+}
+
+// Whether the player is moving or looking around. Starting to move from rest only shows up in the camera a tick later,
+// so this is what keeps frames coming until then.
+static bool nc__player_input_held(void) {
+    // The keys nc__tick reads.
+    static const SDL_Scancode movement_keys[] = {
+        SDL_SCANCODE_W, SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_R, SDL_SCANCODE_F,
+    };
+    for (size_t i = 0; i < NC__COUNTOF(movement_keys); i++) {
+        if (nc__keyboard_state[movement_keys[i]]) {
+            return true;
+        }
+    }
+    return nc__move_touch.finger_id || nc__look_touch.finger_id;
+}
+
+// Whether the next frame could look any different from the last one drawn. Sitting still to plan a build shouldn't keep
+// the GPU busy drawing the same frame over and over. Frames are still drawn every NC__IDLE_REDRAW_INTERVAL, in case
+// something changed that isn't tracked.
+static bool nc__frame_needed(const Uint64 ticks, const bool world_ready) {
+    const vkm_usvec2 scene_size = nc__scene_size();
+    return nc__redraw
+        || !world_ready
+        || nc__sections_dirty
+        || nc__sections_stale
+        || nc__light_dirty
+        || SDL_memcmp(&scene_size, &nc__drawn_scene_size, sizeof(scene_size)) != 0
+        || nc__player_input_held()
+        || SDL_memcmp(&nc__player_position, &nc__previous_player_position, sizeof(nc__player_position)) != 0
+        || SDL_memcmp(&nc__camera, &nc__drawn_camera, sizeof(nc__camera)) != 0
+        || ticks - nc__drawn_ticks >= NC__IDLE_REDRAW_INTERVAL;
+}
+
+static bool nc__texture_is_input(const nc__render_pass_t* pass, const SDL_GPUTexture* texture) {
+    for (unsigned i = 0; i < NC__COUNTOF(pass->inputs); i++) {
+        if (texture && pass->inputs[i] == texture) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether the passes from first on read what's in texture at that point, by sampling it or drawing over it, before
+// anything overwrites it. Only the presented texture has to outlast the frame.
+static bool nc__texture_needed(
+        const nc__render_pass_t* passes,
+        const size_t first,
+        const size_t count,
+        const SDL_GPUTexture* texture,
+        const SDL_GPUTexture* presented) {
+    for (size_t i = first; i < count; i++) {
+        if (nc__texture_is_input(passes + i, texture)) {
+            return true;
+        }
+        if (passes[i].color_target == texture) {
+            return passes[i].color_use == NC__ATTACHMENT_KEEP;
+        }
+        if (passes[i].depth_target == texture) {
+            return passes[i].depth_use == NC__ATTACHMENT_KEEP;
+        }
+    }
+    return texture == presented;
+}
+
+// Whether the passes before last use texture. Textures are cycled on their first use in the frame, unless loaded, rather
+// than waiting for the GPU to be done with the previous frame's contents.
+static bool nc__texture_used_before(const nc__render_pass_t* passes, const size_t last, const SDL_GPUTexture* texture) {
+    for (size_t i = 0; i < last; i++) {
+        if (passes[i].color_target == texture || passes[i].depth_target == texture
+            || nc__texture_is_input(passes + i, texture)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static SDL_GPULoadOp nc__load_op(const nc__target_use_t use) {
+    switch (use) {
+        case NC__ATTACHMENT_KEEP:
+            return SDL_GPU_LOADOP_LOAD;
+        case NC__ATTACHMENT_CLEAR:
+            return SDL_GPU_LOADOP_CLEAR;
+        default:
+            return SDL_GPU_LOADOP_DONT_CARE;
+    }
+}
+
+// Records the passes in order. A pass into the same targets as the one before it shares its render pass, unless it
+// clears them or samples one of them. Targets are only loaded and stored when a later pass reads them, so tile-based
+// GPUs keep them in tile memory instead of writing whole targets out and reading them back in.
+static void nc__run_render_passes(
+        SDL_GPUCommandBuffer* command_buffer,
+        const nc__render_pass_t* passes,
+        const size_t count,
+        const SDL_GPUTexture* presented) {
+    size_t first = 0;
+    while (first < count) {
+        const nc__render_pass_t* pass = passes + first;
+        size_t end = first + 1;
+        while (end < count
+            && passes[end].color_target == pass->color_target
+            && passes[end].depth_target == pass->depth_target
+            && passes[end].color_use != NC__ATTACHMENT_CLEAR
+            && passes[end].depth_use != NC__ATTACHMENT_CLEAR
+            && !nc__texture_is_input(passes + end, pass->color_target)
+            && !nc__texture_is_input(passes + end, pass->depth_target)) {
+            end++;
+        }
+
+        const bool store_color = nc__texture_needed(passes, end, count, pass->color_target, presented);
+        const bool store_depth = nc__texture_needed(passes, end, count, pass->depth_target, presented);
+        SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(
+                command_buffer,
+                &(SDL_GPUColorTargetInfo){
+                    .texture = pass->color_target,
+                    .clear_color = pass->clear_color,
+                    .load_op = nc__load_op(pass->color_use),
+                    .store_op = store_color ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE,
+                    .cycle = pass->color_use != NC__ATTACHMENT_KEEP
+                        && pass->color_target != presented
+                        && !nc__texture_used_before(passes, first, pass->color_target),
+                },
+                1,
+                pass->depth_target ? &(SDL_GPUDepthStencilTargetInfo){
+                    .texture = pass->depth_target,
+                    .clear_depth = 1.0f,
+                    .load_op = nc__load_op(pass->depth_use),
+                    .store_op = store_depth ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE,
+                    .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+                    .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+                    .cycle = pass->depth_use != NC__ATTACHMENT_KEEP
+                        && !nc__texture_used_before(passes, first, pass->depth_target),
+                } : NULL);
+        for (size_t i = first; i < end; i++) {
+            passes[i].record(command_buffer, render_pass, passes[i].data);
+        }
+        SDL_EndGPURenderPass(render_pass);
+        first = end;
+    }
+}
+
+static void nc__record_scene_pass(
+        SDL_GPUCommandBuffer* command_buffer,
+        SDL_GPURenderPass* render_pass,
+        const void* data) {
+    const nc__scene_pass_t* scene = data;
+    SDL_SetGPUViewport(render_pass, &(SDL_GPUViewport){
+        .w = (float)scene->width,
+        .h = (float)scene->height,
+        .max_depth = 1.0f,
+    });
+    SDL_BindGPUGraphicsPipeline(render_pass, nc__pipeline);
+    SDL_BindGPUVertexSamplers(
+            render_pass,
+            0,
+            &(SDL_GPUTextureSamplerBinding){
+                .texture = nc__light_texture,
+                .sampler = nc__texture_sampler,
+            },
+            1);
+    SDL_BindGPUVertexStorageBuffers(
+            render_pass,
+            0,
+            (SDL_GPUBuffer*[]){ nc__face_buffer, nc__face_layer_buffer },
+            2);
+    SDL_BindGPUFragmentSamplers(
+            render_pass,
+            0,
+            &(SDL_GPUTextureSamplerBinding){
+                .texture = nc__terrain_textures,
+                .sampler = nc__texture_sampler,
+            },
+            1);
+    const nc__vertex_uniforms_t uniforms = {
+        .view_projection = scene->view_projection,
+        .sky_brightness = nc__sky_brightness,
+    };
+    SDL_PushGPUVertexUniformData(command_buffer, 0, &uniforms, sizeof(uniforms));
+    // Nothing has been uploaded while the world isn't ready, every count is 0.
+    const uint32_t section_draw_count = nc__sort_visible_sections();
+    for (uint32_t i = 0; i < section_draw_count; i++) {
+        const nc__section_t* section = nc__sections + nc__section_draws[i].section_index;
+        const vkm_ivec3 origin = nc__section_origin(nc__section_draws[i].section_index);
+        for (unsigned face = 0; face < NC__COUNTOF(section->faces); face++) {
+            if (!section->face_counts[face] || !nc__section_faces_camera(origin, face)) {
+                continue;
+            }
+
+            const nc__draw_uniforms_t draw_uniforms = {
+                .section_origin = { origin.x, origin.y, origin.z },
+                .face = face,
+            };
+            SDL_PushGPUVertexUniformData(command_buffer, 1, &draw_uniforms, sizeof(draw_uniforms));
+            // Six vertices per face, cube.vert finds its face from the vertex index.
+            SDL_DrawGPUPrimitives(render_pass, section->face_counts[face] * 6, 1, section->first_faces[face] * 6, 0);
+        }
+    }
+}
+
+// Scales the scene up from the top left of nc__scene_texture to the whole target.
+static void nc__record_upscale_pass(
+        SDL_GPUCommandBuffer* command_buffer,
+        SDL_GPURenderPass* render_pass,
+        const void* data) {
+    SDL_BindGPUGraphicsPipeline(render_pass, nc__upscale_pipeline);
+    SDL_BindGPUFragmentSamplers(
+            render_pass,
+            0,
+            &(SDL_GPUTextureSamplerBinding){
+                .texture = nc__scene_texture,
+                .sampler = nc__upscale_sampler,
+            },
+            1);
+    SDL_PushGPUVertexUniformData(command_buffer, 0, data, sizeof(nc__upscale_uniforms_t));
+    SDL_DrawGPUPrimitives(render_pass, 3, 1, 0, 0);
+}
+
+static void nc__record_reticle_pass(
+        SDL_GPUCommandBuffer* command_buffer,
+        SDL_GPURenderPass* render_pass,
+        const void* data) {
+    (void)command_buffer;
+    (void)data;
+    SDL_BindGPUGraphicsPipeline(render_pass, nc__reticle_pipeline);
+    SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
+}
+
+// Whether a solid block is in the cells from first to last on every axis, inclusive. Only visits those cells, the ones
+// outside the chunk are empty.
+static bool nc__cells_hit_solid(vkm_ivec3 first, vkm_ivec3 last) {
+    for (unsigned axis = 0; axis < 3; axis++) {
+        first.raw[axis] = SDL_max(first.raw[axis], 0);
+        last.raw[axis] = SDL_min(last.raw[axis], NC__CHUNK_LENGTH - 1);
+    }
+    for (int z = first.z; z <= last.z; z++) {
+        for (int y = first.y; y <= last.y; y++) {
+            for (int x = first.x; x <= last.x; x++) {
+                const uint32_t handle = nc__block_handles[NC__CHUNK_INDEX(x, y, z)];
+                if (nc__block_is(nc__blocks.solid, nc__block_type_of(handle))) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// The cells a box overlaps, touching one doesn't count.
+static void nc__box_cells(const nc__box_t* box, vkm_ivec3* first, vkm_ivec3* last) {
+    for (unsigned axis = 0; axis < 3; axis++) {
+        first->raw[axis] = (int)SDL_floorf(box->min.raw[axis]);
+        last->raw[axis] = (int)SDL_ceilf(box->max.raw[axis]) - 1;
+    }
+}
+
+// Moves a box, one axis at a time, stopping it short of the first solid block in the way on each. A box running into a
+// wall at an angle slides along it. Only the cells the box sweeps through are visited, so the cost doesn't depend on the
+// size of the world, and every entity can be moved each tick. Blocks the box already overlaps don't stop it, so it can
+// get out of them. Returns the axes it was stopped on, as a bit per axis from x.
+static unsigned nc__move_box(nc__box_t* box, const vkm_vec3 movement) {
+    unsigned stopped = 0;
+    for (unsigned axis = 0; axis < 3; axis++) {
+        float distance = movement.raw[axis];
+        if (distance == 0.0f) {
+            continue;
+        }
+
+        // Checks the layers of cells the leading side of the box enters, nearest first.
+        vkm_ivec3 first, last;
+        nc__box_cells(box, &first, &last);
+        if (distance > 0.0f) {
+            const int end = (int)SDL_ceilf(box->max.raw[axis] + distance) - 1;
+            for (int layer = (int)SDL_ceilf(box->max.raw[axis]); layer <= end; layer++) {
+                first.raw[axis] = last.raw[axis] = layer;
+                if (nc__cells_hit_solid(first, last)) {
+                    distance = SDL_max((float)layer - NC__COLLISION_MARGIN - box->max.raw[axis], 0.0f);
+                    stopped |= 1u << axis;
+                    break;
+                }
+            }
+        } else {
+            const int end = (int)SDL_floorf(box->min.raw[axis] + distance);
+            for (int layer = (int)SDL_floorf(box->min.raw[axis]) - 1; layer >= end; layer--) {
+                first.raw[axis] = last.raw[axis] = layer;
+                if (nc__cells_hit_solid(first, last)) {
+                    distance = SDL_min((float)(layer + 1) + NC__COLLISION_MARGIN - box->min.raw[axis], 0.0f);
+                    stopped |= 1u << axis;
+                    break;
+                }
+            }
+        }
+        box->min.raw[axis] += distance;
+        box->max.raw[axis] += distance;
+    }
+    return stopped;
+}
+
+static nc__box_t nc__player_box(const vkm_vec3 position) {
+    return (nc__box_t){
+        .min = { {
+            position.x - NC__PLAYER_WIDTH / 2.0f,
+            position.y - NC__PLAYER_EYE_HEIGHT,
+            position.z - NC__PLAYER_WIDTH / 2.0f,
+        } },
+        .max = { {
+            position.x + NC__PLAYER_WIDTH / 2.0f,
+            position.y - NC__PLAYER_EYE_HEIGHT + NC__PLAYER_HEIGHT,
+            position.z + NC__PLAYER_WIDTH / 2.0f,
+        } },
+    };
+}
+
+// The directions the camera looks towards, and to its right and top.
+static void nc__camera_axes(vkm_vec3* forward, vkm_vec3* right, vkm_vec3* up) {
+    const float pitch_sine = vkm_sin(nc__camera.pitch);
+    const float pitch_cosine = vkm_cos(nc__camera.pitch);
+    const float yaw_sine = vkm_sin(nc__camera.yaw);
+    const float yaw_cosine = vkm_cos(nc__camera.yaw);
+    *forward = (vkm_vec3){ {
+        pitch_cosine * yaw_sine,
+        pitch_sine,
+        pitch_cosine * yaw_cosine,
+    } };
+    vkm_vec3_cross(&CVKM_VEC3_UP, forward, right);
+    vkm_vec3_normalize(right, right);
+    vkm_vec3_cross(forward, right, up);
+}
+
+// Advances the game world by NC__TICK_DURATION. Only reads the input and the camera's orientation, everything else it
+// touches belongs to the simulation. Blocks don't update on their own yet and there are no entities, so that's moving
+// the player, through blocks until the world is built.
+static void nc__tick(const bool world_ready) {
+    vkm_vec3 forward, right, up;
+    nc__camera_axes(&forward, &right, &up);
+
+    vkm_vec3 input = { {
+        (float)nc__keyboard_state[SDL_SCANCODE_D] - (float)nc__keyboard_state[SDL_SCANCODE_A],
+        (float)nc__keyboard_state[SDL_SCANCODE_R] - (float)nc__keyboard_state[SDL_SCANCODE_F],
+        (float)nc__keyboard_state[SDL_SCANCODE_W] - (float)nc__keyboard_state[SDL_SCANCODE_S],
+    } };
+
+    if (nc__move_touch.finger_id) {
+        vkm_vec2 delta;
+        vkm_sub(&nc__move_touch.current_pos, &nc__move_touch.initial_pos, &delta);
+        // emulate touchscreen analog input that doesn't take the entire screen to make values go anywhere from 0 to 1.
+        vkm_mul(&delta, 10.0f, &delta);
+        input.x += delta.x;
+        input.z += -delta.y;
+    }
+
+    const float length = vkm_length(&input);
+    if (length > 1.0f) {
+        vkm_div(&input, length, &input);
+    }
+
+    vkm_vec3 velocity;
+    vkm_mul(&right, input.x, &velocity);
+    vkm_muladd(&up, input.y, &velocity);
+    vkm_muladd(&forward, input.z, &velocity);
+
+    vkm_mul(&velocity, NC__MOVEMENT_SPEED, &velocity);
+
+    vkm_vec3 movement;
+    vkm_mul(&velocity, (float)NC__TICK_DURATION, &movement);
+    nc__previous_player_position = nc__player_position;
+    if (world_ready) {
+        nc__box_t box = nc__player_box(nc__player_position);
+        nc__move_box(&box, movement);
+        nc__player_position = (vkm_vec3){ {
+            box.min.x + NC__PLAYER_WIDTH / 2.0f,
+            box.min.y + NC__PLAYER_EYE_HEIGHT,
+            box.min.z + NC__PLAYER_WIDTH / 2.0f,
+        } };
+    } else {
+        vkm_add(&nc__player_position, &movement, &nc__player_position);
+    }
+}
+
+// Runs the ticks due after delta_time more seconds, then places the camera between the last two ticks' positions, as
+// far as the time left over is into the next tick. Drawing is one tick behind the simulation in exchange for smooth
+// movement at any frame rate.
+static void nc__simulate(const double delta_time, const bool world_ready) {
+    nc__tick_time += delta_time;
+    for (unsigned i = 0; i < NC__MAX_TICKS_PER_FRAME && nc__tick_time >= NC__TICK_DURATION; i++) {
+        nc__tick(world_ready);
+        nc__tick_time -= NC__TICK_DURATION;
+    }
+    if (nc__tick_time >= NC__TICK_DURATION) {
+        // The ticks left are dropped, see NC__MAX_TICKS_PER_FRAME.
+        nc__tick_time = 0.0;
+    }
+
+    vkm_vec3 movement;
+    vkm_sub(&nc__player_position, &nc__previous_player_position, &movement);
+    nc__camera.position = nc__previous_player_position;
+    vkm_muladd(&movement, (float)(nc__tick_time / NC__TICK_DURATION), &nc__camera.position);
+}
+
+// Startup work that runs on its own thread. The SDL error of a failed job is kept for the thread that finishes it.
+typedef struct nc__startup_job_t {
+    const char* name;
+    bool (*run)(void);
+    SDL_Thread* thread;
+    SDL_AtomicInt done;
+    bool result;
+    char error[256];
+} nc__startup_job_t;
+
+static Uint64 nc__startup_ticks;
+
+// Logs when a phase of the startup ran, relative to the start of SDL_AppInit, so the log reads as a timeline.
+static void nc__log_startup_phase(const char* phase, const Uint64 start_ticks) {
+    const Uint64 end_ticks = SDL_GetTicksNS();
+    SDL_Log(
+        "Startup: %-24s %8.2f ms -> %8.2f ms",
+        phase,
+        (double)(start_ticks - nc__startup_ticks) / 1000000.0,
+        (double)(end_ticks - nc__startup_ticks) / 1000000.0);
+}
+
+static int nc__run_startup_job(void* data) {
+    nc__startup_job_t* job = data;
+    const Uint64 start_ticks = SDL_GetTicksNS();
+    job->result = job->run();
+    if (!job->result) {
+        SDL_strlcpy(job->error, SDL_GetError(), sizeof(job->error));
+    }
+    nc__log_startup_phase(job->name, start_ticks);
+    SDL_SetAtomicInt(&job->done, 1);
+    return 0;
+}
+
+// Runs the job right away if no thread can be created for it.
+static void nc__start_job(nc__startup_job_t* job) {
+    job->thread = SDL_CreateThread(nc__run_startup_job, job->name, job);
+    if (!job->thread) {
+        nc__run_startup_job(job);
+    }
+}
+
+static bool nc__finish_job(nc__startup_job_t* job) {
+    SDL_WaitThread(job->thread, NULL);
+    job->thread = NULL;
+    return job->result || SDL_SetError("%s: %s", job->name, job->error);
+}
+
+// Everything about the world that doesn't need the GPU, run on a worker thread during startup.
+static bool nc__create_world(void) {
+    const nc__block_type stone = nc__find_block_type("stone");
+    const nc__block_type dirt = nc__find_block_type("dirt");
+    const nc__block_type grass = nc__find_block_type("grass");
+    if (!stone || !dirt || !grass) {
+        return SDL_SetError("The block registry lacks stone, dirt or grass.");
+    }
+
+    nc__block_handles = SDL_calloc(NC__CHUNK_COUNT, sizeof(*nc__block_handles));
+    if (!nc__block_handles) {
+        return false;
+    }
+    nc__light = SDL_malloc(NC__CHUNK_COUNT);
+    if (!nc__light) {
+        return false;
+    }
+
+    for (int z = 126; z < 129; z++) {
+        for (int y = 126; y < 129; y++) {
+            for (int x = 126; x < 129; x++) {
+                const nc__block_type type = y == 126 ? stone : y == 127 ? dirt : grass;
+                nc__block_handles[NC__CHUNK_INDEX(x, y, z)] = nc__block_dense_pool_t_append(&nc__chunk, (nc__block_t){
+                    .position = { { (uint8_t)x, (uint8_t)y, (uint8_t)z } },
+                    .type = type,
+                });
+            }
+        }
+    }
+    for (uint32_t i = 0; i < nc__chunk.count; i++) {
+        nc__compute_ambient_occlusion(nc__chunk.array + i);
+        nc__mark_sections_dirty(nc__chunk.array[i].position);
+    }
+    nc__compute_light();
+    nc__mesh_dirty_sections();
+    return true;
+}
+
+// Picks the texture format and uploads the terrain textures along with the texture layer of each block face, run on a
+// worker thread during startup. The command buffer is acquired and submitted on that thread, as SDL requires.
+static bool nc__create_terrain_textures(void) {
+    SDL_GPUTransferBuffer* transfer_buffer = NULL;
+    SDL_GPUCommandBuffer* command_buffer = NULL;
+
+    const nc__texture_encoding_t* texture_encoding = nc__choose_texture_encoding();
+    if (!texture_encoding) {
+        goto error;
+    }
+    SDL_Log("Terrain texture format: %s", texture_encoding->name);
+
+    nc__terrain_textures = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
+        .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+        .format = texture_encoding->format,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = NC__TERRAIN_TEXTURE_LENGTH,
+        .height = NC__TERRAIN_TEXTURE_LENGTH,
+        .layer_count_or_depth = nc__blocks.texture_count,
+        .num_levels = NC__TERRAIN_TEXTURE_LEVELS,
+    });
+    if (!nc__terrain_textures) {
+        goto error;
+    }
+
+    nc__texture_sampler = SDL_CreateGPUSampler(nc__gpu_device, &(SDL_GPUSamplerCreateInfo){
+        .min_filter = SDL_GPU_FILTER_NEAREST,
+        .mag_filter = SDL_GPU_FILTER_NEAREST,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
         .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_MIRRORED_REPEAT,
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_MIRRORED_REPEAT,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_MIRRORED_REPEAT,
+        // 0 would clamp sampling to the first level.
+        .max_lod = NC__TERRAIN_TEXTURE_LEVELS - 1,
+    });
+    if (!nc__texture_sampler) {
+        goto error;
+    }
+
+    const Uint32 face_layers_size =
+        nc__blocks.type_count * NC__COUNTOF(nc__directions) * sizeof(*nc__blocks.face_layers);
+    nc__face_layer_buffer = SDL_CreateGPUBuffer(nc__gpu_device, &(SDL_GPUBufferCreateInfo){
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        .size = face_layers_size,
     });
+    if (!nc__face_layer_buffer) {
+        goto error;
+    }
 
+    // The face layers go first. Texture uploads have to start at a multiple of their block size, 16 bytes at most.
+    const Uint32 textures_offset = (face_layers_size + 15) & ~15u;
     transfer_buffer = SDL_CreateGPUTransferBuffer(nc__gpu_device, &(SDL_GPUTransferBufferCreateInfo){
         .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = NC__COUNTOF(nc__terrain_texture_paths) * NC__TERRAIN_TEXTURE_SIZE,
+        .size = textures_offset + nc__blocks.texture_count * nc__terrain_upload_size(texture_encoding),
     });
-    NC__CHECK_SDL_RESULT(transfer_buffer);
+    if (!transfer_buffer) {
+        goto error;
+    }
 
-    char* mapped = SDL_MapGPUTransferBuffer(nc__gpu_device, transfer_buffer, false);
-    NC__CHECK_SDL_RESULT(mapped);
-    for (unsigned i = 0; i < NC__COUNTOF(nc__terrain_texture_paths); i++) {
-        const bool result = nc__load_texture(nc__terrain_texture_paths[i], mapped, i);
-        NC__CHECK_SDL_RESULT(result);
+    uint8_t* mapped = SDL_MapGPUTransferBuffer(nc__gpu_device, transfer_buffer, false);
+    if (!mapped) {
+        goto error;
     }
+    memcpy(mapped, nc__blocks.face_layers, face_layers_size);
+    bool sdl_result = nc__load_terrain_textures(texture_encoding, mapped + textures_offset);
     SDL_UnmapGPUTransferBuffer(nc__gpu_device, transfer_buffer);
+    if (!sdl_result) {
+        goto error;
+    }
 
     command_buffer = SDL_AcquireGPUCommandBuffer(nc__gpu_device);
-    NC__CHECK_SDL_RESULT(command_buffer);
+    if (!command_buffer) {
+        goto error;
+    }
 
     SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(command_buffer);
-    for (unsigned i = 0; i < NC__COUNTOF(nc__terrain_texture_paths); i++) {
-        SDL_UploadToGPUTexture(
-                copy_pass,
-                &(SDL_GPUTextureTransferInfo){
-                    .transfer_buffer = transfer_buffer,
-                    .offset = i * NC__TERRAIN_TEXTURE_SIZE,
-                },
-                &(SDL_GPUTextureRegion){
-                    .texture = nc__terrain_textures,
-                    .layer = i,
-                    .w = NC__TERRAIN_TEXTURE_LENGTH,
-                    .h = NC__TERRAIN_TEXTURE_LENGTH,
-                    .d = 1,
-                },
-                false);
+    SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = transfer_buffer,
+                .offset = 0,
+            },
+            &(SDL_GPUBufferRegion){
+                .buffer = nc__face_layer_buffer,
+                .offset = 0,
+                .size = face_layers_size,
+            },
+            false);
+    Uint32 offset = textures_offset;
+    for (unsigned i = 0; i < nc__blocks.texture_count; i++) {
+        for (unsigned level = 0; level < NC__TERRAIN_TEXTURE_LEVELS; level++) {
+            SDL_UploadToGPUTexture(
+                    copy_pass,
+                    &(SDL_GPUTextureTransferInfo){
+                        .transfer_buffer = transfer_buffer,
+                        .offset = offset,
+                    },
+                    &(SDL_GPUTextureRegion){
+                        .texture = nc__terrain_textures,
+                        .mip_level = level,
+                        .layer = i,
+                        .w = NC__TERRAIN_LEVEL_LENGTH(level),
+                        .h = NC__TERRAIN_LEVEL_LENGTH(level),
+                        .d = 1,
+                    },
+                    false);
+            offset += nc__terrain_level_size(texture_encoding->decode_bc1 ? 0 : texture_encoding->block_size, level);
+        }
     }
     SDL_EndGPUCopyPass(copy_pass);
 
     sdl_result = SDL_SubmitGPUCommandBuffer(command_buffer);
     command_buffer = NULL;
-    NC__CHECK_SDL_RESULT(sdl_result);
+    if (!sdl_result) {
+        goto error;
+    }
 
     SDL_ReleaseGPUTransferBuffer(nc__gpu_device, transfer_buffer);
     transfer_buffer = NULL;
 
-    SDL_Log("Loaded %d terrain textures.", (int)NC__COUNTOF(nc__terrain_texture_paths));
+    SDL_Log("Loaded %u terrain textures.", (unsigned)nc__blocks.texture_count);
+    return true;
+
+    error:
+    SDL_CancelGPUCommandBuffer(command_buffer);
+    SDL_ReleaseGPUTransferBuffer(nc__gpu_device, transfer_buffer);
+    return false;
+}
+
+// Pipelines are created on worker threads during startup, once nc__swapchain_format is known.
+static bool nc__create_pipeline(void) {
+    bool result = false;
+    SDL_GPUShader* vertex_shader = NULL;
+    SDL_GPUShader* fragment_shader = NULL;
 
     vertex_shader = nc__load_shader(
-            NC__ASSETS_BASE_PATH "shaders/cube-vert.spv",
+            "shaders/cube-vert.spv",
             SDL_GPU_SHADERSTAGE_VERTEX,
-            0,
             1,
-            0,
+            2,
+            2,
             0);
-    NC__CHECK_SDL_RESULT(vertex_shader);
+    if (!vertex_shader) {
+        goto cleanup;
+    }
     fragment_shader = nc__load_shader(
-            NC__ASSETS_BASE_PATH "shaders/cube-frag.spv",
+            "shaders/cube-frag.spv",
             SDL_GPU_SHADERSTAGE_FRAGMENT,
             1,
             0,
             0,
             0);
-    NC__CHECK_SDL_RESULT(fragment_shader);
+    if (!fragment_shader) {
+        goto cleanup;
+    }
+
+    nc__pipeline = SDL_CreateGPUGraphicsPipeline(nc__gpu_device, &(SDL_GPUGraphicsPipelineCreateInfo){
+        .vertex_shader = vertex_shader,
+        .fragment_shader = fragment_shader,
+        // cube.vert reads the faces from nc__face_buffer itself.
+        .vertex_input_state = { 0 },
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .rasterizer_state = {
+            .fill_mode = SDL_GPU_FILLMODE_FILL,
+            .cull_mode = SDL_GPU_CULLMODE_BACK,
+            .front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
+            .enable_depth_clip = true,
+        },
+        .depth_stencil_state = {
+            .compare_op = SDL_GPU_COMPAREOP_LESS,
+            .enable_depth_test = true,
+            .enable_depth_write = true,
+            .enable_stencil_test = false,
+        },
+        .target_info = {
+            .color_target_descriptions = (SDL_GPUColorTargetDescription[]){
+                {
+                    .format = nc__swapchain_format,
+                },
+            },
+            .num_color_targets = 1,
+            .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+            .has_depth_stencil_target = true,
+        },
+    });
+    if (!nc__pipeline) {
+        goto cleanup;
+    }
+    result = true;
+
+    cleanup:
+    SDL_ReleaseGPUShader(nc__gpu_device, fragment_shader);
+    SDL_ReleaseGPUShader(nc__gpu_device, vertex_shader);
+    return result;
+}
+
+static bool nc__create_reticle_pipeline(void) {
+    bool result = false;
+    SDL_GPUShader* vertex_shader = NULL;
+    SDL_GPUShader* fragment_shader = NULL;
 
-    reticle_vertex_shader = nc__load_shader(
-            NC__ASSETS_BASE_PATH "shaders/reticle-vert.spv",
+    vertex_shader = nc__load_shader(
+            "shaders/reticle-vert.spv",
             SDL_GPU_SHADERSTAGE_VERTEX,
             0,
             0,
             0,
             0);
-    NC__CHECK_SDL_RESULT(reticle_vertex_shader);
-    reticle_fragment_shader = nc__load_shader(
-            NC__ASSETS_BASE_PATH "shaders/reticle-frag.spv",
+    if (!vertex_shader) {
+        goto cleanup;
+    }
+    fragment_shader = nc__load_shader(
+            "shaders/reticle-frag.spv",
             SDL_GPU_SHADERSTAGE_FRAGMENT,
             0,
             0,
             0,
             0);
-    NC__CHECK_SDL_RESULT(reticle_fragment_shader);
+    if (!fragment_shader) {
+        goto cleanup;
+    }
 
-    nc__pipeline = SDL_CreateGPUGraphicsPipeline(nc__gpu_device, &(SDL_GPUGraphicsPipelineCreateInfo){
+    nc__reticle_pipeline = SDL_CreateGPUGraphicsPipeline(nc__gpu_device, &(SDL_GPUGraphicsPipelineCreateInfo){
         .vertex_shader = vertex_shader,
-        .fragment_shader = fragment_shader,
-        .vertex_input_state = {
-            .vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){
-                {
-                    .slot = 0,
-                    .pitch = sizeof(nc__block_t),
-                    .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
-                },
-            },
-            .num_vertex_buffers = 1,
-            .vertex_attributes = (SDL_GPUVertexAttribute[]){
-                {
-                    .location = 0,
-                    .buffer_slot = 0,
-                    .format = SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4,
-                    .offset = 0,
-                },
-            },
-            .num_vertex_attributes = 1,
-        },
+        .fragment_shader = fragment_shader,
+        .vertex_input_state = { 0 },
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
         .rasterizer_state = {
             .fill_mode = SDL_GPU_FILLMODE_FILL,
@@ -461,35 +2376,67 @@ SDL_AppResult SDL_AppInit(void** app_state, const int argc, char** argv) {
         },
         .depth_stencil_state = {
             .compare_op = SDL_GPU_COMPAREOP_LESS,
-            .enable_depth_test = true,
-            .enable_depth_write = true,
+            .enable_depth_test = false,
+            .enable_depth_write = false,
             .enable_stencil_test = false,
         },
         .target_info = {
             .color_target_descriptions = (SDL_GPUColorTargetDescription[]){
                 {
-                    .format = SDL_GetGPUSwapchainTextureFormat(nc__gpu_device, nc__window),
+                    .format = nc__swapchain_format,
                 },
             },
             .num_color_targets = 1,
+            // Shares its render pass with the scene or the upscale, see nc__render_pass_t.
             .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
             .has_depth_stencil_target = true,
         },
     });
-    NC__CHECK_SDL_RESULT(nc__pipeline);
-    SDL_ReleaseGPUShader(nc__gpu_device, vertex_shader);
-    vertex_shader = NULL;
+    if (!nc__reticle_pipeline) {
+        goto cleanup;
+    }
+    result = true;
+
+    cleanup:
     SDL_ReleaseGPUShader(nc__gpu_device, fragment_shader);
-    fragment_shader = NULL;
+    SDL_ReleaseGPUShader(nc__gpu_device, vertex_shader);
+    return result;
+}
 
-    nc__reticle_pipeline = SDL_CreateGPUGraphicsPipeline(nc__gpu_device, &(SDL_GPUGraphicsPipelineCreateInfo){
-        .vertex_shader = reticle_vertex_shader,
-        .fragment_shader = reticle_fragment_shader,
+static bool nc__create_upscale_pipeline(void) {
+    bool result = false;
+    SDL_GPUShader* vertex_shader = NULL;
+    SDL_GPUShader* fragment_shader = NULL;
+
+    vertex_shader = nc__load_shader(
+            "shaders/upscale-vert.spv",
+            SDL_GPU_SHADERSTAGE_VERTEX,
+            0,
+            1,
+            0,
+            0);
+    if (!vertex_shader) {
+        goto cleanup;
+    }
+    fragment_shader = nc__load_shader(
+            "shaders/upscale-frag.spv",
+            SDL_GPU_SHADERSTAGE_FRAGMENT,
+            1,
+            0,
+            0,
+            0);
+    if (!fragment_shader) {
+        goto cleanup;
+    }
+
+    nc__upscale_pipeline = SDL_CreateGPUGraphicsPipeline(nc__gpu_device, &(SDL_GPUGraphicsPipelineCreateInfo){
+        .vertex_shader = vertex_shader,
+        .fragment_shader = fragment_shader,
         .vertex_input_state = { 0 },
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
         .rasterizer_state = {
             .fill_mode = SDL_GPU_FILLMODE_FILL,
-            .cull_mode = SDL_GPU_CULLMODE_BACK,
+            .cull_mode = SDL_GPU_CULLMODE_NONE,
             .front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
             .enable_depth_clip = true,
         },
@@ -502,18 +2449,182 @@ SDL_AppResult SDL_AppInit(void** app_state, const int argc, char** argv) {
         .target_info = {
             .color_target_descriptions = (SDL_GPUColorTargetDescription[]){
                 {
-                    .format = SDL_GetGPUSwapchainTextureFormat(nc__gpu_device, nc__window),
+                    .format = nc__swapchain_format,
                 },
             },
             .num_color_targets = 1,
-            .has_depth_stencil_target = false,
+            // Shares its render pass with the reticle, see nc__render_pass_t.
+            .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+            .has_depth_stencil_target = true,
         },
     });
-    NC__CHECK_SDL_RESULT(nc__reticle_pipeline);
-    SDL_ReleaseGPUShader(nc__gpu_device, reticle_vertex_shader);
-    reticle_vertex_shader = NULL;
-    SDL_ReleaseGPUShader(nc__gpu_device, reticle_fragment_shader);
-    reticle_fragment_shader = NULL;
+    if (!nc__upscale_pipeline) {
+        goto cleanup;
+    }
+
+    nc__upscale_sampler = SDL_CreateGPUSampler(nc__gpu_device, &(SDL_GPUSamplerCreateInfo){
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+    });
+    if (!nc__upscale_sampler) {
+        goto cleanup;
+    }
+    result = true;
+
+    cleanup:
+    SDL_ReleaseGPUShader(nc__gpu_device, fragment_shader);
+    SDL_ReleaseGPUShader(nc__gpu_device, vertex_shader);
+    return result;
+}
+
+static nc__startup_job_t
+    nc__world_job = { .name = "World", .run = nc__create_world },
+    nc__texture_job = { .name = "Terrain textures", .run = nc__create_terrain_textures },
+    nc__pipeline_job = { .name = "Block pipeline", .run = nc__create_pipeline },
+    nc__reticle_pipeline_job = { .name = "Reticle pipeline", .run = nc__create_reticle_pipeline },
+    nc__upscale_pipeline_job = { .name = "Upscale pipeline", .run = nc__create_upscale_pipeline };
+
+SDL_AppResult SDL_AppInit(void** app_state, const int argc, char** argv) {
+    (void)app_state;
+    (void)argc;
+    (void)argv;
+
+    nc__startup_ticks = SDL_GetTicksNS();
+    SDL_PropertiesID props = 0;
+
+    SDL_Log("Novacube " NC__VERSION "\n"
+            "Build: " __DATE__ " " __TIME__ " " NC__BUILD_TYPE "\n"
+            "Git: " NC__GIT_DESCRIBE "\n"
+            "Commit: " NC__GIT_HASH);
+
+    SDL_SetHint(SDL_HINT_TOUCH_MOUSE_EVENTS, "0");
+
+    bool sdl_result = SDL_InitSubSystem(SDL_INIT_VIDEO);
+    NC__CHECK_SDL_RESULT(sdl_result);
+
+    sdl_result = nc__open_pack();
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = nc__load_block_registry();
+    NC__CHECK_SDL_RESULT(sdl_result);
+    nc__log_startup_phase("Video and asset pack", nc__startup_ticks);
+
+    // Nothing else touches the world until nc__world_job is done, see SDL_AppIterate. The other jobs need the device or
+    // the window, which are created here in the meantime.
+    nc__start_job(&nc__world_job);
+
+    Uint64 phase_ticks = SDL_GetTicksNS();
+    props = SDL_CreateProperties();
+    NC__CHECK_SDL_RESULT(props);
+    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_SHADERS_SPIRV_BOOLEAN, true);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(
+            props,
+            SDL_PROP_GPU_DEVICE_CREATE_DEBUGMODE_BOOLEAN,
+#ifndef NDEBUG
+            true);
+#else
+            false);
+#endif
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(
+            props,
+            SDL_PROP_GPU_DEVICE_CREATE_PREFERLOWPOWER_BOOLEAN,
+            true);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_D3D12_ALLOW_FEWER_RESOURCE_SLOTS_BOOLEAN, true);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_CLIP_DISTANCE_BOOLEAN, false);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_DEPTH_CLAMPING_BOOLEAN, false);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_INDIRECT_DRAW_FIRST_INSTANCE_BOOLEAN, false);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_FEATURE_ANISOTROPY_BOOLEAN, false);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    SDL_GPUVulkanOptions options = {
+        .vulkan_api_version = VK_API_VERSION_1_0,
+    };
+    sdl_result = SDL_SetPointerProperty(props, SDL_PROP_GPU_DEVICE_CREATE_VULKAN_OPTIONS_POINTER, &options);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    nc__gpu_device = SDL_CreateGPUDeviceWithProperties(props);
+    NC__CHECK_SDL_RESULT(nc__gpu_device);
+    SDL_DestroyProperties(props);
+
+    props = SDL_GetGPUDeviceProperties(nc__gpu_device);
+    SDL_Log("%s", SDL_GetStringProperty(props, SDL_PROP_GPU_DEVICE_NAME_STRING, "Unknown GPU"));
+    nc__log_startup_phase("GPU device", phase_ticks);
+
+    nc__start_job(&nc__texture_job);
+
+    phase_ticks = SDL_GetTicksNS();
+
+    SDL_WindowFlags flags = SDL_WINDOW_RESIZABLE;
+#ifdef ANDROID
+    // Android always has a fullscreen
+    flags |= SDL_WINDOW_FULLSCREEN;
+#endif
+
+    nc__window = SDL_CreateWindow("Novacube " NC__VERSION, 640, 480, flags);
+    NC__CHECK_SDL_RESULT(nc__window);
+    // get the actual window dimensions
+    int width, height;
+    sdl_result = SDL_GetWindowSize(nc__window, &width, &height);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    nc__viewport_size.x = (uint16_t)width;
+    nc__viewport_size.y = (uint16_t)height;
+
+    sdl_result = SDL_ClaimWindowForGPUDevice(nc__gpu_device, nc__window);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = nc__apply_pacing_profile(nc__pacing_profiles + NC__DEFAULT_PACING_PROFILE);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    nc__log_startup_phase("Window", phase_ticks);
+
+    nc__swapchain_format = SDL_GetGPUSwapchainTextureFormat(nc__gpu_device, nc__window);
+    nc__start_job(&nc__pipeline_job);
+    nc__start_job(&nc__reticle_pipeline_job);
+    nc__start_job(&nc__upscale_pipeline_job);
+
+    phase_ticks = SDL_GetTicksNS();
+
+    sdl_result = nc__create_render_targets();
+    NC__CHECK_SDL_RESULT(sdl_result);
+
+    nc__light_texture = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
+        .type = SDL_GPU_TEXTURETYPE_3D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8_UINT,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = NC__CHUNK_LENGTH,
+        .height = NC__CHUNK_LENGTH,
+        .layer_count_or_depth = NC__CHUNK_LENGTH,
+        .num_levels = 1,
+    });
+    NC__CHECK_SDL_RESULT(nc__light_texture);
+
+    nc__face_buffer = SDL_CreateGPUBuffer(nc__gpu_device, &(SDL_GPUBufferCreateInfo){
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        .size = NC__FACE_CAPACITY * sizeof(uint32_t),
+    });
+    NC__CHECK_SDL_RESULT(nc__face_buffer);
+    nc__staging_buffer = SDL_CreateGPUTransferBuffer(nc__gpu_device, &(SDL_GPUTransferBufferCreateInfo){
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = NC__STAGING_SIZE,
+    });
+    NC__CHECK_SDL_RESULT(nc__staging_buffer);
+    nc__log_startup_phase("GPU resources", phase_ticks);
+
+    // The first frames only need these, the world shows up once its job is done.
+    sdl_result = nc__finish_job(&nc__texture_job);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = nc__finish_job(&nc__pipeline_job);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = nc__finish_job(&nc__reticle_pipeline_job);
+    NC__CHECK_SDL_RESULT(sdl_result);
+    sdl_result = nc__finish_job(&nc__upscale_pipeline_job);
+    NC__CHECK_SDL_RESULT(sdl_result);
 
     nc__keyboard_state = SDL_GetKeyboardState(NULL);
 
@@ -522,31 +2633,46 @@ SDL_AppResult SDL_AppInit(void** app_state, const int argc, char** argv) {
     return SDL_APP_CONTINUE;
 
     error:
+    // The jobs still running use what's released below.
+    nc__finish_job(&nc__upscale_pipeline_job);
+    nc__finish_job(&nc__reticle_pipeline_job);
+    nc__finish_job(&nc__pipeline_job);
+    nc__finish_job(&nc__texture_job);
+    nc__finish_job(&nc__world_job);
+    SDL_ReleaseGPUSampler(nc__gpu_device, nc__upscale_sampler);
+    nc__upscale_sampler = NULL;
+    SDL_ReleaseGPUGraphicsPipeline(nc__gpu_device, nc__upscale_pipeline);
+    nc__upscale_pipeline = NULL;
     SDL_ReleaseGPUGraphicsPipeline(nc__gpu_device, nc__reticle_pipeline);
     nc__reticle_pipeline = NULL;
-    SDL_ReleaseGPUShader(nc__gpu_device, reticle_fragment_shader);
-    reticle_fragment_shader = NULL;
-    SDL_ReleaseGPUShader(nc__gpu_device, reticle_vertex_shader);
-    reticle_vertex_shader = NULL;
     SDL_ReleaseGPUGraphicsPipeline(nc__gpu_device, nc__pipeline);
     nc__pipeline = NULL;
-    SDL_ReleaseGPUShader(nc__gpu_device, fragment_shader);
-    fragment_shader = NULL;
-    SDL_ReleaseGPUShader(nc__gpu_device, vertex_shader);
-    vertex_shader = NULL;
-    SDL_CancelGPUCommandBuffer(command_buffer);
-    command_buffer = NULL;
-    SDL_ReleaseGPUTransferBuffer(nc__gpu_device, transfer_buffer);
-    transfer_buffer = NULL;
     SDL_ReleaseGPUSampler(nc__gpu_device, nc__texture_sampler);
     nc__texture_sampler = NULL;
+    SDL_ReleaseGPUBuffer(nc__gpu_device, nc__face_layer_buffer);
+    nc__face_layer_buffer = NULL;
     SDL_ReleaseGPUTexture(nc__gpu_device, nc__terrain_textures);
     nc__terrain_textures = NULL;
-    SDL_ReleaseGPUTransferBuffer(nc__gpu_device, nc__transfer_buffer);
-    nc__transfer_buffer = NULL;
-    SDL_ReleaseGPUBuffer(nc__gpu_device, nc__vertex_buffer);
-    nc__vertex_buffer = NULL;
+    SDL_ReleaseGPUTransferBuffer(nc__gpu_device, nc__staging_buffer);
+    nc__staging_buffer = NULL;
+    SDL_ReleaseGPUBuffer(nc__gpu_device, nc__face_buffer);
+    nc__face_buffer = NULL;
+    SDL_ReleaseGPUTexture(nc__gpu_device, nc__light_texture);
+    nc__light_texture = NULL;
+    for (uint32_t i = 0; i < NC__SECTION_COUNT; i++) {
+        for (unsigned face = 0; face < NC__COUNTOF(nc__sections[i].faces); face++) {
+            nc__face_vector_t_fini(nc__sections[i].faces + face);
+        }
+    }
+    nc__light_queue_t_fini(&nc__light_removal_queue);
+    nc__light_queue_t_fini(&nc__light_queue);
+    SDL_free(nc__light);
+    nc__light = NULL;
+    SDL_free(nc__block_handles);
+    nc__block_handles = NULL;
     nc__block_dense_pool_t_fini(&nc__chunk);
+    SDL_ReleaseGPUTexture(nc__gpu_device, nc__scene_texture);
+    nc__scene_texture = NULL;
     SDL_ReleaseGPUTexture(nc__gpu_device, nc__depth_texture);
     nc__depth_texture = NULL;
     SDL_ReleaseWindowFromGPUDevice(nc__gpu_device, nc__window);
@@ -556,12 +2682,18 @@ SDL_AppResult SDL_AppInit(void** app_state, const int argc, char** argv) {
     nc__gpu_device = NULL;
     SDL_DestroyProperties(props);
     props = 0;
+    nc__close_pack();
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
     return SDL_APP_FAILURE;
 }
 
 // Pass the air block to remove the block instead of placing one.
 static void nc__modify_block(const nc__block_type new_block) {
+    // The world is still being built.
+    if (nc__world_job.thread) {
+        return;
+    }
+
     // https://tavianator.com/2011/ray_box.html
     // https://tavianator.com/cgit/dimension.git/tree/libdimension/bvh/bvh.c#n178
     // struct dmnsn_optimized_ray and dmnsn_ray_box_intersection()
@@ -622,18 +2754,29 @@ static void nc__modify_block(const nc__block_type new_block) {
     }
 
     if (new_block == NC__BLOCK_TYPE_AIR) {
-        nc__block_dense_pool_t_remove(&nc__chunk, closest_block_id);
+        nc__remove_block(closest_block_id);
     } else if (closest_distance > 1.0f) {
         const vkm_ubvec3 closest_block_position = nc__block_dense_pool_t_get(&nc__chunk, closest_block_id).position;
-        nc__block_t appended_block = {
-            .position = { {
-                closest_block_position.x + normal.x,
-                closest_block_position.y + normal.y,
-                closest_block_position.z + normal.z,
-            } },
+        const int x = closest_block_position.x + normal.x;
+        const int y = closest_block_position.y + normal.y;
+        const int z = closest_block_position.z + normal.z;
+        if (x < 0 || x >= NC__CHUNK_LENGTH || y < 0 || y >= NC__CHUNK_LENGTH || z < 0 || z >= NC__CHUNK_LENGTH
+            || nc__block_handles[NC__CHUNK_INDEX(x, y, z)]) {
+            return;
+        }
+        // The player would be stuck in it.
+        const nc__box_t player_box = nc__player_box(nc__player_position);
+        vkm_ivec3 first, last;
+        nc__box_cells(&player_box, &first, &last);
+        if (nc__block_is(nc__blocks.solid, new_block)
+            && x >= first.x && x <= last.x && y >= first.y && y <= last.y && z >= first.z && z <= last.z) {
+            return;
+        }
+
+        nc__place_block((nc__block_t){
+            .position = { { (uint8_t)x, (uint8_t)y, (uint8_t)z } },
             .type = new_block,
-        };
-        nc__block_dense_pool_t_append(&nc__chunk, appended_block);
+        });
     }
 }
 
@@ -643,10 +2786,29 @@ SDL_AppResult SDL_AppIterate(void* app_state) {
     SDL_GPUCommandBuffer* command_buffer = NULL;
     SDL_GPUCopyPass* copy_pass = NULL;
 
+    // The world is built on a worker thread during startup, frames are drawn without it until it's done.
+    if (nc__world_job.thread && SDL_GetAtomicInt(&nc__world_job.done)) {
+        const bool result = nc__finish_job(&nc__world_job);
+        NC__CHECK_SDL_RESULT(result);
+    }
+    const bool world_ready = !nc__world_job.thread;
+
+    nc__limit_frame_rate();
     const Uint64 ticks = SDL_GetTicksNS();
     static Uint64 last_ticks = 0;
     const double delta_time = last_ticks == 0 ? 1.0 / 60.0 : (double)(ticks - last_ticks) / 1000000000.0;
+    if (last_ticks) {
+#ifndef NDEBUG
+        nc__record_frame_time(ticks, delta_time);
+#endif
+        // Building the world and sleeping in the background say nothing about how long drawing takes.
+        if (world_ready && nc__foreground) {
+            nc__update_resolution_scale(delta_time);
+        }
+    }
     last_ticks = ticks;
+    const bool battery_checked = nc__check_battery(ticks);
+    NC__CHECK_SDL_RESULT(battery_checked);
 
     if (nc__look_touch.finger_id) {
         vkm_vec2 delta;
@@ -655,49 +2817,10 @@ SDL_AppResult SDL_AppIterate(void* app_state) {
         nc__camera.pitch += -delta.y * NC__TOUCHSCREEN_SENSITIVITY * (float)delta_time;
     }
 
-    const float pitch_sine = vkm_sin(nc__camera.pitch);
-    const float pitch_cosine = vkm_cos(nc__camera.pitch);
-    const float yaw_sine = vkm_sin(nc__camera.yaw);
-    const float yaw_cosine = vkm_cos(nc__camera.yaw);
-    const vkm_vec3 forward = { {
-        pitch_cosine * yaw_sine,
-        pitch_sine,
-        pitch_cosine * yaw_cosine,
-    } };
-    vkm_vec3 right, up;
-    vkm_vec3_cross(&CVKM_VEC3_UP, &forward, &right);
-    vkm_vec3_normalize(&right, &right);
-    vkm_vec3_cross(&forward, &right, &up);
-
-    vkm_vec3 input = { {
-        (float)nc__keyboard_state[SDL_SCANCODE_D] - (float)nc__keyboard_state[SDL_SCANCODE_A],
-        (float)nc__keyboard_state[SDL_SCANCODE_R] - (float)nc__keyboard_state[SDL_SCANCODE_F],
-        (float)nc__keyboard_state[SDL_SCANCODE_W] - (float)nc__keyboard_state[SDL_SCANCODE_S],
-    } };
-
-    if (nc__move_touch.finger_id) {
-        vkm_vec2 delta;
-        vkm_sub(&nc__move_touch.current_pos, &nc__move_touch.initial_pos, &delta);
-        // emulate touchscreen analog input that doesn't take the entire screen to make values go anywhere from 0 to 1.
-        vkm_mul(&delta, 10.0f, &delta);
-        input.x += delta.x;
-        input.z += -delta.y;
-    }
-
-    const float length = vkm_length(&input);
-    if (length > 1.0f) {
-        vkm_div(&input, length, &input);
-    }
-
-    vkm_vec3 velocity;
-    vkm_mul(&right, input.x, &velocity);
-    vkm_muladd(&up, input.y, &velocity);
-    vkm_muladd(&forward, input.z, &velocity);
-
-    vkm_mul(&velocity, NC__MOVEMENT_SPEED, &velocity);
-
-    vkm_muladd(&velocity, (float)delta_time, &nc__camera.position);
+    nc__simulate(delta_time, world_ready);
 
+    vkm_vec3 forward, right, up;
+    nc__camera_axes(&forward, &right, &up);
     vkm_mat4 view_matrix;
     vkm_vec3 target;
     vkm_vec3_add(&nc__camera.position, &forward, &target);
@@ -714,96 +2837,124 @@ SDL_AppResult SDL_AppIterate(void* app_state) {
     vkm_mat4 view_projection;
     vkm_mul(&projection, &view_matrix, &view_projection);
 
+    if (!nc__frame_needed(ticks, world_ready)) {
+        // Events are left in the queue for SDL_AppEvent, they only end the wait. The time spent waiting isn't a frame,
+        // so the next one starts timing over.
+        last_ticks = 0;
+        SDL_WaitEventTimeout(
+            NULL,
+            (Sint32)SDL_NS_TO_MS(nc__drawn_ticks + NC__IDLE_REDRAW_INTERVAL - ticks + SDL_NS_PER_MS - 1));
+        return SDL_APP_CONTINUE;
+    }
+
 #ifndef ANDROID
     if (!nc__foreground) {
         SDL_Delay(NC__BACKGROUND_DELAY);
     }
 #endif
 
+    bool sdl_result = nc__begin_staging();
+    NC__CHECK_SDL_RESULT(sdl_result);
+
     command_buffer = SDL_AcquireGPUCommandBuffer(nc__gpu_device);
     NC__CHECK_SDL_RESULT(command_buffer);
 
-    nc__block_t* mapped = SDL_MapGPUTransferBuffer(nc__gpu_device, nc__transfer_buffer, true);
-    NC__CHECK_SDL_RESULT(mapped);
-    memcpy(mapped, nc__chunk.array, nc__chunk.count * sizeof(*nc__chunk.array));
-    SDL_UnmapGPUTransferBuffer(nc__gpu_device, nc__transfer_buffer);
-
     copy_pass = SDL_BeginGPUCopyPass(command_buffer);
-    SDL_UploadToGPUBuffer(
-            copy_pass,
-            &(SDL_GPUTransferBufferLocation){
-                .transfer_buffer = nc__transfer_buffer,
-                .offset = 0,
-            },
-            &(SDL_GPUBufferRegion){
-                .buffer = nc__vertex_buffer,
-                .offset = 0,
-                .size = NC__CHUNK_SIZE,
-            },
-            true);
+    if (world_ready) {
+        nc__upload_faces(copy_pass);
+        nc__upload_light(copy_pass);
+    }
     SDL_EndGPUCopyPass(copy_pass);
     copy_pass = NULL;
 
     SDL_GPUTexture* swapchain_texture;
-    bool sdl_result = SDL_WaitAndAcquireGPUSwapchainTexture(command_buffer, nc__window, &swapchain_texture, NULL, NULL);
+    Uint32 swapchain_width, swapchain_height;
+    sdl_result = SDL_WaitAndAcquireGPUSwapchainTexture(
+        command_buffer,
+        nc__window,
+        &swapchain_texture,
+        &swapchain_width,
+        &swapchain_height);
     NC__CHECK_SDL_RESULT(sdl_result);
+    const vkm_usvec2 scene_size = nc__scene_size();
     if (swapchain_texture) {
-        SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(
-                command_buffer,
-                &(SDL_GPUColorTargetInfo){
-                    .texture = swapchain_texture,
-                    .clear_color = { 0.53f, 0.81f, 0.92f, 1.0f },
-                    .load_op = SDL_GPU_LOADOP_CLEAR,
-                    .store_op = SDL_GPU_STOREOP_STORE,
-                    .cycle = false,
-                },
-                1,
-                &(SDL_GPUDepthStencilTargetInfo){
-                    .texture = nc__depth_texture,
-                    .clear_depth = 1.0f,
-                    .load_op = SDL_GPU_LOADOP_CLEAR,
-                    .store_op = SDL_GPU_STOREOP_DONT_CARE,
-                    .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
-                    .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
-                    .cycle = true,
-                });
-        SDL_BindGPUGraphicsPipeline(render_pass, nc__pipeline);
-        SDL_BindGPUVertexBuffers(render_pass, 0, &(SDL_GPUBufferBinding){ .buffer = nc__vertex_buffer, .offset = 0 }, 1);
-        SDL_BindGPUFragmentSamplers(
-                render_pass,
-                0,
-                &(SDL_GPUTextureSamplerBinding){
-                    .texture = nc__terrain_textures,
-                    .sampler = nc__texture_sampler,
-                },
-                1);
-        SDL_PushGPUVertexUniformData(command_buffer, 0, &view_projection, sizeof(view_projection));
-        SDL_DrawGPUPrimitives(render_pass, 36, nc__chunk.count, 0, 0);
-        SDL_EndGPURenderPass(render_pass);
-
-        render_pass = SDL_BeginGPURenderPass(
-                command_buffer,
-                &(SDL_GPUColorTargetInfo){
-                    .texture = swapchain_texture,
-                    .load_op = SDL_GPU_LOADOP_LOAD,
-                    .store_op = SDL_GPU_STOREOP_STORE,
-                    .cycle = false,
-                },
-                1,
-                NULL);
-        SDL_BindGPUGraphicsPipeline(render_pass, nc__reticle_pipeline);
-        SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
-        SDL_EndGPURenderPass(render_pass);
+        const nc__scene_pass_t scene = {
+            .view_projection = view_projection,
+            .width = scene_size.x,
+            .height = scene_size.y,
+        };
+        const nc__upscale_uniforms_t upscale_uniforms = {
+            .scene_extent = {
+                (float)scene.width / (float)nc__viewport_size.x,
+                (float)scene.height / (float)nc__viewport_size.y,
+            },
+            .max_uv = {
+                ((float)scene.width - 0.5f) / (float)nc__viewport_size.x,
+                ((float)scene.height - 0.5f) / (float)nc__viewport_size.y,
+            },
+        };
+        // At full resolution, the scene is drawn straight into the swapchain texture and the reticle joins its pass.
+        const bool upscaled = scene.width != swapchain_width || scene.height != swapchain_height;
+        nc__render_pass_t passes[3];
+        size_t pass_count = 0;
+        passes[pass_count++] = (nc__render_pass_t){
+            .color_target = upscaled ? nc__scene_texture : swapchain_texture,
+            .color_use = NC__ATTACHMENT_CLEAR,
+            .clear_color = { 0.53f, 0.81f, 0.92f, 1.0f },
+            .depth_target = nc__depth_texture,
+            .depth_use = NC__ATTACHMENT_CLEAR,
+            .record = nc__record_scene_pass,
+            .data = &scene,
+        };
+        if (upscaled) {
+            passes[pass_count++] = (nc__render_pass_t){
+                .color_target = swapchain_texture,
+                .color_use = NC__ATTACHMENT_DISCARD,
+                .depth_target = nc__depth_texture,
+                .depth_use = NC__ATTACHMENT_DISCARD,
+                .inputs = { nc__scene_texture },
+                .record = nc__record_upscale_pass,
+                .data = &upscale_uniforms,
+            };
+        }
+        passes[pass_count++] = (nc__render_pass_t){
+            .color_target = swapchain_texture,
+            .color_use = NC__ATTACHMENT_KEEP,
+            .depth_target = nc__depth_texture,
+            .depth_use = NC__ATTACHMENT_DISCARD,
+            .record = nc__record_reticle_pass,
+        };
+        nc__run_render_passes(command_buffer, passes, pass_count, swapchain_texture);
     }
 
-    sdl_result = SDL_SubmitGPUCommandBuffer(command_buffer);
+    sdl_result = nc__submit_frame(command_buffer);
     NC__CHECK_SDL_RESULT(sdl_result);
+    if (swapchain_texture) {
+        nc__redraw = false;
+        nc__drawn_camera = nc__camera;
+        nc__drawn_scene_size = scene_size;
+        nc__drawn_ticks = ticks;
+    }
+
+    static bool first_frame = true, first_world_frame = true;
+    if (swapchain_texture && first_frame) {
+        first_frame = false;
+        nc__log_startup_phase("First frame", ticks);
+    }
+    if (swapchain_texture && world_ready && first_world_frame) {
+        first_world_frame = false;
+        nc__log_startup_phase("First frame with the world", ticks);
+    }
     return SDL_APP_CONTINUE;
 
     error:
     if (copy_pass) {
         SDL_EndGPUCopyPass(copy_pass);
     }
+    if (nc__staging_mapped) {
+        SDL_UnmapGPUTransferBuffer(nc__gpu_device, nc__staging_buffer);
+        nc__staging_mapped = NULL;
+    }
     if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Fatal error", SDL_GetError(), NULL);
     }
@@ -820,29 +2971,23 @@ SDL_AppResult SDL_AppEvent(void* app_state, SDL_Event* event) {
             nc__foreground = false;
             break;
         case SDL_EVENT_WINDOW_RESIZED:
-            // recreate depth texture with new dimensions
-            SDL_ReleaseGPUTexture(nc__gpu_device, nc__depth_texture);
+            // recreate the render targets with new dimensions
             nc__viewport_size = (vkm_usvec2){
                 .x = (uint16_t)event->window.data1,
                 .y = (uint16_t)event->window.data2,
             };
-            nc__depth_texture = SDL_CreateGPUTexture(nc__gpu_device, &(SDL_GPUTextureCreateInfo){
-                .type = SDL_GPU_TEXTURETYPE_2D,
-                .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-                .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
-                .width = nc__viewport_size.x,
-                .height = nc__viewport_size.y,
-                .layer_count_or_depth = 1,
-                .num_levels = 1,
-                .sample_count = SDL_GPU_SAMPLECOUNT_1,
-            });
-            NC__CHECK_SDL_RESULT(nc__depth_texture);
+            NC__CHECK_SDL_RESULT(nc__create_render_targets());
+            nc__redraw = true;
+            break;
+        case SDL_EVENT_WINDOW_EXPOSED:
+            nc__redraw = true;
             break;
         case SDL_EVENT_DID_ENTER_FOREGROUND:
         case SDL_EVENT_WINDOW_SHOWN:
         case SDL_EVENT_WINDOW_MAXIMIZED:
         case SDL_EVENT_WINDOW_RESTORED:
             nc__foreground = true;
+            nc__redraw = true;
             break;
         case SDL_EVENT_QUIT:
             SDL_Log("Received a quit event.");
@@ -863,7 +3008,13 @@ SDL_AppResult SDL_AppEvent(void* app_state, SDL_Event* event) {
             if (event->key.scancode == SDL_SCANCODE_ESCAPE) {
                 SDL_SetWindowRelativeMouseMode(nc__window, false);
             } else if (event->key.scancode >= SDL_SCANCODE_1 && event->key.scancode <= SDL_SCANCODE_0) {
-                selected_type = ((event->key.scancode - SDL_SCANCODE_1) % NC__BLOCK_TYPE_COUNT) + 1;
+                selected_type = (nc__block_type)((event->key.scancode - SDL_SCANCODE_1) % (nc__blocks.type_count - 1) + 1);
+            } else if (event->key.scancode >= SDL_SCANCODE_F1
+                && event->key.scancode < SDL_SCANCODE_F1 + NC__COUNTOF(nc__pacing_profiles)) {
+                // Picking a profile by hand keeps it, even when the battery runs low.
+                nc__pacing_profile_picked = true;
+                const bool result = nc__apply_pacing_profile(nc__pacing_profiles + (event->key.scancode - SDL_SCANCODE_F1));
+                NC__CHECK_SDL_RESULT(result);
             }
             break;
         case SDL_EVENT_FINGER_DOWN:
@@ -938,19 +3089,49 @@ void SDL_AppQuit(void* app_state, const SDL_AppResult result) {
 
     SDL_Log("See you later!");
 
+    nc__finish_job(&nc__world_job);
+
+    for (unsigned i = 0; i < NC__FRAMES_IN_FLIGHT; i++) {
+        if (nc__frames[i].fence) {
+            SDL_ReleaseGPUFence(nc__gpu_device, nc__frames[i].fence);
+            nc__frames[i].fence = NULL;
+        }
+    }
+
+    SDL_ReleaseGPUSampler(nc__gpu_device, nc__upscale_sampler);
+    nc__upscale_sampler = NULL;
+    SDL_ReleaseGPUGraphicsPipeline(nc__gpu_device, nc__upscale_pipeline);
+    nc__upscale_pipeline = NULL;
     SDL_ReleaseGPUGraphicsPipeline(nc__gpu_device, nc__reticle_pipeline);
     nc__reticle_pipeline = NULL;
     SDL_ReleaseGPUGraphicsPipeline(nc__gpu_device, nc__pipeline);
     nc__pipeline = NULL;
     SDL_ReleaseGPUSampler(nc__gpu_device, nc__texture_sampler);
     nc__texture_sampler = NULL;
+    SDL_ReleaseGPUBuffer(nc__gpu_device, nc__face_layer_buffer);
+    nc__face_layer_buffer = NULL;
     SDL_ReleaseGPUTexture(nc__gpu_device, nc__terrain_textures);
     nc__terrain_textures = NULL;
-    SDL_ReleaseGPUTransferBuffer(nc__gpu_device, nc__transfer_buffer);
-    nc__transfer_buffer = NULL;
-    SDL_ReleaseGPUBuffer(nc__gpu_device, nc__vertex_buffer);
-    nc__vertex_buffer = NULL;
+    SDL_ReleaseGPUTransferBuffer(nc__gpu_device, nc__staging_buffer);
+    nc__staging_buffer = NULL;
+    SDL_ReleaseGPUBuffer(nc__gpu_device, nc__face_buffer);
+    nc__face_buffer = NULL;
+    SDL_ReleaseGPUTexture(nc__gpu_device, nc__light_texture);
+    nc__light_texture = NULL;
+    for (uint32_t i = 0; i < NC__SECTION_COUNT; i++) {
+        for (unsigned face = 0; face < NC__COUNTOF(nc__sections[i].faces); face++) {
+            nc__face_vector_t_fini(nc__sections[i].faces + face);
+        }
+    }
+    nc__light_queue_t_fini(&nc__light_removal_queue);
+    nc__light_queue_t_fini(&nc__light_queue);
+    SDL_free(nc__light);
+    nc__light = NULL;
+    SDL_free(nc__block_handles);
+    nc__block_handles = NULL;
     nc__block_dense_pool_t_fini(&nc__chunk);
+    SDL_ReleaseGPUTexture(nc__gpu_device, nc__scene_texture);
+    nc__scene_texture = NULL;
     SDL_ReleaseGPUTexture(nc__gpu_device, nc__depth_texture);
     nc__depth_texture = NULL;
     SDL_ReleaseWindowFromGPUDevice(nc__gpu_device, nc__window);
@@ -958,6 +3139,7 @@ void SDL_AppQuit(void* app_state, const SDL_AppResult result) {
     nc__window = NULL;
     SDL_DestroyGPUDevice(nc__gpu_device);
     nc__gpu_device = NULL;
+    nc__close_pack();
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
     SDL_Quit();
 }
@@ -0,0 +1,217 @@
+// Checks the tds arena: marks and resets give memory back, blocks released by resets are reused instead of allocating
+// new ones, aligned allocations are aligned and don't overlap, and the containers work on top of tds_arena_allocator(),
+// including on memory dirtied by earlier allocations, which is what tds_callocate has to clear.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Counts the blocks the arena takes from the heap.
+static size_t block_allocations;
+
+static void* counting_realloc(void* pointer, const size_t size) {
+    block_allocations++;
+    return realloc(pointer, size);
+}
+
+#define TDS_REALLOC counting_realloc
+#include <tds/arena.h>
+
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE vector_t
+#include <tds/vector.h>
+
+#define TDS_KEY_T uint32_t
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE hashmap_t
+#include <tds/hashmap.h>
+
+#define TDS_KEY_T uint32_t
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE swiss_hashmap_t
+#include <tds/swiss-hashmap.h>
+
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE set_t
+#include <tds/set.h>
+
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE pool_t
+#include <tds/dense-pool.h>
+
+#define ALLOCATION_COUNT 4096
+#define CONTAINER_COUNT 20000
+
+static int failures;
+
+static void fail(const char* test, const char* message) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s\n", test, message);
+    }
+}
+
+static uint32_t random_state = 0x85ebca6b;
+
+static uint32_t random_u32(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// Allocates random sizes and alignments, some bigger than a block, fills each allocation with its own byte and then
+// checks that none was overwritten by another. Returns 0 if anything was misaligned or overlapping.
+static int fill_arena(tds_arena* arena, const uint32_t seed) {
+    static unsigned char* pointers[ALLOCATION_COUNT];
+    static size_t sizes[ALLOCATION_COUNT];
+    random_state = seed;
+    int ok = 1;
+    for (uint32_t i = 0; i < ALLOCATION_COUNT; i++) {
+        const size_t alignment = (size_t)1 << random_u32() % 13;
+        sizes[i] = random_u32() % 64 ? random_u32() % 512 : TDS_ARENA_BLOCK_SIZE + random_u32() % 4096;
+        pointers[i] = tds_arena_alloc_aligned(arena, sizes[i], alignment);
+        if ((uintptr_t)pointers[i] % alignment) {
+            ok = 0;
+        }
+        memset(pointers[i], (int)(i & 0xff), sizes[i]);
+    }
+    for (uint32_t i = 0; i < ALLOCATION_COUNT; i++) {
+        for (size_t j = 0; j < sizes[i]; j++) {
+            if (pointers[i][j] != (unsigned char)(i & 0xff)) {
+                ok = 0;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+static void test_alignment_and_reuse(void) {
+    tds_arena arena = { 0 };
+    if (!fill_arena(&arena, 1)) {
+        fail("alignment", "an allocation was misaligned or overlapped another");
+    }
+
+    // The same allocations again after a reset must fit in the blocks the first round left as spares.
+    tds_arena_reset(&arena);
+    const size_t warm_allocations = block_allocations;
+    if (!fill_arena(&arena, 1)) {
+        fail("alignment", "an allocation was misaligned or overlapped another after a reset");
+    }
+    if (block_allocations != warm_allocations) {
+        fail("reuse", "the spare blocks weren't reused");
+    }
+    tds_arena_fini(&arena);
+}
+
+static void test_marks(void) {
+    tds_arena arena = { 0 };
+    tds_arena_alloc(&arena, 100);
+    const tds_arena_mark mark = tds_arena_get_mark(&arena);
+    void* const after_mark = tds_arena_alloc(&arena, 100);
+
+    // Enough to go through several blocks, then back to the mark.
+    for (int i = 0; i < 8; i++) {
+        tds_arena_alloc(&arena, TDS_ARENA_BLOCK_SIZE / 2 + 1);
+    }
+    tds_arena_reset_to(&arena, mark);
+    if (arena.block != mark.block || arena.used != mark.used) {
+        fail("marks", "reset_to didn't go back to the mark");
+    }
+    if (tds_arena_alloc(&arena, 100) != after_mark) {
+        fail("marks", "the first allocation after a reset didn't reuse the memory after the mark");
+    }
+
+    // Growing the last allocation stays in place, other allocations move with their contents.
+    unsigned char* last = tds_arena_alloc(&arena, 16);
+    memset(last, 0x5a, 16);
+    if (tds_arena_realloc(&arena, last, 16, 64) != last) {
+        fail("marks", "the last allocation didn't grow in place");
+    }
+    unsigned char* other = tds_arena_alloc(&arena, 16);
+    memset(other, 0x3c, 16);
+    tds_arena_alloc(&arena, 16);
+    unsigned char* moved = tds_arena_realloc(&arena, other, 16, 32);
+    if (moved == other || moved[0] != 0x3c || moved[15] != 0x3c) {
+        fail("marks", "growing an older allocation didn't move its contents");
+    }
+
+    // Zero sizes free, so there is nothing to clear. Build with -fsanitize=undefined to also catch clearing the NULL.
+    tds_arena_reset(&arena);
+    if (tds_callocate(tds_arena_allocator(&arena), 0) != NULL) {
+        fail("marks", "a zero sized callocate returned memory");
+    }
+    tds_arena_fini(&arena);
+}
+
+// Builds every kind of container in the arena and checks their contents, twice, with the memory dirtied in between so
+// that anything relying on fresh heap memory being zero shows up.
+static void test_containers(void) {
+    tds_arena arena = { 0 };
+    for (int round = 0; round < 2; round++) {
+        memset(tds_arena_alloc(&arena, 4 * TDS_ARENA_BLOCK_SIZE), 0xa5, 4 * TDS_ARENA_BLOCK_SIZE);
+        tds_arena_reset(&arena);
+
+        const tds_allocator* allocator = tds_arena_allocator(&arena);
+        vector_t vector = { .allocator = allocator };
+        hashmap_t hashmap = { .allocator = allocator };
+        swiss_hashmap_t swiss_hashmap = { .allocator = allocator };
+        set_t set = { .allocator = allocator };
+        pool_t pool = { .allocator = allocator };
+        static uint32_t handles[CONTAINER_COUNT];
+        for (uint32_t i = 0; i < CONTAINER_COUNT; i++) {
+            vector_t_append(&vector, i);
+            hashmap_t_set(&hashmap, i * 3, i);
+            swiss_hashmap_t_set(&swiss_hashmap, i * 3, i);
+            set_t_add(&set, i * 3);
+            handles[i] = pool_t_append(&pool, i);
+        }
+        for (uint32_t i = 0; i < CONTAINER_COUNT; i += 2) {
+            hashmap_t_remove(&hashmap, i * 3);
+            swiss_hashmap_t_remove(&swiss_hashmap, i * 3);
+            set_t_remove(&set, i * 3);
+            pool_t_remove(&pool, handles[i]);
+        }
+
+        for (uint32_t i = 0; i < 3 * CONTAINER_COUNT; i++) {
+            const uint32_t* value = hashmap_t_get(&hashmap, i);
+            const uint32_t* swiss_value = swiss_hashmap_t_get(&swiss_hashmap, i);
+            const int expected = i % 3 == 0 && i / 3 % 2;
+            if (!value != !expected || (value && *value != i / 3)) {
+                fail("containers", "the hashmap lost an entry or kept a removed one");
+            }
+            if (!swiss_value != !expected || (swiss_value && *swiss_value != i / 3)) {
+                fail("containers", "the swiss-hashmap lost an entry or kept a removed one");
+            }
+            if (set_t_contains(&set, i) != expected) {
+                fail("containers", "the set lost a value or kept a removed one");
+            }
+        }
+        for (uint32_t i = 0; i < CONTAINER_COUNT; i++) {
+            if (vector_t_get(&vector, i) != i) {
+                fail("containers", "the vector lost a value");
+            }
+            if (pool_t_valid(&pool, handles[i]) != (i % 2 == 1) || (i % 2 && pool_t_get(&pool, handles[i]) != i)) {
+                fail("containers", "the dense-pool lost a value or kept a removed one");
+            }
+        }
+
+        // Finishing containers in an arena is allowed but only gives back what is on top.
+        vector_t_fini(&vector);
+        hashmap_t_fini(&hashmap);
+        swiss_hashmap_t_fini(&swiss_hashmap);
+        set_t_fini(&set);
+        pool_t_fini(&pool);
+        tds_arena_reset(&arena);
+    }
+    tds_arena_fini(&arena);
+}
+
+int main(void) {
+    test_alignment_and_reuse();
+    test_marks();
+    test_containers();
+    printf("arena: %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+// Measures the fast approximations of cvkm against libm in double precision and fails if any of them is off by more than
+// what cvkm.h documents. Runs the scalar and the SIMD builds of each, and the batch versions.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cvkm-ops.h"
+
+#define COUNT 1000000
+
+// The documented max errors, next to vkm_sin_fast in cvkm.h.
+#define SINCOS_MAX_ABSOLUTE_ERROR 1e-7
+#define SINCOS_MAX_ANGLE 8192.0f
+#define ATAN2_MAX_ABSOLUTE_ERROR 2e-6
+#define INVERSE_SQRT_MAX_RELATIVE_ERROR_SIMD 3e-7
+#define INVERSE_SQRT_MAX_RELATIVE_ERROR 5e-6
+
+static uint32_t random_state = 0x2545f491u;
+static int failures;
+
+// xorshift32, so that runs are reproducible.
+static uint32_t random_bits(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static float random_float(const float min, const float max) {
+    return min + (max - min) * (float)(random_bits() >> 8) / (float)(1 << 24);
+}
+
+static void* allocate(const size_t size) {
+    void* pointer = malloc(size);
+    if (!pointer) {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    return pointer;
+}
+
+// errors[i] is the error of value i, in whatever unit max_error is.
+static void check(const char* name, const double* errors, const float* inputs, const double max_error) {
+    double worst = 0.0;
+    size_t worst_index = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        // Also catches NaNs.
+        if (!(errors[i] <= worst)) {
+            worst = errors[i];
+            worst_index = i;
+        }
+    }
+    const bool failed = !(worst <= max_error);
+    printf("%-32s max error %.3g, bound %.3g%s\n", name, worst, max_error, failed ? ", FAILED" : "");
+    if (failed) {
+        fprintf(stderr, "%s: worst input %.9g\n", name, (double)inputs[worst_index]);
+    }
+    failures += failed;
+}
+
+static void check_sincos(const cvkm_ops* ops, const char* build, float* angles, float* results, double* errors) {
+    // Mostly random angles, plus every multiple of pi/4 in range and the floats around them, where the quadrant
+    // changes.
+    for (size_t i = 0; i < COUNT; i++) {
+        angles[i] = random_float(-SINCOS_MAX_ANGLE, SINCOS_MAX_ANGLE);
+    }
+    for (size_t i = 0, multiple = 0; i + 2 < COUNT && multiple * CVKM_PI_4 < SINCOS_MAX_ANGLE; i += 3, multiple++) {
+        const float angle = (float)((i & 1 ? -1.0 : 1.0) * (double)multiple * CVKM_PI_4);
+        angles[i] = angle;
+        angles[i + 1] = nextafterf(angle, -INFINITY);
+        angles[i + 2] = nextafterf(angle, INFINITY);
+    }
+
+    char name[64];
+    float* cosines = allocate(COUNT * sizeof(float));
+    ops->sin_fast(angles, results, COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        errors[i] = fabs((double)results[i] - sin((double)angles[i]));
+    }
+    snprintf(name, sizeof(name), "sin_fast (%s)", build);
+    check(name, errors, angles, SINCOS_MAX_ABSOLUTE_ERROR);
+
+    ops->cos_fast(angles, results, COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        errors[i] = fabs((double)results[i] - cos((double)angles[i]));
+    }
+    snprintf(name, sizeof(name), "cos_fast (%s)", build);
+    check(name, errors, angles, SINCOS_MAX_ABSOLUTE_ERROR);
+
+    ops->batch_sincos_fast(angles, results, cosines, COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        const double sine_error = fabs((double)results[i] - sin((double)angles[i]));
+        const double cosine_error = fabs((double)cosines[i] - cos((double)angles[i]));
+        errors[i] = sine_error > cosine_error ? sine_error : cosine_error;
+    }
+    snprintf(name, sizeof(name), "batch_sincos_fast (%s)", build);
+    check(name, errors, angles, SINCOS_MAX_ABSOLUTE_ERROR);
+    free(cosines);
+}
+
+static void check_atan2(const cvkm_ops* ops, const char* build, float* results, double* errors) {
+    // Magnitudes spread over many octaves, with some zeros, so every octant and the axes are covered.
+    float* ys = allocate(COUNT * sizeof(float));
+    float* xs = allocate(COUNT * sizeof(float));
+    for (size_t i = 0; i < COUNT; i++) {
+        ys[i] = i % 101 == 0 ? 0.0f : copysignf(exp2f(random_float(-20.0f, 20.0f)), random_float(-1.0f, 1.0f));
+        xs[i] = i % 103 == 0 ? 0.0f : copysignf(exp2f(random_float(-20.0f, 20.0f)), random_float(-1.0f, 1.0f));
+    }
+
+    char name[64];
+    ops->atan2_fast(ys, xs, results, COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        errors[i] = fabs((double)results[i] - atan2((double)ys[i], (double)xs[i]));
+    }
+    snprintf(name, sizeof(name), "atan2_fast (%s)", build);
+    check(name, errors, ys, ATAN2_MAX_ABSOLUTE_ERROR);
+
+    ops->batch_atan2_fast(ys, xs, results, COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        errors[i] = fabs((double)results[i] - atan2((double)ys[i], (double)xs[i]));
+    }
+    snprintf(name, sizeof(name), "batch_atan2_fast (%s)", build);
+    check(name, errors, ys, ATAN2_MAX_ABSOLUTE_ERROR);
+    free(ys);
+    free(xs);
+}
+
+static void check_inverse_sqrt(
+    const cvkm_ops* ops,
+    const char* build,
+    const double max_error,
+    float* values,
+    float* results,
+    double* errors
+) {
+    // Every normal float is fair game, so spread them over the whole exponent range.
+    for (size_t i = 0; i < COUNT; i++) {
+        values[i] = exp2f(random_float(-125.0f, 127.0f));
+    }
+
+    char name[64];
+    ops->inverse_sqrt_fast(values, results, COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        const double exact = 1.0 / sqrt((double)values[i]);
+        errors[i] = fabs((double)results[i] - exact) / exact;
+    }
+    snprintf(name, sizeof(name), "inverse_sqrt_fast (%s)", build);
+    check(name, errors, values, max_error);
+}
+
+int main(void) {
+    float* inputs = allocate(COUNT * sizeof(float));
+    float* results = allocate(COUNT * sizeof(float));
+    double* errors = allocate(COUNT * sizeof(double));
+
+    check_sincos(&cvkm_scalar_ops, "scalar", inputs, results, errors);
+    check_sincos(&cvkm_simd_ops, "SIMD", inputs, results, errors);
+    check_atan2(&cvkm_scalar_ops, "scalar", results, errors);
+    check_atan2(&cvkm_simd_ops, "SIMD", results, errors);
+    check_inverse_sqrt(&cvkm_scalar_ops, "scalar", INVERSE_SQRT_MAX_RELATIVE_ERROR, inputs, results, errors);
+    check_inverse_sqrt(&cvkm_simd_ops, "SIMD", INVERSE_SQRT_MAX_RELATIVE_ERROR_SIMD, inputs, results, errors);
+
+    free(inputs);
+    free(results);
+    free(errors);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
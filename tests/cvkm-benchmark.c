@@ -0,0 +1,217 @@
+// Throughput of the scalar and SIMD versions of the cvkm functions, side by side. Each function runs over arrays that
+// fit in the L2 cache, so this measures the arithmetic rather than memory bandwidth.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cvkm-ops.h"
+
+#define ITEM_COUNT 4096
+#define MIN_SECONDS 0.2
+
+typedef void (*benchmark_function)(const cvkm_ops* ops);
+
+static vkm_mat4 a[ITEM_COUNT], b[ITEM_COUNT], result[ITEM_COUNT];
+static float floats[ITEM_COUNT];
+
+// For the batch functions.
+static vkm_mat4 matrix;
+static vkm_vec4 planes[6];
+static float soa_floats[4][3][ITEM_COUNT];
+static const vkm_vec3_soa
+    points = { soa_floats[0][0], soa_floats[0][1], soa_floats[0][2] },
+    maxs = { soa_floats[1][0], soa_floats[1][1], soa_floats[1][2] },
+    result_points = { soa_floats[2][0], soa_floats[2][1], soa_floats[2][2] },
+    result_maxs = { soa_floats[3][0], soa_floats[3][1], soa_floats[3][2] };
+static bool visible[ITEM_COUNT];
+static Position3D positions[ITEM_COUNT];
+static Velocity3D velocities[ITEM_COUNT];
+static Acceleration3D accelerations[ITEM_COUNT];
+
+// For the fast approximations. Angles and coordinates go in inputs, positive values for the inverse square root in
+// positive_inputs.
+static float inputs[2][ITEM_COUNT], positive_inputs[ITEM_COUNT], outputs[2][ITEM_COUNT];
+
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// Nanoseconds per item.
+static double run(const benchmark_function function, const cvkm_ops* ops) {
+    function(ops);
+    size_t runs = 0;
+    const double start = seconds();
+    double elapsed;
+    do {
+        for (int i = 0; i < 16; i++) {
+            function(ops);
+        }
+        runs += 16;
+        elapsed = seconds() - start;
+    } while (elapsed < MIN_SECONDS);
+    return elapsed * 1e9 / (double)(runs * ITEM_COUNT);
+}
+
+// For functions that are the same in both builds, like the libm ones.
+static void measure_reference(const char* name, const benchmark_function function) {
+    printf("%-28s %8.2f ns\n", name, run(function, &cvkm_scalar_ops));
+}
+
+static void measure(const char* name, const benchmark_function function) {
+    const double scalar = run(function, &cvkm_scalar_ops), simd = run(function, &cvkm_simd_ops);
+    printf("%-28s %8.2f ns scalar %8.2f ns SIMD %6.2fx\n", name, scalar, simd, scalar / simd);
+}
+
+static void vec4_add(const cvkm_ops* ops) {
+    ops->vec4_add(a->columns, b->columns, result->columns, ITEM_COUNT);
+}
+
+static void vec4_muladd(const cvkm_ops* ops) {
+    ops->vec4_muladd(a->columns, b->columns, result->columns, ITEM_COUNT);
+}
+
+static void vec4_dot(const cvkm_ops* ops) {
+    ops->vec4_dot(a->columns, b->columns, floats, ITEM_COUNT);
+}
+
+static void vec4_normalize(const cvkm_ops* ops) {
+    ops->vec4_normalize(a->columns, result->columns, ITEM_COUNT);
+}
+
+static void quat_mul(const cvkm_ops* ops) {
+    ops->quat_mul((const vkm_quat*)a, (const vkm_quat*)b, (vkm_quat*)result, ITEM_COUNT);
+}
+
+static void mat4_mul(const cvkm_ops* ops) {
+    ops->mat4_mul(a, b, result, ITEM_COUNT);
+}
+
+static void mat4_mul_transform(const cvkm_ops* ops) {
+    ops->mat4_mul_transform(a, b, result, ITEM_COUNT);
+}
+
+static void mat4_transpose(const cvkm_ops* ops) {
+    ops->mat4_transpose(a, result, ITEM_COUNT);
+}
+
+static void batch_transform_points(const cvkm_ops* ops) {
+    ops->batch_transform_points(&matrix, &points, &result_points, ITEM_COUNT);
+}
+
+static void batch_transform_aabbs(const cvkm_ops* ops) {
+    ops->batch_transform_aabbs(&matrix, &points, &maxs, &result_points, &result_maxs, ITEM_COUNT);
+}
+
+static void batch_aabbs_test_planes(const cvkm_ops* ops) {
+    ops->batch_aabbs_test_planes(planes, 6, &points, &maxs, visible, ITEM_COUNT);
+}
+
+static void batch_normalize(const cvkm_ops* ops) {
+    ops->batch_normalize(&points, &result_points, ITEM_COUNT);
+}
+
+static void batch_integrate(const cvkm_ops* ops) {
+    ops->batch_integrate(positions, velocities, accelerations, 1.0f / 60.0f, ITEM_COUNT);
+}
+
+static void sin_cos_libm(const cvkm_ops* ops) {
+    (void)ops;
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        outputs[0][i] = sinf(inputs[0][i]);
+        outputs[1][i] = cosf(inputs[0][i]);
+    }
+}
+
+static void sin_cos_fast(const cvkm_ops* ops) {
+    ops->sin_fast(inputs[0], outputs[0], ITEM_COUNT);
+    ops->cos_fast(inputs[0], outputs[1], ITEM_COUNT);
+}
+
+static void batch_sincos_fast(const cvkm_ops* ops) {
+    ops->batch_sincos_fast(inputs[0], outputs[0], outputs[1], ITEM_COUNT);
+}
+
+static void atan2_libm(const cvkm_ops* ops) {
+    (void)ops;
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        outputs[0][i] = atan2f(inputs[0][i], inputs[1][i]);
+    }
+}
+
+static void atan2_fast(const cvkm_ops* ops) {
+    ops->atan2_fast(inputs[0], inputs[1], outputs[0], ITEM_COUNT);
+}
+
+static void batch_atan2_fast(const cvkm_ops* ops) {
+    ops->batch_atan2_fast(inputs[0], inputs[1], outputs[0], ITEM_COUNT);
+}
+
+static void inverse_sqrt_libm(const cvkm_ops* ops) {
+    (void)ops;
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        outputs[0][i] = 1.0f / sqrtf(positive_inputs[i]);
+    }
+}
+
+static void inverse_sqrt_fast(const cvkm_ops* ops) {
+    ops->inverse_sqrt_fast(positive_inputs, outputs[0], ITEM_COUNT);
+}
+
+static float random_float(const float min, const float max) {
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+int main(void) {
+    srand(1);
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        for (int j = 0; j < 16; j++) {
+            a[i].raw[j] = random_float(-1.0f, 1.0f);
+            b[i].raw[j] = random_float(-1.0f, 1.0f);
+        }
+    }
+
+    // Boxes all around the camera of a frustum, so that some of them are culled by each plane.
+    vkm_mat4 view_projection;
+    vkm_perspective(CVKM_PI_2_F, 16.0f / 9.0f, 0.1f, 1000.0f, &view_projection);
+    vkm_frustum_planes(&view_projection, planes);
+    matrix = view_projection;
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        for (int j = 0; j < 3; j++) {
+            soa_floats[0][j][i] = random_float(-100.0f, 100.0f);
+            soa_floats[1][j][i] = soa_floats[0][j][i] + random_float(0.0f, 10.0f);
+            positions[i].raw[j] = random_float(-100.0f, 100.0f);
+            velocities[i].raw[j] = random_float(-10.0f, 10.0f);
+            accelerations[i].raw[j] = random_float(-10.0f, 10.0f);
+        }
+        inputs[0][i] = random_float(-100.0f, 100.0f);
+        inputs[1][i] = random_float(-100.0f, 100.0f);
+        positive_inputs[i] = random_float(0.001f, 1000.0f);
+    }
+
+    measure("vec4_add", vec4_add);
+    measure("vec4_muladd", vec4_muladd);
+    measure("vec4_dot", vec4_dot);
+    measure("vec4_normalize", vec4_normalize);
+    measure("quat_mul", quat_mul);
+    measure("mat4_mul", mat4_mul);
+    measure("mat4_mul_transform", mat4_mul_transform);
+    measure("mat4_transpose", mat4_transpose);
+    measure("batch_transform_points", batch_transform_points);
+    measure("batch_transform_aabbs", batch_transform_aabbs);
+    measure("batch_aabbs_test_planes (6)", batch_aabbs_test_planes);
+    measure("batch_normalize", batch_normalize);
+    measure("batch_integrate", batch_integrate);
+    measure_reference("sinf + cosf (libm)", sin_cos_libm);
+    measure("sin_fast + cos_fast", sin_cos_fast);
+    measure("batch_sincos_fast", batch_sincos_fast);
+    measure_reference("atan2f (libm)", atan2_libm);
+    measure("atan2_fast", atan2_fast);
+    measure("batch_atan2_fast", batch_atan2_fast);
+    measure_reference("1 / sqrtf (libm)", inverse_sqrt_libm);
+    measure("inverse_sqrt_fast", inverse_sqrt_fast);
+    return EXIT_SUCCESS;
+}
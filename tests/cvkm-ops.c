@@ -0,0 +1,126 @@
+// Compiled twice, see cvkm-ops.h. CVKM_OPS is the name of the table to define.
+
+#include "cvkm-ops.h"
+
+// b_argument is how item i of b is passed: by address for vectors and matrices, by value for scalars.
+#define CVKM_OPS_BINARY(name, type, b_type, result_type, b_argument) static void name(\
+    const type* a,\
+    const b_type* b,\
+    result_type* result,\
+    const size_t count\
+) {\
+    for (size_t i = 0; i < count; i++) {\
+        vkm_##name(a + i, b_argument, result + i);\
+    }\
+}
+
+#define CVKM_OPS_VEC4_BINARY(name) CVKM_OPS_BINARY(name, vkm_vec4, vkm_vec4, vkm_vec4, b + i)
+#define CVKM_OPS_VEC4_SCALAR(name) CVKM_OPS_BINARY(name, vkm_vec4, float, vkm_vec4, b[i])
+#define CVKM_OPS_MAT4_BINARY(name) CVKM_OPS_BINARY(name, vkm_mat4, vkm_mat4, vkm_mat4, b + i)
+
+CVKM_OPS_VEC4_BINARY(vec4_add)
+CVKM_OPS_VEC4_BINARY(vec4_sub)
+CVKM_OPS_VEC4_BINARY(vec4_mul)
+CVKM_OPS_VEC4_BINARY(vec4_div)
+CVKM_OPS_VEC4_SCALAR(vec4_add_scalar)
+CVKM_OPS_VEC4_SCALAR(vec4_sub_scalar)
+CVKM_OPS_VEC4_SCALAR(vec4_mul_scalar)
+CVKM_OPS_VEC4_SCALAR(vec4_div_scalar)
+CVKM_OPS_VEC4_BINARY(vec4_muladd)
+CVKM_OPS_VEC4_SCALAR(vec4_muladd_scalar)
+CVKM_OPS_VEC4_BINARY(vec4_min)
+CVKM_OPS_VEC4_BINARY(vec4_max)
+CVKM_OPS_BINARY(quat_mul, vkm_quat, vkm_quat, vkm_quat, b + i)
+CVKM_OPS_MAT4_BINARY(mat4_mul)
+CVKM_OPS_MAT4_BINARY(mat4_mul_transform)
+CVKM_OPS_MAT4_BINARY(mat4_mul_rotation)
+
+static void vec4_dot(const vkm_vec4* a, const vkm_vec4* b, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_vec4_dot(a + i, b + i);
+    }
+}
+
+static void vec4_sqr_magnitude(const vkm_vec4* a, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_vec4_sqr_magnitude(a + i);
+    }
+}
+
+static void vec4_magnitude(const vkm_vec4* a, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_vec4_magnitude(a + i);
+    }
+}
+
+static void vec4_normalize(const vkm_vec4* a, vkm_vec4* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = a[i];
+        vkm_vec4_normalize(a + i, result + i);
+    }
+}
+
+static void mat4_transpose(const vkm_mat4* a, vkm_mat4* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        vkm_mat4_transpose(a + i, result + i);
+    }
+}
+
+static void sin_fast(const float* angles, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_sin_fast(angles[i]);
+    }
+}
+
+static void cos_fast(const float* angles, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_cos_fast(angles[i]);
+    }
+}
+
+static void atan2_fast(const float* ys, const float* xs, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_atan2_fast(ys[i], xs[i]);
+    }
+}
+
+static void inverse_sqrt_fast(const float* values, float* result, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = vkm_inverse_sqrt_fast(values[i]);
+    }
+}
+
+const cvkm_ops CVKM_OPS = {
+    .vec4_add = vec4_add,
+    .vec4_sub = vec4_sub,
+    .vec4_mul = vec4_mul,
+    .vec4_div = vec4_div,
+    .vec4_add_scalar = vec4_add_scalar,
+    .vec4_sub_scalar = vec4_sub_scalar,
+    .vec4_mul_scalar = vec4_mul_scalar,
+    .vec4_div_scalar = vec4_div_scalar,
+    .vec4_muladd = vec4_muladd,
+    .vec4_muladd_scalar = vec4_muladd_scalar,
+    .vec4_min = vec4_min,
+    .vec4_max = vec4_max,
+    .vec4_dot = vec4_dot,
+    .vec4_sqr_magnitude = vec4_sqr_magnitude,
+    .vec4_magnitude = vec4_magnitude,
+    .vec4_normalize = vec4_normalize,
+    .quat_mul = quat_mul,
+    .mat4_mul = mat4_mul,
+    .mat4_mul_transform = mat4_mul_transform,
+    .mat4_mul_rotation = mat4_mul_rotation,
+    .mat4_transpose = mat4_transpose,
+    .sin_fast = sin_fast,
+    .cos_fast = cos_fast,
+    .atan2_fast = atan2_fast,
+    .inverse_sqrt_fast = inverse_sqrt_fast,
+    .batch_transform_points = vkm_batch_transform_points,
+    .batch_transform_aabbs = vkm_batch_transform_aabbs,
+    .batch_aabbs_test_planes = vkm_batch_aabbs_test_planes,
+    .batch_normalize = vkm_batch_normalize,
+    .batch_integrate = vkm_batch_integrate,
+    .batch_sincos_fast = vkm_batch_sincos_fast,
+    .batch_atan2_fast = vkm_batch_atan2_fast,
+};
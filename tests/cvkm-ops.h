@@ -0,0 +1,73 @@
+#pragma once
+// The cvkm functions that have a SIMD version, wrapped to run over arrays if they don't already. cvkm-ops.c is compiled
+// once with and once without CVKM_SIMD, giving one table each, so that both versions can be called from the same
+// program.
+
+#include <cvkm.h>
+
+typedef struct cvkm_ops {
+    void (*vec4_add)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_sub)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_mul)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_div)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_add_scalar)(const vkm_vec4* a, const float* b, vkm_vec4* result, size_t count);
+    void (*vec4_sub_scalar)(const vkm_vec4* a, const float* b, vkm_vec4* result, size_t count);
+    void (*vec4_mul_scalar)(const vkm_vec4* a, const float* b, vkm_vec4* result, size_t count);
+    void (*vec4_div_scalar)(const vkm_vec4* a, const float* b, vkm_vec4* result, size_t count);
+    // result is read too.
+    void (*vec4_muladd)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_muladd_scalar)(const vkm_vec4* a, const float* b, vkm_vec4* result, size_t count);
+    void (*vec4_min)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_max)(const vkm_vec4* a, const vkm_vec4* b, vkm_vec4* result, size_t count);
+    void (*vec4_dot)(const vkm_vec4* a, const vkm_vec4* b, float* result, size_t count);
+    void (*vec4_sqr_magnitude)(const vkm_vec4* a, float* result, size_t count);
+    void (*vec4_magnitude)(const vkm_vec4* a, float* result, size_t count);
+    void (*vec4_normalize)(const vkm_vec4* a, vkm_vec4* result, size_t count);
+    void (*quat_mul)(const vkm_quat* a, const vkm_quat* b, vkm_quat* result, size_t count);
+    void (*mat4_mul)(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result, size_t count);
+    void (*mat4_mul_transform)(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result, size_t count);
+    void (*mat4_mul_rotation)(const vkm_mat4* a, const vkm_mat4* b, vkm_mat4* result, size_t count);
+    void (*mat4_transpose)(const vkm_mat4* a, vkm_mat4* result, size_t count);
+    // The fast approximations, some of which only differ with SIMD in their batch versions.
+    void (*sin_fast)(const float* angles, float* result, size_t count);
+    void (*cos_fast)(const float* angles, float* result, size_t count);
+    void (*atan2_fast)(const float* ys, const float* xs, float* result, size_t count);
+    void (*inverse_sqrt_fast)(const float* values, float* result, size_t count);
+
+    // The batch functions as they are.
+    void (*batch_transform_points)(
+        const vkm_mat4* matrix,
+        const vkm_vec3_soa* points,
+        const vkm_vec3_soa* result,
+        size_t count
+    );
+    void (*batch_transform_aabbs)(
+        const vkm_mat4* matrix,
+        const vkm_vec3_soa* mins,
+        const vkm_vec3_soa* maxs,
+        const vkm_vec3_soa* result_mins,
+        const vkm_vec3_soa* result_maxs,
+        size_t count
+    );
+    void (*batch_aabbs_test_planes)(
+        const vkm_vec4* planes,
+        size_t plane_count,
+        const vkm_vec3_soa* mins,
+        const vkm_vec3_soa* maxs,
+        bool* visible,
+        size_t count
+    );
+    void (*batch_normalize)(const vkm_vec3_soa* vectors, const vkm_vec3_soa* result, size_t count);
+    void (*batch_integrate)(
+        Position3D* positions,
+        Velocity3D* velocities,
+        const Acceleration3D* accelerations,
+        float delta_time,
+        size_t count
+    );
+    void (*batch_sincos_fast)(const float* angles, float* sines, float* cosines, size_t count);
+    void (*batch_atan2_fast)(const float* ys, const float* xs, float* results, size_t count);
+} cvkm_ops;
+
+extern const cvkm_ops cvkm_scalar_ops;
+extern const cvkm_ops cvkm_simd_ops;
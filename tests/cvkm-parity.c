@@ -0,0 +1,317 @@
+// Checks that the SIMD versions of the cvkm functions give the same results as the scalar ones on random inputs.
+// Operations done in the same order on both sides have to match bit for bit, which includes all of the batch functions.
+// The dot product family, which sums in a different order with SIMD, has to stay within CVKM_PARITY_MAX_ULPS. Both only
+// hold when the compiler doesn't contract multiplies and adds into FMAs, so this is built with -ffp-contract=off, see
+// tests/CMakeLists.txt.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cvkm-ops.h"
+
+#define CVKM_PARITY_COUNT 100000
+// In ULPs of the sum of the magnitudes of the terms, which bounds the error of any summation order.
+#define CVKM_PARITY_MAX_ULPS 4
+
+static uint32_t random_state = 0x9e3779b9u;
+static int failures;
+
+// xorshift32, so that runs are reproducible.
+static float random_float(const float min, const float max) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return min + (max - min) * (float)(random_state >> 8) / (float)(1 << 24);
+}
+
+static void fill_random(float* values, const size_t count, const float min, const float max) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] = random_float(min, max);
+    }
+}
+
+static void* allocate(const size_t size) {
+    void* pointer = malloc(size);
+    if (!pointer) {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    return pointer;
+}
+
+static void check_exact(const char* name, const float* simd, const float* scalar, const size_t count) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(simd + i, scalar + i, sizeof(float)) != 0 && mismatches++ < 5) {
+            fprintf(stderr, "%s: float %zu is %.9g with SIMD, %.9g without\n", name, i, simd[i], scalar[i]);
+        }
+    }
+    printf("%-28s %s\n", name, mismatches ? "FAILED" : "exact");
+    failures += mismatches != 0;
+}
+
+static float ulp(const float value) {
+    const float magnitude = fabsf(value);
+    return nextafterf(magnitude, INFINITY) - magnitude;
+}
+
+// reference[i] is the sum of the magnitudes of the terms that made scalar[i].
+static void check_close(
+    const char* name,
+    const float* simd,
+    const float* scalar,
+    const float* reference,
+    const size_t count
+) {
+    size_t mismatches = 0;
+    float max_ulps = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        const float ulps = fabsf(simd[i] - scalar[i]) / ulp(reference[i]);
+        max_ulps = ulps > max_ulps ? ulps : max_ulps;
+        if (!(ulps <= CVKM_PARITY_MAX_ULPS) && mismatches++ < 5) {
+            fprintf(stderr, "%s: float %zu is %.9g with SIMD, %.9g without\n", name, i, simd[i], scalar[i]);
+        }
+    }
+    printf("%-28s %s, max %.1f ULPs\n", name, mismatches ? "FAILED" : "ok", (double)max_ulps);
+    failures += mismatches != 0;
+}
+
+static void allocate_soa(vkm_vec3_soa* soa, const size_t count) {
+    soa->x = allocate(count * sizeof(float));
+    soa->y = allocate(count * sizeof(float));
+    soa->z = allocate(count * sizeof(float));
+}
+
+static void fill_random_soa(const vkm_vec3_soa* soa, const size_t count, const float min, const float max) {
+    fill_random(soa->x, count, min, max);
+    fill_random(soa->y, count, min, max);
+    fill_random(soa->z, count, min, max);
+}
+
+static void free_soa(const vkm_vec3_soa* soa) {
+    free(soa->x);
+    free(soa->y);
+    free(soa->z);
+}
+
+static void check_exact_soa(
+    const char* name,
+    const vkm_vec3_soa* simd,
+    const vkm_vec3_soa* scalar,
+    const size_t count
+) {
+    char component_name[64];
+    snprintf(component_name, sizeof(component_name), "%s x", name);
+    check_exact(component_name, simd->x, scalar->x, count);
+    snprintf(component_name, sizeof(component_name), "%s y", name);
+    check_exact(component_name, simd->y, scalar->y, count);
+    snprintf(component_name, sizeof(component_name), "%s z", name);
+    check_exact(component_name, simd->z, scalar->z, count);
+}
+
+// The SIMD batch functions do four items per iteration and the rest one at a time, so the count is left odd to go
+// through both.
+static void check_batches(void) {
+    const size_t count = CVKM_PARITY_COUNT + 3;
+    vkm_mat4 matrix;
+    fill_random(matrix.raw, 16, -2.0f, 2.0f);
+
+    vkm_vec3_soa mins, maxs, simd, scalar, simd_maxs, scalar_maxs;
+    allocate_soa(&mins, count);
+    allocate_soa(&maxs, count);
+    allocate_soa(&simd, count);
+    allocate_soa(&scalar, count);
+    allocate_soa(&simd_maxs, count);
+    allocate_soa(&scalar_maxs, count);
+    fill_random_soa(&mins, count, -100.0f, 100.0f);
+    fill_random_soa(&maxs, count, 0.0f, 10.0f);
+    for (size_t i = 0; i < count; i++) {
+        maxs.x[i] += mins.x[i];
+        maxs.y[i] += mins.y[i];
+        maxs.z[i] += mins.z[i];
+    }
+
+    cvkm_simd_ops.batch_transform_points(&matrix, &mins, &simd, count);
+    cvkm_scalar_ops.batch_transform_points(&matrix, &mins, &scalar, count);
+    check_exact_soa("batch_transform_points", &simd, &scalar, count);
+
+    cvkm_simd_ops.batch_transform_aabbs(&matrix, &mins, &maxs, &simd, &simd_maxs, count);
+    cvkm_scalar_ops.batch_transform_aabbs(&matrix, &mins, &maxs, &scalar, &scalar_maxs, count);
+    check_exact_soa("batch_transform_aabbs min", &simd, &scalar, count);
+    check_exact_soa("batch_transform_aabbs max", &simd_maxs, &scalar_maxs, count);
+
+    // Planes through the volume of the boxes, so that each plane culls some of them.
+    vkm_vec4 planes[6];
+    for (int i = 0; i < 6; i++) {
+        fill_random(planes[i].raw, 3, -1.0f, 1.0f);
+        vkm_vec3_normalize((const vkm_vec3*)(planes + i), (vkm_vec3*)(planes + i));
+        planes[i].w = random_float(0.0f, 150.0f);
+    }
+    bool* simd_visible = allocate(count * sizeof(bool));
+    bool* scalar_visible = allocate(count * sizeof(bool));
+    cvkm_simd_ops.batch_aabbs_test_planes(planes, 6, &mins, &maxs, simd_visible, count);
+    cvkm_scalar_ops.batch_aabbs_test_planes(planes, 6, &mins, &maxs, scalar_visible, count);
+    size_t mismatches = 0, visible_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        visible_count += scalar_visible[i];
+        if (simd_visible[i] != scalar_visible[i] && mismatches++ < 5) {
+            fprintf(
+                stderr,
+                "batch_aabbs_test_planes: box %zu is %d with SIMD, %d without\n",
+                i,
+                simd_visible[i],
+                scalar_visible[i]);
+        }
+    }
+    printf(
+        "%-28s %s, %zu of %zu visible\n",
+        "batch_aabbs_test_planes",
+        mismatches ? "FAILED" : "exact",
+        visible_count,
+        count);
+    failures += mismatches != 0;
+    free(simd_visible);
+    free(scalar_visible);
+
+    // With zero vectors mixed in, which are left as they are.
+    for (size_t i = 0; i < count; i += 97) {
+        mins.x[i] = mins.y[i] = mins.z[i] = 0.0f;
+    }
+    cvkm_simd_ops.batch_normalize(&mins, &simd, count);
+    cvkm_scalar_ops.batch_normalize(&mins, &scalar, count);
+    check_exact_soa("batch_normalize", &simd, &scalar, count);
+
+    // Integrates the same state twice on each side, once with accelerations and once without.
+    Position3D* positions = allocate(count * 2 * sizeof(Position3D));
+    Velocity3D* velocities = allocate(count * 2 * sizeof(Velocity3D));
+    Acceleration3D* accelerations = allocate(count * sizeof(Acceleration3D));
+    fill_random((float*)positions, count * 3, -100.0f, 100.0f);
+    fill_random((float*)velocities, count * 3, -10.0f, 10.0f);
+    fill_random((float*)accelerations, count * 3, -10.0f, 10.0f);
+    memcpy(positions + count, positions, count * sizeof(Position3D));
+    memcpy(velocities + count, velocities, count * sizeof(Velocity3D));
+    for (int step = 0; step < 2; step++) {
+        const Acceleration3D* step_accelerations = step ? NULL : accelerations;
+        cvkm_simd_ops.batch_integrate(positions, velocities, step_accelerations, 1.0f / 60.0f, count);
+        cvkm_scalar_ops.batch_integrate(positions + count, velocities + count, step_accelerations, 1.0f / 60.0f, count);
+    }
+    check_exact("batch_integrate position", (const float*)positions, (const float*)(positions + count), count * 3);
+    check_exact("batch_integrate velocity", (const float*)velocities, (const float*)(velocities + count), count * 3);
+    free(positions);
+    free(velocities);
+    free(accelerations);
+
+    free_soa(&mins);
+    free_soa(&maxs);
+    free_soa(&simd);
+    free_soa(&scalar);
+    free_soa(&simd_maxs);
+    free_soa(&scalar_maxs);
+}
+
+int main(void) {
+    const size_t count = CVKM_PARITY_COUNT;
+    vkm_vec4* a = allocate(count * sizeof(vkm_mat4));
+    vkm_vec4* b = allocate(count * sizeof(vkm_mat4));
+    vkm_vec4* abs_a = allocate(count * sizeof(vkm_vec4));
+    vkm_vec4* abs_b = allocate(count * sizeof(vkm_vec4));
+    float* scalars = allocate(count * sizeof(float));
+    vkm_vec4* simd = allocate(count * sizeof(vkm_mat4));
+    vkm_vec4* scalar = allocate(count * sizeof(vkm_mat4));
+    float* reference = allocate(count * sizeof(vkm_vec4));
+
+    // Wide enough for cancellation to happen, with divisors kept away from 0.
+    fill_random((float*)a, count * 16, -100.0f, 100.0f);
+    fill_random((float*)b, count * 16, -100.0f, 100.0f);
+    fill_random(scalars, count, 0.5f, 100.0f);
+    for (size_t i = 0; i < count; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (fabsf(b[i].raw[j]) < 0.5f) {
+                b[i].raw[j] = 0.5f;
+            }
+            abs_a[i].raw[j] = fabsf(a[i].raw[j]);
+            abs_b[i].raw[j] = fabsf(b[i].raw[j]);
+        }
+    }
+
+    // Operations with the same order of operations on both sides.
+#define CHECK_EXACT_VEC4(operation, b_values) cvkm_simd_ops.operation(a, b_values, simd, count);\
+    cvkm_scalar_ops.operation(a, b_values, scalar, count);\
+    check_exact(#operation, (const float*)simd, (const float*)scalar, count * 4)
+
+    CHECK_EXACT_VEC4(vec4_add, b);
+    CHECK_EXACT_VEC4(vec4_sub, b);
+    CHECK_EXACT_VEC4(vec4_mul, b);
+    CHECK_EXACT_VEC4(vec4_div, b);
+    CHECK_EXACT_VEC4(vec4_add_scalar, scalars);
+    CHECK_EXACT_VEC4(vec4_sub_scalar, scalars);
+    CHECK_EXACT_VEC4(vec4_mul_scalar, scalars);
+    CHECK_EXACT_VEC4(vec4_div_scalar, scalars);
+    CHECK_EXACT_VEC4(vec4_min, b);
+    CHECK_EXACT_VEC4(vec4_max, b);
+#undef CHECK_EXACT_VEC4
+
+    memcpy(simd, a, count * sizeof(vkm_vec4));
+    memcpy(scalar, a, count * sizeof(vkm_vec4));
+    cvkm_simd_ops.vec4_muladd(b, b + count, simd, count);
+    cvkm_scalar_ops.vec4_muladd(b, b + count, scalar, count);
+    check_exact("vec4_muladd", (const float*)simd, (const float*)scalar, count * 4);
+    memcpy(simd, a, count * sizeof(vkm_vec4));
+    memcpy(scalar, a, count * sizeof(vkm_vec4));
+    cvkm_simd_ops.vec4_muladd_scalar(b, scalars, simd, count);
+    cvkm_scalar_ops.vec4_muladd_scalar(b, scalars, scalar, count);
+    check_exact("vec4_muladd_scalar", (const float*)simd, (const float*)scalar, count * 4);
+
+    cvkm_simd_ops.quat_mul((const vkm_quat*)a, (const vkm_quat*)b, (vkm_quat*)simd, count);
+    cvkm_scalar_ops.quat_mul((const vkm_quat*)a, (const vkm_quat*)b, (vkm_quat*)scalar, count);
+    check_exact("quat_mul", (const float*)simd, (const float*)scalar, count * 4);
+
+    const vkm_mat4* a_matrices = (const vkm_mat4*)a;
+    const vkm_mat4* b_matrices = (const vkm_mat4*)b;
+#define CHECK_EXACT_MAT4(operation) cvkm_simd_ops.operation(a_matrices, b_matrices, (vkm_mat4*)simd, count);\
+    cvkm_scalar_ops.operation(a_matrices, b_matrices, (vkm_mat4*)scalar, count);\
+    check_exact(#operation, (const float*)simd, (const float*)scalar, count * 16)
+
+    CHECK_EXACT_MAT4(mat4_mul);
+    CHECK_EXACT_MAT4(mat4_mul_transform);
+    CHECK_EXACT_MAT4(mat4_mul_rotation);
+#undef CHECK_EXACT_MAT4
+
+    cvkm_simd_ops.mat4_transpose(a_matrices, (vkm_mat4*)simd, count);
+    cvkm_scalar_ops.mat4_transpose(a_matrices, (vkm_mat4*)scalar, count);
+    check_exact("mat4_transpose", (const float*)simd, (const float*)scalar, count * 16);
+
+    // The dot product family. Squares are never negative, so there the result is its own reference.
+    float* simd_floats = (float*)simd;
+    float* scalar_floats = (float*)scalar;
+    cvkm_simd_ops.vec4_dot(a, b, simd_floats, count);
+    cvkm_scalar_ops.vec4_dot(a, b, scalar_floats, count);
+    cvkm_scalar_ops.vec4_dot(abs_a, abs_b, reference, count);
+    check_close("vec4_dot", simd_floats, scalar_floats, reference, count);
+
+    cvkm_simd_ops.vec4_sqr_magnitude(a, simd_floats, count);
+    cvkm_scalar_ops.vec4_sqr_magnitude(a, scalar_floats, count);
+    check_close("vec4_sqr_magnitude", simd_floats, scalar_floats, scalar_floats, count);
+
+    cvkm_simd_ops.vec4_magnitude(a, simd_floats, count);
+    cvkm_scalar_ops.vec4_magnitude(a, scalar_floats, count);
+    check_close("vec4_magnitude", simd_floats, scalar_floats, scalar_floats, count);
+
+    cvkm_simd_ops.vec4_normalize(a, simd, count);
+    cvkm_scalar_ops.vec4_normalize(a, scalar, count);
+    check_close("vec4_normalize", (const float*)simd, (const float*)scalar, (const float*)scalar, count * 4);
+
+    free(a);
+    free(b);
+    free(abs_a);
+    free(abs_b);
+    free(scalars);
+    free(simd);
+    free(scalar);
+    free(reference);
+
+    check_batches();
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+// Checks the handles of the tds dense-pool: live handles get their own value back through swap removals, removed and
+// cleared handles stop being valid, generations wrap around past 0 instead of making the never valid 0 handle, and clear
+// only visits the live values instead of the whole capacity.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The default, spelled out because the test depends on it.
+#define GENERATION_BITS 8
+
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE pool_t
+#define TDS_GENERATION_BITS GENERATION_BITS
+#include <tds/dense-pool.h>
+
+#define LIVE_MAX 1024
+#define STEP_COUNT 200000
+#define INDEX_MASK ((1u << (32 - GENERATION_BITS)) - 1)
+
+static uint32_t random_state = 0x1b873593;
+
+static uint32_t random_u32(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static int failures;
+
+static void fail(const char* test, const char* message, const uint32_t handle) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: %s (handle 0x%08" PRIx32 ")\n", test, message, handle);
+    }
+}
+
+// Random appends and removes against a list of the live handles and their values. Every removed handle is kept too,
+// and checked to be invalid unless its index came back around to the same generation.
+static void test_random(void) {
+    static uint32_t live[LIVE_MAX], live_values[LIVE_MAX], removed[STEP_COUNT];
+    uint32_t live_count = 0, removed_count = 0;
+    pool_t pool = { .allocator = NULL };
+
+    for (uint32_t step = 0; step < STEP_COUNT; step++) {
+        if (live_count < LIVE_MAX && (live_count == 0 || random_u32() % 2)) {
+            const uint32_t handle = pool_t_append(&pool, step);
+            if (!pool_t_valid(&pool, handle)) {
+                fail("random", "a new handle isn't valid", handle);
+            }
+            live[live_count] = handle;
+            live_values[live_count++] = step;
+        } else {
+            const uint32_t i = random_u32() % live_count;
+            pool_t_remove(&pool, live[i]);
+            if (pool_t_valid(&pool, live[i])) {
+                fail("random", "a removed handle is still valid", live[i]);
+            }
+            removed[removed_count++] = live[i];
+            live[i] = live[--live_count];
+            live_values[i] = live_values[live_count];
+        }
+
+        if (pool_t_count(&pool) != live_count) {
+            fail("random", "the count is off", 0);
+        }
+        const uint32_t i = random_u32() % (live_count ? live_count : 1);
+        if (live_count && pool_t_get(&pool, live[i]) != live_values[i]) {
+            fail("random", "a handle got another value", live[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < live_count; i++) {
+        if (!pool_t_valid(&pool, live[i]) || pool_t_get(&pool, live[i]) != live_values[i]) {
+            fail("random", "a live handle lost its value", live[i]);
+        }
+    }
+    // An index reused often enough comes back to an old generation, which is the accepted cost of small generations,
+    // so only the removed handles that aren't live again are checked.
+    for (uint32_t i = 0; i < removed_count; i++) {
+        char alive = 0;
+        for (uint32_t j = 0; j < live_count && !alive; j++) {
+            alive = live[j] == removed[i];
+        }
+        if (!alive && pool_t_valid(&pool, removed[i])) {
+            fail("random", "a removed handle is valid again", removed[i]);
+        }
+    }
+
+    pool_t_clear(&pool);
+    for (uint32_t i = 0; i < live_count; i++) {
+        if (pool_t_valid(&pool, live[i])) {
+            fail("random", "a cleared handle is still valid", live[i]);
+        }
+    }
+    if (pool_t_count(&pool) != 0) {
+        fail("random", "the pool isn't empty after clear", 0);
+    }
+    pool_t_fini(&pool);
+}
+
+// Removing and appending again reuses the same index with the next generation, from 1 up to the largest one and then
+// back to 1, never 0.
+static void test_generation_wrap(void) {
+    pool_t pool = { .allocator = NULL };
+    if (pool_t_valid(&pool, 0)) {
+        fail("generations", "0 is valid in an empty pool", 0);
+    }
+
+    const uint32_t generation_count = (1u << GENERATION_BITS) - 1;
+    uint32_t handle = pool_t_append(&pool, 0);
+    const uint32_t first = handle;
+    for (uint32_t i = 1; i <= 2 * generation_count; i++) {
+        pool_t_remove(&pool, handle);
+        const uint32_t previous = handle;
+        handle = pool_t_append(&pool, i);
+
+        const uint32_t expected_generation = i % generation_count + 1;
+        if ((handle & INDEX_MASK) != (first & INDEX_MASK) || handle >> (32 - GENERATION_BITS) != expected_generation) {
+            fail("generations", "the index was reused with an unexpected generation", handle);
+        }
+        if (pool_t_valid(&pool, previous) || !pool_t_valid(&pool, handle) || pool_t_get(&pool, handle) != i) {
+            fail("generations", "the removed handle is valid or the new one isn't", handle);
+        }
+    }
+    if (handle != first) {
+        fail("generations", "two full cycles didn't come back to the first handle", handle);
+    }
+    pool_t_fini(&pool);
+}
+
+// After growing the pool and removing most of it, clear must leave the freelist part of dense alone: touching it would
+// mean clear costs the capacity rather than the count.
+static void test_clear_cost(void) {
+    static uint32_t handles[LIVE_MAX];
+    pool_t pool = { .allocator = NULL };
+    for (uint32_t i = 0; i < LIVE_MAX; i++) {
+        handles[i] = pool_t_append(&pool, i);
+    }
+    for (uint32_t i = 8; i < LIVE_MAX; i++) {
+        pool_t_remove(&pool, handles[i]);
+    }
+
+    const uint32_t count = pool_t_count(&pool), capacity = pool.capacity;
+    uint32_t* freelist = malloc((capacity - count) * sizeof(*freelist));
+    if (!freelist) {
+        fail("clear", "out of memory", 0);
+        return;
+    }
+    memcpy(freelist, pool.dense + count, (capacity - count) * sizeof(*freelist));
+    pool_t_clear(&pool);
+    if (memcmp(freelist, pool.dense + count, (capacity - count) * sizeof(*freelist)) != 0) {
+        fail("clear", "clear visited entries past the live ones", 0);
+    }
+    for (uint32_t i = 0; i < 8; i++) {
+        if (pool_t_valid(&pool, handles[i])) {
+            fail("clear", "a cleared handle is still valid", handles[i]);
+        }
+    }
+
+    // The cleared handles are handed out again, each with a new generation.
+    for (uint32_t i = 0; i < 8; i++) {
+        const uint32_t handle = pool_t_append(&pool, i);
+        if (!pool_t_valid(&pool, handle) || pool_t_valid(&pool, handles[i])) {
+            fail("clear", "a handle given out after clear is wrong", handle);
+        }
+    }
+    free(freelist);
+    pool_t_fini(&pool);
+}
+
+int main(void) {
+    test_random();
+    test_generation_wrap();
+    test_clear_cost();
+    printf("dense-pool: %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+// Checks the batched functions of the tds hash containers against their one key at a time counterparts: each container
+// is built twice, once with set_many or add_many and once with set or add, and get_many and contains_many answers are
+// checked against get and contains on the other copy. Batches have random lengths, so most end partway through a
+// TDS_BATCH_SIZE group, and often repeat a key, in which case the last value has to win like with a loop of sets.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TDS_KEY_T uint32_t
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE hashmap_t
+#include <tds/hashmap.h>
+
+#define TDS_KEY_T uint32_t
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE swiss_hashmap_t
+#include <tds/swiss-hashmap.h>
+
+#define TDS_VALUE_T uint32_t
+#define TDS_TYPE set_t
+#include <tds/set.h>
+
+#define KEY_RANGE 2048
+#define ROUND_COUNT 20000
+// Longest batch, a few groups and a partial one.
+#define MAX_BATCH (3 * TDS_BATCH_SIZE + TDS_BATCH_SIZE / 2)
+
+static uint32_t random_state = 0x6b43a9b5;
+
+static uint32_t random_u32(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static int failures;
+
+static void fail(const uint32_t round, const char* container, const char* message) {
+    if (failures++ < 10) {
+        fprintf(stderr, "round %" PRIu32 ": %s: %s\n", round, container, message);
+    }
+}
+
+// Random keys, a quarter of which repeat an earlier key of the batch.
+static uint32_t make_batch(uint32_t* keys, uint64_t* values) {
+    const uint32_t count = random_u32() % (MAX_BATCH + 1);
+    for (uint32_t i = 0; i < count; i++) {
+        keys[i] = i && random_u32() % 4 == 0 ? keys[random_u32() % i] : random_u32() % KEY_RANGE;
+        values[i] = (uint64_t)random_u32() << 32 | random_u32();
+    }
+    return count;
+}
+
+int main(void) {
+    hashmap_t batched_hashmap = { .allocator = NULL }, hashmap = { .allocator = NULL };
+    swiss_hashmap_t batched_swiss_hashmap = { .allocator = NULL }, swiss_hashmap = { .allocator = NULL };
+    set_t batched_set = { .allocator = NULL }, set = { .allocator = NULL };
+
+    uint32_t keys[MAX_BATCH];
+    uint64_t values[MAX_BATCH];
+    uint64_t* results[MAX_BATCH];
+    char contained[MAX_BATCH];
+    for (uint32_t round = 0; round < ROUND_COUNT; round++) {
+        // Reserving, on the batched copies only, must not change what they hold.
+        if (random_u32() % 16 == 0) {
+            const uint32_t count = random_u32() % (2 * KEY_RANGE);
+            hashmap_t_reserve(&batched_hashmap, count);
+            swiss_hashmap_t_reserve(&batched_swiss_hashmap, count);
+            set_t_reserve(&batched_set, count);
+        }
+
+        uint32_t count = make_batch(keys, values);
+        hashmap_t_set_many(&batched_hashmap, keys, values, count);
+        swiss_hashmap_t_set_many(&batched_swiss_hashmap, keys, values, count);
+        set_t_add_many(&batched_set, keys, count);
+        for (uint32_t i = 0; i < count; i++) {
+            hashmap_t_set(&hashmap, keys[i], values[i]);
+            swiss_hashmap_t_set(&swiss_hashmap, keys[i], values[i]);
+            set_t_add(&set, keys[i]);
+        }
+
+        // Removes keep the containers from filling up and leave tombstones for the batches to probe past.
+        count = make_batch(keys, values) / 2;
+        for (uint32_t i = 0; i < count; i++) {
+            hashmap_t_remove(&batched_hashmap, keys[i]);
+            hashmap_t_remove(&hashmap, keys[i]);
+            swiss_hashmap_t_remove(&batched_swiss_hashmap, keys[i]);
+            swiss_hashmap_t_remove(&swiss_hashmap, keys[i]);
+            set_t_remove(&batched_set, keys[i]);
+            set_t_remove(&set, keys[i]);
+        }
+
+        if (hashmap_t_count(&batched_hashmap) != hashmap_t_count(&hashmap)) {
+            fail(round, "hashmap", "counts differ");
+        }
+        if (swiss_hashmap_t_count(&batched_swiss_hashmap) != swiss_hashmap_t_count(&swiss_hashmap)) {
+            fail(round, "swiss-hashmap", "counts differ");
+        }
+        if (set_t_count(&batched_set) != set_t_count(&set)) {
+            fail(round, "set", "counts differ");
+        }
+
+        count = make_batch(keys, values);
+        uint32_t expected = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            expected += hashmap_t_get(&hashmap, keys[i]) != NULL;
+        }
+        if (hashmap_t_get_many(&batched_hashmap, keys, count, results) != expected) {
+            fail(round, "hashmap", "get_many found a different number of keys");
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t* value = hashmap_t_get(&hashmap, keys[i]);
+            if (!results[i] != !value || (value && *results[i] != *value)) {
+                fail(round, "hashmap", "get_many and get differ");
+            }
+        }
+
+        expected = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            expected += swiss_hashmap_t_get(&swiss_hashmap, keys[i]) != NULL;
+        }
+        if (swiss_hashmap_t_get_many(&batched_swiss_hashmap, keys, count, results) != expected) {
+            fail(round, "swiss-hashmap", "get_many found a different number of keys");
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t* value = swiss_hashmap_t_get(&swiss_hashmap, keys[i]);
+            if (!results[i] != !value || (value && *results[i] != *value)) {
+                fail(round, "swiss-hashmap", "get_many and get differ");
+            }
+        }
+
+        expected = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            expected += (uint32_t)set_t_contains(&set, keys[i]);
+        }
+        // Results are optional for sets.
+        if (set_t_contains_many(&batched_set, keys, count, contained) != expected
+            || set_t_contains_many(&batched_set, keys, count, NULL) != expected) {
+            fail(round, "set", "contains_many found a different number of values");
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            if (contained[i] != (char)set_t_contains(&set, keys[i])) {
+                fail(round, "set", "contains_many and contains differ");
+            }
+        }
+    }
+
+    hashmap_t_fini(&batched_hashmap);
+    hashmap_t_fini(&hashmap);
+    swiss_hashmap_t_fini(&batched_swiss_hashmap);
+    swiss_hashmap_t_fini(&swiss_hashmap);
+    set_t_fini(&batched_set);
+    set_t_fini(&set);
+    printf("hash-batch: %d rounds, %s\n", ROUND_COUNT, failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+// Throughput of the tds hashmap and swiss-hashmap, for comparing changes to them. Most lookups miss, which is the case
+// the swiss-hashmap layout is for: the robin hood hashmap walks its buckets until it reaches an empty one, while the
+// swiss-hashmap usually stops after one group of control bytes. Bulk loads build a map from nothing with a loop of
+// sets, with the same loop after a reserve, and with one set_many.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TDS_KEY_T uint64_t
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE hashmap_t
+#include <tds/hashmap.h>
+
+#define TDS_KEY_T uint64_t
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE swiss_hashmap_t
+#include <tds/swiss-hashmap.h>
+
+#define LOOKUP_COUNT (1 << 20)
+// One lookup in this many hits, the rest miss.
+#define HIT_INTERVAL 10
+#define MIN_SECONDS 0.2
+
+static uint64_t keys[LOOKUP_COUNT];
+static uint64_t values[LOOKUP_COUNT];
+static uint64_t* results[LOOKUP_COUNT];
+
+static uint64_t random_state = 0x9e3779b97f4a7c15;
+
+static uint64_t random_u64(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void report(const char* name, const char* unit, const uint64_t count, const double elapsed) {
+    printf(
+        "%-44s %6.1f M %ss/s (%.1f ns per %s)\n",
+        name,
+        (double)count / elapsed / 1e6,
+        unit,
+        elapsed * 1e9 / (double)count,
+        unit);
+}
+
+// Map keys are even and missing keys odd, so the lookups hit exactly as often as asked.
+static void make_keys(const uint32_t entry_count) {
+    for (uint32_t i = 0; i < LOOKUP_COUNT; i++) {
+        keys[i] = i % HIT_INTERVAL ? random_u64() | 1 : random_u64() % entry_count * 2;
+    }
+}
+
+// Each pass looks up every key once and returns how many were found.
+typedef uint64_t (*lookup_pass)(void);
+
+static hashmap_t hashmap;
+static swiss_hashmap_t swiss_hashmap;
+
+static uint64_t hashmap_get(void) {
+    uint64_t found = 0;
+    for (uint32_t i = 0; i < LOOKUP_COUNT; i++) {
+        found += hashmap_t_get(&hashmap, keys[i]) != NULL;
+    }
+    return found;
+}
+
+static uint64_t hashmap_get_many(void) {
+    return hashmap_t_get_many(&hashmap, keys, LOOKUP_COUNT, results);
+}
+
+static uint64_t swiss_hashmap_get(void) {
+    uint64_t found = 0;
+    for (uint32_t i = 0; i < LOOKUP_COUNT; i++) {
+        found += swiss_hashmap_t_get(&swiss_hashmap, keys[i]) != NULL;
+    }
+    return found;
+}
+
+static uint64_t swiss_hashmap_get_many(void) {
+    return swiss_hashmap_t_get_many(&swiss_hashmap, keys, LOOKUP_COUNT, results);
+}
+
+// Keeps the lookups from being optimized out.
+static uint64_t checksum;
+
+static void measure(const char* name, const uint32_t entry_count, const lookup_pass pass) {
+    uint64_t runs = 0;
+    const double start = seconds();
+    double elapsed;
+    do {
+        checksum += pass();
+        runs++;
+        elapsed = seconds() - start;
+    } while (elapsed < MIN_SECONDS);
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s, %u entries", name, (unsigned)entry_count);
+    report(label, "lookup", runs * LOOKUP_COUNT, elapsed);
+}
+
+// Each load builds a map of entry_count entries from nothing and frees it.
+typedef void (*bulk_load)(uint32_t entry_count);
+
+static void hashmap_load_set(const uint32_t entry_count) {
+    hashmap_t map = { .allocator = NULL };
+    for (uint32_t i = 0; i < entry_count; i++) {
+        hashmap_t_set(&map, keys[i], values[i]);
+    }
+    checksum += hashmap_t_count(&map);
+    hashmap_t_fini(&map);
+}
+
+static void hashmap_load_reserve_set(const uint32_t entry_count) {
+    hashmap_t map = { .allocator = NULL };
+    hashmap_t_reserve(&map, entry_count);
+    for (uint32_t i = 0; i < entry_count; i++) {
+        hashmap_t_set(&map, keys[i], values[i]);
+    }
+    checksum += hashmap_t_count(&map);
+    hashmap_t_fini(&map);
+}
+
+static void hashmap_load_set_many(const uint32_t entry_count) {
+    hashmap_t map = { .allocator = NULL };
+    hashmap_t_set_many(&map, keys, values, entry_count);
+    checksum += hashmap_t_count(&map);
+    hashmap_t_fini(&map);
+}
+
+static void swiss_hashmap_load_set(const uint32_t entry_count) {
+    swiss_hashmap_t map = { .allocator = NULL };
+    for (uint32_t i = 0; i < entry_count; i++) {
+        swiss_hashmap_t_set(&map, keys[i], values[i]);
+    }
+    checksum += swiss_hashmap_t_count(&map);
+    swiss_hashmap_t_fini(&map);
+}
+
+static void swiss_hashmap_load_reserve_set(const uint32_t entry_count) {
+    swiss_hashmap_t map = { .allocator = NULL };
+    swiss_hashmap_t_reserve(&map, entry_count);
+    for (uint32_t i = 0; i < entry_count; i++) {
+        swiss_hashmap_t_set(&map, keys[i], values[i]);
+    }
+    checksum += swiss_hashmap_t_count(&map);
+    swiss_hashmap_t_fini(&map);
+}
+
+static void swiss_hashmap_load_set_many(const uint32_t entry_count) {
+    swiss_hashmap_t map = { .allocator = NULL };
+    swiss_hashmap_t_set_many(&map, keys, values, entry_count);
+    checksum += swiss_hashmap_t_count(&map);
+    swiss_hashmap_t_fini(&map);
+}
+
+static void measure_load(const char* name, const uint32_t entry_count, const bulk_load load) {
+    uint64_t runs = 0;
+    const double start = seconds();
+    double elapsed;
+    do {
+        load(entry_count);
+        runs++;
+        elapsed = seconds() - start;
+    } while (elapsed < MIN_SECONDS);
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s, %u entries", name, (unsigned)entry_count);
+    report(label, "insert", runs * entry_count, elapsed);
+}
+
+int main(void) {
+    // From fitting in L1 to well past the last level cache.
+    for (uint32_t entry_count = 1 << 10; entry_count <= 1 << 22; entry_count <<= 4) {
+        make_keys(entry_count);
+        hashmap = (hashmap_t){ .allocator = NULL };
+        swiss_hashmap = (swiss_hashmap_t){ .allocator = NULL };
+        hashmap_t_reserve(&hashmap, entry_count);
+        swiss_hashmap_t_reserve(&swiss_hashmap, entry_count);
+        for (uint32_t i = 0; i < entry_count; i++) {
+            hashmap_t_set(&hashmap, (uint64_t)i * 2, i);
+            swiss_hashmap_t_set(&swiss_hashmap, (uint64_t)i * 2, i);
+        }
+
+        measure("hashmap get", entry_count, hashmap_get);
+        measure("hashmap get_many", entry_count, hashmap_get_many);
+        measure("swiss-hashmap get", entry_count, swiss_hashmap_get);
+        measure("swiss-hashmap get_many", entry_count, swiss_hashmap_get_many);
+        hashmap_t_fini(&hashmap);
+        swiss_hashmap_t_fini(&swiss_hashmap);
+    }
+
+    // Random keys, so the loads don't benefit from any order in them.
+    for (uint32_t i = 0; i < LOOKUP_COUNT; i++) {
+        keys[i] = random_u64();
+        values[i] = i;
+    }
+    for (uint32_t entry_count = 1 << 10; entry_count <= LOOKUP_COUNT; entry_count <<= 5) {
+        measure_load("hashmap set", entry_count, hashmap_load_set);
+        measure_load("hashmap reserve + set", entry_count, hashmap_load_reserve_set);
+        measure_load("hashmap set_many", entry_count, hashmap_load_set_many);
+        measure_load("swiss-hashmap set", entry_count, swiss_hashmap_load_set);
+        measure_load("swiss-hashmap reserve + set", entry_count, swiss_hashmap_load_reserve_set);
+        measure_load("swiss-hashmap set_many", entry_count, swiss_hashmap_load_set_many);
+    }
+
+    return checksum == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
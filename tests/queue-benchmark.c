@@ -0,0 +1,120 @@
+// Throughput of the tds queues, one value at a time between threads, for comparing changes to them. Waiting threads
+// yield, so the numbers stay meaningful with more threads than cores.
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE spsc_queue_t
+#include <tds/spsc-queue.h>
+
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE mpmc_queue_t
+#include <tds/mpmc-queue.h>
+
+#define VALUE_COUNT 20000000
+#define QUEUE_CAPACITY 1024
+#define MAX_THREADS 8
+
+static spsc_queue_t spsc_queue;
+static mpmc_queue_t mpmc_queue;
+static unsigned mpmc_thread_count;
+static atomic_uint_fast64_t mpmc_popped_count;
+static atomic_uint_fast64_t checksum;
+
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int spsc_produce(void* data) {
+    (void)data;
+    for (uint64_t i = 0; i < VALUE_COUNT; i++) {
+        while (!spsc_queue_t_push(&spsc_queue, i)) {
+            thrd_yield();
+        }
+    }
+    return 0;
+}
+
+static int mpmc_produce(void* data) {
+    (void)data;
+    for (uint64_t i = 0; i < VALUE_COUNT / mpmc_thread_count; i++) {
+        while (!mpmc_queue_t_push(&mpmc_queue, i)) {
+            thrd_yield();
+        }
+    }
+    return 0;
+}
+
+static int mpmc_consume(void* data) {
+    (void)data;
+    uint64_t sum = 0;
+    const uint64_t total = (uint64_t)(VALUE_COUNT / mpmc_thread_count) * mpmc_thread_count;
+    while (atomic_load_explicit(&mpmc_popped_count, memory_order_relaxed) < total) {
+        uint64_t value;
+        if (mpmc_queue_t_pop(&mpmc_queue, &value)) {
+            sum += value;
+            atomic_fetch_add_explicit(&mpmc_popped_count, 1, memory_order_relaxed);
+        } else {
+            thrd_yield();
+        }
+    }
+    atomic_fetch_add(&checksum, sum);
+    return 0;
+}
+
+static void report(const char* name, const uint64_t count, const double elapsed) {
+    printf("%-28s %6.1f M values/s (%.1f ns per value)\n", name, (double)count / elapsed / 1e6, elapsed * 1e9 / (double)count);
+}
+
+int main(void) {
+    spsc_queue_t_init(&spsc_queue, QUEUE_CAPACITY);
+    double start = seconds();
+    thrd_t producer;
+    if (thrd_create(&producer, spsc_produce, NULL) != thrd_success) {
+        return EXIT_FAILURE;
+    }
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < VALUE_COUNT;) {
+        uint64_t value;
+        if (spsc_queue_t_pop(&spsc_queue, &value)) {
+            sum += value;
+            i++;
+        } else {
+            thrd_yield();
+        }
+    }
+    thrd_join(producer, NULL);
+    report("spsc, 1 to 1", VALUE_COUNT, seconds() - start);
+    spsc_queue_t_fini(&spsc_queue);
+
+    for (mpmc_thread_count = 1; mpmc_thread_count <= MAX_THREADS / 2; mpmc_thread_count *= 2) {
+        mpmc_queue_t_init(&mpmc_queue, QUEUE_CAPACITY);
+        atomic_store(&mpmc_popped_count, 0);
+        thrd_t producers[MAX_THREADS / 2], consumers[MAX_THREADS / 2];
+        start = seconds();
+        for (unsigned i = 0; i < mpmc_thread_count; i++) {
+            if (thrd_create(consumers + i, mpmc_consume, NULL) != thrd_success
+                || thrd_create(producers + i, mpmc_produce, NULL) != thrd_success) {
+                return EXIT_FAILURE;
+            }
+        }
+        for (unsigned i = 0; i < mpmc_thread_count; i++) {
+            thrd_join(producers[i], NULL);
+            thrd_join(consumers[i], NULL);
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "mpmc, %u to %u", mpmc_thread_count, mpmc_thread_count);
+        report(name, (uint64_t)(VALUE_COUNT / mpmc_thread_count) * mpmc_thread_count, seconds() - start);
+        mpmc_queue_t_fini(&mpmc_queue);
+    }
+
+    // Keeps the popped values from being optimized out.
+    return sum + atomic_load(&checksum) == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
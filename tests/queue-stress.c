@@ -0,0 +1,153 @@
+// Hammers the tds queues from several threads at once and checks that every value comes out exactly once, and in order
+// for the single producer queue. Build with -fsanitize=thread to also catch data races; the sanitizer runtime has to
+// intercept thrd_create, which the one of GCC 12 doesn't, so use a newer compiler for that.
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE spsc_queue_t
+#include <tds/spsc-queue.h>
+
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE mpmc_queue_t
+#include <tds/mpmc-queue.h>
+
+#define SPSC_COUNT 4000000
+#define MPMC_PRODUCERS 4
+#define MPMC_CONSUMERS 4
+#define MPMC_COUNT_PER_PRODUCER 1000000
+// Small, so that the queues are full and empty all the time and the index wraparound gets exercised.
+#define QUEUE_CAPACITY 64
+
+static spsc_queue_t spsc_queue;
+static mpmc_queue_t mpmc_queue;
+static atomic_uint_fast64_t mpmc_popped_count;
+// How often each value came out, a value being its producer in the high bits and its index in the low ones.
+static atomic_uchar* mpmc_seen;
+
+static int spsc_produce(void* data) {
+    (void)data;
+    for (uint64_t i = 0; i < SPSC_COUNT; i++) {
+        while (!spsc_queue_t_push(&spsc_queue, i)) {
+            thrd_yield();
+        }
+    }
+    return 0;
+}
+
+static int mpmc_produce(void* data) {
+    const uint64_t producer = (uint64_t)(uintptr_t)data;
+    for (uint64_t i = 0; i < MPMC_COUNT_PER_PRODUCER; i++) {
+        while (!mpmc_queue_t_push(&mpmc_queue, producer * MPMC_COUNT_PER_PRODUCER + i)) {
+            thrd_yield();
+        }
+    }
+    return 0;
+}
+
+static int mpmc_consume(void* data) {
+    (void)data;
+    while (atomic_load(&mpmc_popped_count) < (uint64_t)MPMC_PRODUCERS * MPMC_COUNT_PER_PRODUCER) {
+        uint64_t value;
+        if (mpmc_queue_t_pop(&mpmc_queue, &value)) {
+            atomic_fetch_add(&mpmc_seen[value], 1);
+            atomic_fetch_add(&mpmc_popped_count, 1);
+        } else {
+            thrd_yield();
+        }
+    }
+    return 0;
+}
+
+static int test_spsc(void) {
+    spsc_queue_t_init(&spsc_queue, QUEUE_CAPACITY);
+    thrd_t producer;
+    if (thrd_create(&producer, spsc_produce, NULL) != thrd_success) {
+        fputs("spsc: thrd_create failed\n", stderr);
+        return 1;
+    }
+
+    int failures = 0;
+    for (uint64_t expected = 0; expected < SPSC_COUNT;) {
+        uint64_t value;
+        if (!spsc_queue_t_pop(&spsc_queue, &value)) {
+            thrd_yield();
+            continue;
+        }
+        if (value != expected && failures++ < 10) {
+            fprintf(stderr, "spsc: got %" PRIu64 ", expected %" PRIu64 "\n", value, expected);
+        }
+        expected++;
+    }
+    thrd_join(producer, NULL);
+
+    uint64_t value;
+    if (spsc_queue_t_pop(&spsc_queue, &value)) {
+        fputs("spsc: a value came out after the last one\n", stderr);
+        failures++;
+    }
+    spsc_queue_t_fini(&spsc_queue);
+    printf("spsc: %d values, %s\n", SPSC_COUNT, failures ? "FAILED" : "ok");
+    return failures != 0;
+}
+
+static int test_mpmc(void) {
+    const size_t value_count = (size_t)MPMC_PRODUCERS * MPMC_COUNT_PER_PRODUCER;
+    mpmc_seen = calloc(value_count, sizeof(*mpmc_seen));
+    if (!mpmc_seen) {
+        fputs("mpmc: out of memory\n", stderr);
+        return 1;
+    }
+    mpmc_queue_t_init(&mpmc_queue, QUEUE_CAPACITY);
+
+    thrd_t producers[MPMC_PRODUCERS], consumers[MPMC_CONSUMERS];
+    for (uintptr_t i = 0; i < MPMC_CONSUMERS; i++) {
+        if (thrd_create(consumers + i, mpmc_consume, NULL) != thrd_success) {
+            fputs("mpmc: thrd_create failed\n", stderr);
+            return 1;
+        }
+    }
+    for (uintptr_t i = 0; i < MPMC_PRODUCERS; i++) {
+        if (thrd_create(producers + i, mpmc_produce, (void*)i) != thrd_success) {
+            fputs("mpmc: thrd_create failed\n", stderr);
+            return 1;
+        }
+    }
+    for (unsigned i = 0; i < MPMC_PRODUCERS; i++) {
+        thrd_join(producers[i], NULL);
+    }
+    for (unsigned i = 0; i < MPMC_CONSUMERS; i++) {
+        thrd_join(consumers[i], NULL);
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < value_count; i++) {
+        if (atomic_load(mpmc_seen + i) != 1 && failures++ < 10) {
+            fprintf(stderr, "mpmc: value %zu came out %u times\n", i, (unsigned)atomic_load(mpmc_seen + i));
+        }
+    }
+    uint64_t value;
+    if (mpmc_queue_t_pop(&mpmc_queue, &value)) {
+        fputs("mpmc: a value came out after the last one\n", stderr);
+        failures++;
+    }
+    mpmc_queue_t_fini(&mpmc_queue);
+    free(mpmc_seen);
+    printf(
+        "mpmc: %d producers, %d consumers, %zu values, %s\n",
+        MPMC_PRODUCERS,
+        MPMC_CONSUMERS,
+        value_count,
+        failures ? "FAILED" : "ok");
+    return failures != 0;
+}
+
+int main(void) {
+    const int spsc_failed = test_spsc();
+    const int mpmc_failed = test_mpmc();
+    return spsc_failed || mpmc_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
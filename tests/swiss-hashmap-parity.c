@@ -0,0 +1,110 @@
+// Runs the same random sets, removes, clears and reserves on a swiss-hashmap and a hashmap, and checks after each step
+// that both hold the same entries. The keys come from a small range so that sets overwrite and removes hit, and both
+// maps go through many rehashes and tombstone buildups.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TDS_KEY_T uint32_t
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE hashmap_t
+#include <tds/hashmap.h>
+
+#define TDS_KEY_T uint32_t
+#define TDS_VALUE_T uint64_t
+#define TDS_TYPE swiss_hashmap_t
+#include <tds/swiss-hashmap.h>
+
+#define KEY_RANGE 4096
+#define STEP_COUNT 400000
+// Full comparisons walk both maps, so they only run every so often.
+#define COMPARE_INTERVAL 997
+
+static uint32_t random_state = 0x2545f491;
+
+static uint32_t random_u32(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static int failures;
+
+static void fail(const uint32_t step, const char* message, const uint32_t key) {
+    if (failures++ < 10) {
+        fprintf(stderr, "step %" PRIu32 ": %s (key %" PRIu32 ")\n", step, message, key);
+    }
+}
+
+// Checks that the swiss-hashmap iterates over every entry of the hashmap exactly once, with the same values.
+static void compare(const uint32_t step, const swiss_hashmap_t* swiss, const hashmap_t* reference) {
+    static unsigned char seen[KEY_RANGE];
+    memset(seen, 0, sizeof(seen));
+
+    uint32_t iterated = 0;
+    swiss_hashmap_t_iter_t it = swiss_hashmap_t_iter(swiss);
+    while (swiss_hashmap_t_next(&it)) {
+        iterated++;
+        if (it.key >= KEY_RANGE || seen[it.key]++) {
+            fail(step, "iteration returned a key twice or out of range", it.key);
+            continue;
+        }
+        const uint64_t* expected = hashmap_t_get(reference, it.key);
+        if (!expected) {
+            fail(step, "iteration returned a key the hashmap doesn't have", it.key);
+        } else if (*expected != *it.value) {
+            fail(step, "iteration returned a different value", it.key);
+        }
+    }
+
+    if (iterated != hashmap_t_count(reference) || swiss_hashmap_t_count(swiss) != hashmap_t_count(reference)) {
+        fail(step, "counts differ", 0);
+    }
+}
+
+int main(void) {
+    hashmap_t reference = { .allocator = NULL };
+    swiss_hashmap_t swiss = { .allocator = NULL };
+
+    for (uint32_t step = 0; step < STEP_COUNT; step++) {
+        const uint32_t operation = random_u32() % 10000, key = random_u32() % KEY_RANGE;
+        if (operation < 5500) {
+            const uint64_t value = (uint64_t)random_u32() << 32 | step;
+            swiss_hashmap_t_set(&swiss, key, value);
+            hashmap_t_set(&reference, key, value);
+        } else if (operation < 9500) {
+            swiss_hashmap_t_remove(&swiss, key);
+            hashmap_t_remove(&reference, key);
+        } else if (operation < 9998) {
+            // Reserving less than the count must be harmless, and more must keep every entry.
+            const uint32_t count = random_u32() % (2 * KEY_RANGE);
+            swiss_hashmap_t_reserve(&swiss, count);
+            hashmap_t_reserve(&reference, count);
+        } else {
+            swiss_hashmap_t_clear(&swiss);
+            hashmap_t_clear(&reference);
+        }
+
+        // Lookups of a random key, mostly misses when the maps are small and mostly hits when they are full.
+        const uint32_t lookup = random_u32() % KEY_RANGE;
+        const uint64_t* swiss_value = swiss_hashmap_t_get(&swiss, lookup);
+        const uint64_t* reference_value = hashmap_t_get(&reference, lookup);
+        if (!swiss_value != !reference_value || (swiss_value && *swiss_value != *reference_value)) {
+            fail(step, "lookups differ", lookup);
+        }
+
+        if (step % COMPARE_INTERVAL == 0) {
+            compare(step, &swiss, &reference);
+        }
+    }
+    compare(STEP_COUNT, &swiss, &reference);
+
+    swiss_hashmap_t_fini(&swiss);
+    hashmap_t_fini(&reference);
+    printf("swiss-hashmap: %d steps, %s\n", STEP_COUNT, failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}